@@ -4,6 +4,57 @@
 #include <execution>
 #include <chrono>
 #include <random>
+#include <numeric>
+#include <cmath>
+#include <string>
+#include <string_view>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <type_traits>
+#include <functional>
+#include <thread>
+#include <memory>
+#include <optional>
+#include <array>
+#include <span>
+#include <limits>
+#include <stdexcept>
+#include <mutex>
+#include <exception>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <atomic>
+#include <condition_variable>
+#include <iterator>
+#include <filesystem>
+#include <future>
+#include <bit>
+#include <ranges>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+// libstdc++ runs std::execution::par on TBB; global_control lets the sweep cap its thread count
+#if defined(__GLIBCXX__) && __has_include(<tbb/global_control.h>)
+#include <tbb/global_control.h>
+#define HAS_TBB_GLOBAL_CONTROL 1
+#endif
+// x86 SIMD intrinsics for the hand-written kernels; other targets only get the portable ones
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define HAS_X86_SIMD 1
+#include <immintrin.h>
+#if !defined(_MSC_VER)
+#include <cpuid.h>
+#endif
+#endif
 
  /*
     Description of all execution policies:
@@ -42,130 +93,5039 @@
 
 */
 
-int main() {
-    std::cout << "Hello, Parallel Algorithms!" << std::endl;
+/*
+    Benchmark harness
+
+    Timing an operation once with a pair of steady_clock::now() calls gives a number that
+    changes from run to run: the first call pays for page faults and cold caches, the timer
+    resolution is close to the cost of cheap operations, and the optimizer is free to drop
+    work whose result is never used. bench::Runner measures an operation the following way:
+
+    - warm-up: the operation runs repeatedly for Options::warmup before anything is recorded.
+      The warm-up calls also give an estimate of the cost of one call.
+    - iteration count: from that estimate the runner picks how many calls make up one sample,
+      so that every sample lasts at least Options::min_sample_time.
+    - samples: samples are collected until both Options::min_samples and Options::max_time
+      are reached (or Options::max_samples is hit). Each sample is divided by its iteration
+      count to get the time per call.
+    - statistics: min, mean, standard deviation, median, p90, p99 and max per call, plus a
+      95% confidence interval of the median taken from the order statistics of the samples
+      (no normality assumption, which matters because timings are skewed to the right).
+
+    An operation that modifies its input (sort, for_each, ...) takes a setup callback which
+    runs before every call outside of the timed region. bench::do_not_optimize() keeps
+    results alive so the compiler cannot remove the work being measured.
+
+    Runner::set_bytes_per_call() tells the runner how many bytes of memory one call reads and
+    writes; the results that follow then also show GB/s, and once a peak bandwidth is known
+    (Runner::set_peak_bandwidth, measured by the stream suite or --roofline) the percentage
+    of it they reach. An operation at a large share of the peak will not get faster with
+    more threads.
+
+    Results are printed as they are produced and can also be written as CSV or JSON:
+
+        ParallelAlgorithms_cpp20 --csv=results.csv --json=results.json
+        ParallelAlgorithms_cpp20 --quick      (shorter warm-up and time budget)
+        ParallelAlgorithms_cpp20 sweep        (run only the named suites; --help lists them)
+*/
+namespace bench {
+
+// Optimization barrier: forces 'value' to be materialized and tells the compiler that
+// memory may have been read, so the computation producing it cannot be elided.
+#if defined(_MSC_VER) && !defined(__clang__)
+inline const volatile void* g_sink = nullptr;
+
+template <class T>
+inline void do_not_optimize(T const& value) {
+    g_sink = &value;
+    _ReadWriteBarrier();
+}
+inline void clobber_memory() { _ReadWriteBarrier(); }
+#else
+template <class T>
+inline void do_not_optimize(T const& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+inline void clobber_memory() { asm volatile("" : : : "memory"); }
+#endif
+
+using clock = std::chrono::steady_clock;
+
+struct Options {
+    std::chrono::nanoseconds warmup = std::chrono::milliseconds(100);
+    std::chrono::nanoseconds min_sample_time = std::chrono::milliseconds(2);
+    std::chrono::nanoseconds max_time = std::chrono::milliseconds(500);
+    std::size_t min_samples = 10;
+    std::size_t max_samples = 200;
+    bool verbose = true;  // print every result as it is produced
+};
+
+// All times are in nanoseconds per call.
+struct Stats {
+    std::size_t samples = 0;
+    std::size_t iterations = 0;  // calls per sample
+    double min = 0, mean = 0, stddev = 0, median = 0, p90 = 0, p99 = 0, max = 0;
+    double median_ci_low = 0, median_ci_high = 0;
+};
+
+struct Result {
+    std::string name;
+    std::string variant;
+    std::size_t size = 0;
+    unsigned threads = 1;
+    Stats stats;
+    std::size_t bytes = 0;  // memory traffic per call, 0 when not given
+
+    double gb_per_s() const { return bytes && stats.median > 0 ? static_cast<double>(bytes) / stats.median : 0.0; }
+};
+
+// Percentile of sorted data with linear interpolation between the closest ranks.
+inline double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    double rank = p * static_cast<double>(sorted.size() - 1);
+    auto lo = static_cast<std::size_t>(rank);
+    auto hi = std::min(lo + 1, sorted.size() - 1);
+    return sorted[lo] + (sorted[hi] - sorted[lo]) * (rank - static_cast<double>(lo));
+}
+
+inline Stats summarize(std::vector<double> per_call_ns, std::size_t iterations) {
+    Stats s;
+    s.samples = per_call_ns.size();
+    s.iterations = iterations;
+    if (per_call_ns.empty()) return s;
+
+    std::sort(per_call_ns.begin(), per_call_ns.end());
+    const double n = static_cast<double>(per_call_ns.size());
+    s.min = per_call_ns.front();
+    s.max = per_call_ns.back();
+    s.mean = std::accumulate(per_call_ns.begin(), per_call_ns.end(), 0.0) / n;
+    double sq = 0.0;
+    for (double x : per_call_ns) sq += (x - s.mean) * (x - s.mean);
+    s.stddev = per_call_ns.size() > 1 ? std::sqrt(sq / (n - 1.0)) : 0.0;
+    s.median = percentile(per_call_ns, 0.50);
+    s.p90 = percentile(per_call_ns, 0.90);
+    s.p99 = percentile(per_call_ns, 0.99);
+
+    // 95% CI of the median: ranks n/2 -+ 1.96*sqrt(n)/2 of the sorted samples.
+    const double half_width = 1.96 * std::sqrt(n) / 2.0;
+    auto lo = static_cast<std::ptrdiff_t>(std::floor(n / 2.0 - half_width));
+    auto hi = static_cast<std::ptrdiff_t>(std::ceil(n / 2.0 + half_width));
+    lo = std::clamp<std::ptrdiff_t>(lo, 0, static_cast<std::ptrdiff_t>(per_call_ns.size()) - 1);
+    hi = std::clamp<std::ptrdiff_t>(hi, 0, static_cast<std::ptrdiff_t>(per_call_ns.size()) - 1);
+    s.median_ci_low = per_call_ns[static_cast<std::size_t>(lo)];
+    s.median_ci_high = per_call_ns[static_cast<std::size_t>(hi)];
+    return s;
+}
+
+inline std::string format_ns(double ns) {
+    std::ostringstream os;
+    os << std::fixed << std::setprecision(2);
+    if (ns < 1e3) os << ns << " ns";
+    else if (ns < 1e6) os << ns / 1e3 << " us";
+    else if (ns < 1e9) os << ns / 1e6 << " ms";
+    else os << ns / 1e9 << " s";
+    return os.str();
+}
+
+// "12.34 GB/s" and, with a known peak, " (56% of peak)".
+inline std::string format_bandwidth(double gb_per_s, double peak_gb_per_s) {
+    std::ostringstream os;
+    os << std::fixed << std::setprecision(2) << gb_per_s << " GB/s";
+    if (peak_gb_per_s > 0) os << std::setprecision(0) << " (" << gb_per_s / peak_gb_per_s * 100.0 << "% of peak)";
+    return os.str();
+}
+
+inline void print(const Result& r, double peak_gb_per_s = 0) {
+    const Stats& s = r.stats;
+    std::cout << std::left << std::setw(48) << (r.name + " [" + r.variant + "]") << std::right
+              << " median " << std::setw(10) << format_ns(s.median)
+              << "  95% CI [" << format_ns(s.median_ci_low) << ", " << format_ns(s.median_ci_high) << "]"
+              << "  p90 " << format_ns(s.p90)
+              << "  p99 " << format_ns(s.p99)
+              << "  (" << s.samples << " x " << s.iterations << ")";
+    if (r.bytes) std::cout << "  " << format_bandwidth(r.gb_per_s(), peak_gb_per_s);
+    std::cout << std::endl;
+}
+
+// Marker for benchmarks that need no per-call setup.
+struct NoSetup {
+    void operator()() const {}
+};
+
+class Runner {
+public:
+    explicit Runner(Options options = {}) : opts(options) {}
+
+    const Options& options() const { return opts; }
+    void set_options(const Options& options) { opts = options; }
+    const std::vector<Result>& results() const { return all; }
+
+    // Bytes read and written by one call of the operations run from now on (0: unknown).
+    void set_bytes_per_call(std::size_t bytes) { bytes_per_call = bytes; }
+    // Measured peak memory bandwidth that GB/s figures are compared against.
+    void set_peak_bandwidth(double gb_per_s) { peak = gb_per_s; }
+    double peak_bandwidth() const { return peak; }
+
+    template <class Fn>
+    Result& run(std::string name, std::string variant, std::size_t size, Fn&& fn) {
+        return run(std::move(name), std::move(variant), size, NoSetup{}, std::forward<Fn>(fn));
+    }
+
+    // 'setup' runs before every call to 'fn' and is never timed.
+    template <class Setup, class Fn>
+    Result& run(std::string name, std::string variant, std::size_t size, Setup&& setup, Fn&& fn) {
+        constexpr bool has_setup = !std::is_same_v<std::decay_t<Setup>, NoSetup>;
+
+        // Time 'iters' calls. Without setup the whole batch is timed at once so the
+        // clock overhead is amortized; with setup every call is timed on its own.
+        auto time_batch = [&](std::size_t iters) {
+            if constexpr (has_setup) {
+                clock::duration total{};
+                for (std::size_t i = 0; i < iters; ++i) {
+                    setup();
+                    clobber_memory();
+                    auto t0 = clock::now();
+                    fn();
+                    clobber_memory();
+                    total += clock::now() - t0;
+                }
+                return total;
+            } else {
+                auto t0 = clock::now();
+                for (std::size_t i = 0; i < iters; ++i) {
+                    fn();
+                    clobber_memory();
+                }
+                return clock::now() - t0;
+            }
+        };
+
+        // Warm-up, which doubles as the estimate of the cost of one call.
+        clock::duration warm_total{};
+        std::size_t warm_calls = 0;
+        const auto warm_start = clock::now();
+        do {
+            warm_total += time_batch(1);
+            ++warm_calls;
+        } while (clock::now() - warm_start < opts.warmup);
+
+        const double per_call = std::max(1.0, static_cast<double>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(warm_total).count()) / static_cast<double>(warm_calls));
+        const auto iters = static_cast<std::size_t>(
+            std::max(1.0, std::ceil(static_cast<double>(opts.min_sample_time.count()) / per_call)));
+
+        std::vector<double> per_call_ns;
+        const auto start = clock::now();
+        while (per_call_ns.size() < opts.max_samples) {
+            auto d = std::chrono::duration_cast<std::chrono::nanoseconds>(time_batch(iters));
+            per_call_ns.push_back(static_cast<double>(d.count()) / static_cast<double>(iters));
+            if (per_call_ns.size() >= opts.min_samples && clock::now() - start >= opts.max_time) break;
+        }
+
+        all.push_back(Result{std::move(name), std::move(variant), size, 1, summarize(std::move(per_call_ns), iters), bytes_per_call});
+        if (opts.verbose) print(all.back(), peak);
+        return all.back();
+    }
+
+    // Adds a result timed by the caller, for operations too slow to repeat (per_call_ns: one
+    // entry per call).
+    Result& record(std::string name, std::string variant, std::size_t size, std::vector<double> per_call_ns) {
+        all.push_back(Result{std::move(name), std::move(variant), size, 1, summarize(std::move(per_call_ns), 1), bytes_per_call});
+        if (opts.verbose) print(all.back(), peak);
+        return all.back();
+    }
+
+    void write_csv(std::ostream& os) const {
+        os << std::setprecision(10);
+        os << "name,variant,size,threads,samples,iterations,min_ns,mean_ns,stddev_ns,median_ns,"
+              "median_ci_low_ns,median_ci_high_ns,p90_ns,p99_ns,max_ns,bytes,gb_per_s\n";
+        for (const auto& r : all) {
+            const Stats& s = r.stats;
+            os << '"' << r.name << "\",\"" << r.variant << "\"," << r.size << ',' << r.threads << ',' << s.samples << ','
+               << s.iterations << ',' << s.min << ',' << s.mean << ',' << s.stddev << ',' << s.median << ','
+               << s.median_ci_low << ',' << s.median_ci_high << ',' << s.p90 << ',' << s.p99 << ',' << s.max << ','
+               << r.bytes << ',' << r.gb_per_s() << '\n';
+        }
+    }
+
+    void write_json(std::ostream& os) const {
+        os << std::setprecision(10);
+        os << "[\n";
+        for (std::size_t i = 0; i < all.size(); ++i) {
+            const Result& r = all[i];
+            const Stats& s = r.stats;
+            os << "  {\"name\": \"" << r.name << "\", \"variant\": \"" << r.variant << "\", \"size\": " << r.size << ", \"threads\": " << r.threads
+               << ", \"samples\": " << s.samples << ", \"iterations\": " << s.iterations
+               << ", \"min_ns\": " << s.min << ", \"mean_ns\": " << s.mean << ", \"stddev_ns\": " << s.stddev
+               << ", \"median_ns\": " << s.median << ", \"median_ci_low_ns\": " << s.median_ci_low
+               << ", \"median_ci_high_ns\": " << s.median_ci_high << ", \"p90_ns\": " << s.p90
+               << ", \"p99_ns\": " << s.p99 << ", \"max_ns\": " << s.max
+               << ", \"bytes\": " << r.bytes << ", \"gb_per_s\": " << r.gb_per_s() << "}"
+               << (i + 1 < all.size() ? ",\n" : "\n");
+        }
+        os << "]\n";
+    }
+
+private:
+    Options opts;
+    std::vector<Result> all;
+    std::size_t bytes_per_call = 0;
+    double peak = 0;
+};
+
+// Runs the sequential form of one algorithm, the std::execution::par form and the form on
+// our own thread pool (exec::pool_policy), and prints the speedups over seq, comparing medians.
+template <class Setup, class SeqFn, class ParFn, class PoolFn>
+void compare(Runner& runner, const std::string& name, std::size_t size, Setup setup, SeqFn seq, ParFn par, PoolFn pool) {
+    const unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    double seq_ns = runner.run(name, "seq", size, setup, seq).stats.median;
+    Result& par_result = runner.run(name, "par", size, setup, par);
+    par_result.threads = threads;
+    double par_ns = par_result.stats.median;
+    Result& pool_result = runner.run(name, "pool", size, setup, pool);
+    pool_result.threads = threads;
+    double pool_ns = pool_result.stats.median;
+    std::ostringstream speedup;
+    speedup << std::fixed << std::setprecision(2) << "par " << seq_ns / par_ns << "x, pool " << seq_ns / pool_ns << "x";
+    std::cout << "  -> parallel speedup: " << speedup.str() << std::endl;
+}
+
+template <class SeqFn, class ParFn, class PoolFn>
+void compare(Runner& runner, const std::string& name, std::size_t size, SeqFn seq, ParFn par, PoolFn pool) {
+    compare(runner, name, size, NoSetup{}, seq, par, pool);
+}
+
+} // namespace bench
+
+// Runs fn(chunk, begin, end) on std::execution::par for 'chunks' contiguous pieces of [0, n).
+// The split only depends on n and chunks, so two calls with the same arguments see the same pieces.
+// An exception escaping a parallel algorithm calls std::terminate, so the first exception
+// thrown by fn is captured and rethrown on the calling thread once all chunks are done.
+template <class Fn>
+void for_each_chunk(std::size_t n, std::size_t chunks, Fn fn) {
+    if (chunks <= 1) {
+        fn(std::size_t{0}, std::size_t{0}, n);
+        return;
+    }
+    std::vector<std::size_t> ids(chunks);
+    std::iota(ids.begin(), ids.end(), std::size_t{0});
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    std::for_each(std::execution::par, ids.begin(), ids.end(), [&](std::size_t c) {
+        try {
+            fn(c, n * c / chunks, n * (c + 1) / chunks);
+        } catch (...) {
+            std::lock_guard lock(error_mutex);
+            if (!error) error = std::current_exception();
+        }
+    });
+    if (error) std::rethrow_exception(error);
+}
+
+// Number of chunks worth splitting n elements into: one per hardware thread, but never
+// less than 'grain' elements per chunk.
+inline std::size_t default_chunks(std::size_t n, std::size_t grain = 1 << 16) {
+    const std::size_t hw = std::max(1u, std::thread::hardware_concurrency());
+    return std::clamp<std::size_t>(n / grain, 1, hw);
+}
+
+/*
+    Radix sort
+
+    std::sort compares keys; for integer keys a radix sort instead distributes them by one
+    digit at a time, which is O(n * passes) with no data-dependent branches.
+
+    - LSD (least significant digit first): one stable counting-sort pass per digit. Every pass
+      is parallel: each chunk of the input builds its own histogram (no sharing between
+      threads), the histograms are prefix-summed digit by digit and chunk by chunk into
+      private write offsets, and each chunk scatters its elements to those offsets. Because
+      chunk c writes its elements of digit d right after chunk c-1's, the pass is stable.
+      A pass is skipped when all keys share the digit, which is common for skewed or
+      small-range keys.
+    - MSD (most significant digit first): one parallel pass on the top varying digit splits
+      the input into independent buckets; each bucket is then LSD-sorted on the remaining
+      digits. Small buckets are sorted concurrently one per task, while buckets larger than
+      a chunk are sorted with the parallel LSD passes so a skewed input cannot leave a single
+      thread with most of the work.
+
+    The digit is 8 bits by default: the 256 counters of a chunk fit in 2 KB of L1 and the
+    scatter writes to 256 output streams, which the write-combining buffers and TLB keep up
+    with. Wider digits save passes (11 bits sorts 32-bit keys in 3 passes instead of 4) but
+    the histogram and the scatter streams spill out of L1.
+
+    Keys are extracted with a key function that returns an unsigned integer; signed integers
+    have their sign bit flipped so they order correctly as unsigned.
+*/
+namespace radix {
+
+template <class T>
+constexpr auto to_unsigned_key(T v) {
+    using U = std::make_unsigned_t<T>;
+    if constexpr (std::is_signed_v<T>)
+        return static_cast<U>(static_cast<U>(v) ^ (U{1} << (sizeof(T) * 8 - 1)));
+    else
+        return static_cast<U>(v);
+}
+
+struct IdentityKey {
+    template <class T>
+    constexpr auto operator()(const T& v) const { return to_unsigned_key(v); }
+};
+
+template <unsigned Bits>
+struct alignas(64) Histogram {
+    std::array<std::size_t, std::size_t{1} << Bits> count;
+};
+
+// One stable counting-sort pass on the digit at 'shift', from src to dst.
+// Returns false without touching dst when all keys share that digit.
+template <unsigned Bits, class T, class Key>
+bool pass(const T* src, T* dst, std::size_t n, unsigned shift, Key key, std::size_t chunks,
+          std::array<std::size_t, std::size_t{1} << Bits>* bucket_sizes = nullptr) {
+    constexpr std::size_t buckets = std::size_t{1} << Bits;
+    constexpr std::size_t mask = buckets - 1;
+    std::vector<Histogram<Bits>> hist(chunks);
+
+    for_each_chunk(n, chunks, [&](std::size_t c, std::size_t b, std::size_t e) {
+        auto& h = hist[c].count;
+        h.fill(0);
+        for (std::size_t i = b; i < e; ++i) ++h[(key(src[i]) >> shift) & mask];
+    });
+
+    std::array<std::size_t, buckets> totals{};
+    for (const auto& h : hist)
+        for (std::size_t d = 0; d < buckets; ++d) totals[d] += h.count[d];
+    if (bucket_sizes) *bucket_sizes = totals;
+    if (std::find(totals.begin(), totals.end(), n) != totals.end()) return false;
+
+    // exclusive prefix sum, digit-major then chunk-minor, turns counts into write offsets
+    std::size_t offset = 0;
+    for (std::size_t d = 0; d < buckets; ++d) {
+        for (auto& h : hist) {
+            std::size_t count = h.count[d];
+            h.count[d] = offset;
+            offset += count;
+        }
+    }
+
+    for_each_chunk(n, chunks, [&](std::size_t c, std::size_t b, std::size_t e) {
+        auto& out = hist[c].count;
+        for (std::size_t i = b; i < e; ++i) dst[out[(key(src[i]) >> shift) & mask]++] = src[i];
+    });
+    return true;
+}
+
+template <class T, class Key>
+constexpr unsigned key_bits() {
+    return sizeof(std::invoke_result_t<Key, const T&>) * 8;
+}
+
+// LSD passes over the digits below 'end_shift'. src and dst are equally sized ranges; the
+// sorted result ends up in src.
+template <unsigned Bits, class T, class Key>
+void lsd_passes(T* src, T* dst, std::size_t n, unsigned end_shift, Key key, std::size_t chunks) {
+    T* const home = src;
+    for (unsigned shift = 0; shift < end_shift; shift += Bits)
+        if (pass<Bits>(src, dst, n, shift, key, chunks)) std::swap(src, dst);
+    if (src != home) std::copy(src, src + n, home);
+}
+
+template <unsigned Bits = 8, class T, class Key = IdentityKey>
+void lsd_sort(std::span<T> data, Key key = {}) {
+    std::vector<T> buffer(data.size());
+    lsd_passes<Bits>(data.data(), buffer.data(), data.size(), key_bits<T, Key>(), key, default_chunks(data.size()));
+}
+
+template <unsigned Bits = 8, class T, class Key = IdentityKey>
+void msd_sort(std::span<T> data, Key key = {}) {
+    constexpr std::size_t buckets = std::size_t{1} << Bits;
+    const std::size_t n = data.size();
+    const std::size_t chunks = default_chunks(n);
+    std::vector<T> buffer(n);
+
+    // find the highest digit that is not the same for every key and split on it
+    std::array<std::size_t, buckets> sizes{};
+    unsigned shift = key_bits<T, Key>();
+    bool split = false;
+    while (shift > 0 && !split) {
+        shift = shift > Bits ? shift - Bits : 0;
+        split = pass<Bits>(data.data(), buffer.data(), n, shift, key, chunks, &sizes);
+    }
+    if (!split) return;  // all keys are equal
+
+    std::array<std::size_t, buckets + 1> start{};
+    std::partial_sum(sizes.begin(), sizes.end(), start.begin() + 1);
+
+    // every bucket is sorted on the lower digits in the buffer, then copied back into data
+    auto sort_bucket = [&](std::size_t d, std::size_t bucket_chunks) {
+        const std::size_t b = start[d], len = sizes[d];
+        if (len == 0) return;
+        if (len <= 64) {
+            std::stable_sort(buffer.begin() + b, buffer.begin() + b + len,
+                             [&](const T& x, const T& y) { return key(x) < key(y); });
+        } else {
+            lsd_passes<Bits>(buffer.data() + b, data.data() + b, len, shift, key, bucket_chunks);
+        }
+        std::copy(buffer.begin() + b, buffer.begin() + b + len, data.begin() + b);
+    };
+
+    const std::size_t large = std::max<std::size_t>(n / chunks, 1 << 16);
+    std::vector<std::size_t> small;
+    for (std::size_t d = 0; d < buckets; ++d) {
+        if (sizes[d] > large) sort_bucket(d, default_chunks(sizes[d]));
+        else small.push_back(d);
+    }
+    std::for_each(std::execution::par, small.begin(), small.end(), [&](std::size_t d) { sort_bucket(d, 1); });
+}
+
+} // namespace radix
+
+struct KeyValue {
+    std::uint64_t key;
+    std::uint32_t value;
+    bool operator==(const KeyValue&) const = default;
+};
+
+/*
+    Benchmark inputs
+
+    Shuffled iota is the friendliest input there is: no duplicates, no order. The inputs
+    below cover what real data looks like and where algorithms behave differently:
+
+    - uniform:        values from the full range of the type, in random order
+    - sorted, reverse sorted
+    - almost sorted:  sorted, then 1% of the elements swapped with random partners
+    - sawtooth:       16 ascending runs one after the other
+    - organ pipe:     the first half ascending, the second half descending
+    - few unique:     16 distinct values
+    - zipf:           ranks 1..2^20 drawn with probability proportional to 1 / rank, so rank 1
+                      makes up about 7% of the input and most values are duplicates
+    - normal:         around 1e6 with standard deviation 1e5
+    - skewed:         exponentially distributed around 1000, so most keys share their high digits
+
+    make_input<T>(n, distribution, seed) produces them for int32, uint64, double, std::string
+    (16 hex digits, so ordered like the numbers they print) and KeyValue (64-bit key; the
+    value is the position in the input, which makes the stability of a sort checkable).
+    The value distributions are drawn first, as numbers or random bits converted to T, and
+    the orders are then given by sorting parts of the input with InputLess, so they hold in
+    the order of T itself. The same seed always gives the same input.
+*/
+enum class Distribution { uniform, sorted, reverse_sorted, almost_sorted, sawtooth, organ_pipe, few_unique, zipf, normal, skewed };
+
+inline constexpr std::array all_distributions{
+    Distribution::uniform,  Distribution::sorted,     Distribution::reverse_sorted, Distribution::almost_sorted,
+    Distribution::sawtooth, Distribution::organ_pipe, Distribution::few_unique,     Distribution::zipf,
+    Distribution::normal,   Distribution::skewed};
+
+const char* to_string(Distribution d) {
+    switch (d) {
+    case Distribution::uniform: return "uniform";
+    case Distribution::sorted: return "sorted";
+    case Distribution::reverse_sorted: return "reverse sorted";
+    case Distribution::almost_sorted: return "almost sorted";
+    case Distribution::sawtooth: return "sawtooth";
+    case Distribution::organ_pipe: return "organ pipe";
+    case Distribution::few_unique: return "few unique";
+    case Distribution::zipf: return "zipf";
+    case Distribution::normal: return "normal";
+    case Distribution::skewed: return "skewed";
+    }
+    return "?";
+}
+
+// Order of the benchmark inputs: KeyValue by key, everything else by operator<.
+struct InputLess {
+    template <class T>
+    bool operator()(const T& a, const T& b) const {
+        if constexpr (std::is_same_v<T, KeyValue>) return a.key < b.key;
+        else return a < b;
+    }
+};
+
+// T from 64 random bits, covering the range of T.
+template <class T>
+T input_from_bits(std::uint64_t bits) {
+    if constexpr (std::is_same_v<T, KeyValue>) {
+        return {bits, 0};
+    } else if constexpr (std::is_same_v<T, std::string>) {
+        std::string s(16, '0');
+        for (int i = 15; i >= 0; --i, bits >>= 4) s[static_cast<std::size_t>(i)] = "0123456789abcdef"[bits & 15];
+        return s;
+    } else if constexpr (std::is_floating_point_v<T>) {
+        return static_cast<T>(static_cast<double>(bits >> 11) * 0x1p-53);  // [0, 1)
+    } else {
+        return static_cast<T>(bits >> (64 - 8 * sizeof(T)));
+    }
+}
+
+// T from a non-negative number: truncated for integers, as the number for strings.
+template <class T>
+T input_from_number(double x) {
+    if constexpr (std::is_same_v<T, KeyValue> || std::is_same_v<T, std::string>) return input_from_bits<T>(static_cast<std::uint64_t>(x));
+    else return static_cast<T>(x);
+}
+
+template <class T>
+std::vector<T> make_input(std::size_t n, Distribution d, std::uint64_t seed) {
+    std::mt19937_64 rng{seed};
+    std::vector<T> v(n);
+
+    // values
+    switch (d) {
+    case Distribution::few_unique: {
+        std::array<T, 16> values;
+        for (auto& x : values) x = input_from_bits<T>(rng());
+        for (auto& x : v) x = values[rng() % values.size()];
+        break;
+    }
+    case Distribution::zipf: {
+        constexpr std::size_t ranks = std::size_t{1} << 20;
+        std::vector<double> cdf(ranks);
+        double sum = 0;
+        for (std::size_t r = 0; r < ranks; ++r) cdf[r] = sum += 1.0 / static_cast<double>(r + 1);
+        std::uniform_real_distribution<double> u{0.0, sum};
+        for (auto& x : v) {
+            const auto rank = static_cast<std::size_t>(std::lower_bound(cdf.begin(), cdf.end() - 1, u(rng)) - cdf.begin()) + 1;
+            x = input_from_number<T>(static_cast<double>(rank));
+        }
+        break;
+    }
+    case Distribution::normal: {
+        std::normal_distribution<double> normal{1e6, 1e5};
+        for (auto& x : v) x = input_from_number<T>(std::max(0.0, normal(rng)));
+        break;
+    }
+    case Distribution::skewed: {
+        std::exponential_distribution<double> exp{1.0 / 1000.0};
+        for (auto& x : v) x = input_from_number<T>(exp(rng));
+        break;
+    }
+    default:
+        for (auto& x : v) x = input_from_bits<T>(rng());
+        break;
+    }
+
+    // order
+    const InputLess less;
+    auto sort_part = [&](std::size_t b, std::size_t e, bool ascending) {
+        if (ascending) std::sort(v.begin() + static_cast<std::ptrdiff_t>(b), v.begin() + static_cast<std::ptrdiff_t>(e), less);
+        else std::sort(v.rbegin() + static_cast<std::ptrdiff_t>(n - e), v.rbegin() + static_cast<std::ptrdiff_t>(n - b), less);
+    };
+    switch (d) {
+    case Distribution::sorted: sort_part(0, n, true); break;
+    case Distribution::reverse_sorted: sort_part(0, n, false); break;
+    case Distribution::almost_sorted:
+        sort_part(0, n, true);
+        for (std::size_t i = 0; i < n / 100; ++i) std::swap(v[rng() % n], v[rng() % n]);
+        break;
+    case Distribution::sawtooth:
+        for (std::size_t r = 0; r < 16; ++r) sort_part(n * r / 16, n * (r + 1) / 16, true);
+        break;
+    case Distribution::organ_pipe:
+        sort_part(0, n / 2, true);
+        sort_part(n / 2, n, false);
+        break;
+    default: break;
+    }
+
+    if constexpr (std::is_same_v<T, KeyValue>)
+        for (std::size_t i = 0; i < n; ++i) v[i].value = static_cast<std::uint32_t>(i);
+    return v;
+}
+
+// Benchmarks std::sort, std::sort(par) and both radix sorts on one input, then checks that
+// the radix sorts agree with std::stable_sort (they are stable, so the match must be exact).
+template <class T, class Key>
+void benchmark_sorts(bench::Runner& runner, const std::string& label, const std::vector<T>& input, Key key) {
+    const std::size_t n = input.size();
+    auto less = [key](const T& a, const T& b) { return key(a) < key(b); };
+    std::vector<T> work(n);
+    auto reset = [&] { std::copy(input.begin(), input.end(), work.begin()); };
+
+    runner.run(label, "std::sort", n, reset, [&] { std::sort(work.begin(), work.end(), less); });
+    runner.run(label, "std::sort(par)", n, reset, [&] { std::sort(std::execution::par, work.begin(), work.end(), less); });
+    runner.run(label, "radix lsd", n, reset, [&] { radix::lsd_sort(std::span<T>{work}, key); });
+    runner.run(label, "radix msd", n, reset, [&] { radix::msd_sort(std::span<T>{work}, key); });
+
+    std::vector<T> expected = input;
+    std::stable_sort(expected.begin(), expected.end(), less);
+    reset();
+    radix::lsd_sort(std::span<T>{work}, key);
+    if (work != expected) throw std::runtime_error(label + ": radix lsd result differs from std::stable_sort");
+    reset();
+    radix::msd_sort(std::span<T>{work}, key);
+    if (work != expected) throw std::runtime_error(label + ": radix msd result differs from std::stable_sort");
+}
+
+void radix_sort_benchmark(bench::Runner& runner) {
+    std::cout << "\n[radix_sort_benchmark]" << std::endl;
+
+    constexpr std::size_t N = 1'000'000;
+    for (Distribution d : all_distributions) {
+        benchmark_sorts(runner, std::string{"sort int32 "} + to_string(d),
+                        make_input<std::int32_t>(N, d, 1), radix::IdentityKey{});
+        benchmark_sorts(runner, std::string{"sort uint64 "} + to_string(d),
+                        make_input<std::uint64_t>(N, d, 2), radix::IdentityKey{});
+        // key-value: 64-bit keys carrying their original position as payload
+        benchmark_sorts(runner, std::string{"sort key-value "} + to_string(d),
+                        make_input<KeyValue>(N, d, 3), [](const KeyValue& kv) { return kv.key; });
+    }
+}
+
+/*
+    Parallel prefix scan
+
+    std::transform_inclusive_scan accumulates in the type of its init value, and the demos
+    above used to pass an int: the plus scan of n * 2 over 1M elements passes INT_MAX after
+    about 46K elements and the product scan after a handful. The scans here take the
+    accumulator type from init as well, so passing a std::int64_t (or a double, ...) widens
+    the accumulation, and the binary operation can be one of the overflow-aware ones below:
+
+    - scan::saturating_plus / saturating_multiplies: clamp to the limits of the type.
+    - scan::checked_plus / checked_multiplies: throw std::overflow_error.
+
+    The algorithm is the blocked two-pass scan, which does O(n) work like the sequential
+    one (a tree-based scan does O(n log n)):
+
+    1. every chunk reduces its transformed elements to one partial sum,
+    2. the partial sums are scanned sequentially into each chunk's carry-in,
+    3. every chunk scans its elements again starting from its carry-in.
+
+    Segmented scans take a second range of head flags; a nonzero flag starts a new segment,
+    and the running value restarts from init there. Pass 1 then only reduces the elements
+    after the last head of the chunk, and a chunk that contains a head does not propagate
+    the carry of the chunks before it.
+
+    The binary operation has to be associative, as for std::inclusive_scan. The saturating
+    and checked operations are only associative when all operands have the same sign: with
+    mixed signs the chunked evaluation order can saturate, or detect an overflow, in a
+    partial sum that the sequential order would not have produced.
+*/
+namespace scan {
+
+template <class T>
+bool add_overflows(T a, T b) {
+    static_assert(std::is_integral_v<T>, "overflow checks are only defined for integers");
+    if constexpr (std::is_signed_v<T>)
+        return b > 0 ? a > std::numeric_limits<T>::max() - b : a < std::numeric_limits<T>::min() - b;
+    else
+        return a > std::numeric_limits<T>::max() - b;
+}
+
+template <class T>
+bool mul_overflows(T a, T b) {
+    static_assert(std::is_integral_v<T>, "overflow checks are only defined for integers");
+    constexpr T max = std::numeric_limits<T>::max();
+    constexpr T min = std::numeric_limits<T>::min();
+    if (a == 0 || b == 0) return false;
+    if constexpr (std::is_signed_v<T>) {
+        if (a > 0) return b > 0 ? a > max / b : b < min / a;
+        return b > 0 ? a < min / b : a < max / b;
+    } else {
+        return a > max / b;
+    }
+}
+
+template <class T>
+struct saturating_plus {
+    T operator()(T a, T b) const {
+        if (!add_overflows(a, b)) return static_cast<T>(a + b);
+        return b > 0 ? std::numeric_limits<T>::max() : std::numeric_limits<T>::min();
+    }
+};
+
+template <class T>
+struct saturating_multiplies {
+    T operator()(T a, T b) const {
+        if (!mul_overflows(a, b)) return static_cast<T>(a * b);
+        return (a < 0) != (b < 0) ? std::numeric_limits<T>::min() : std::numeric_limits<T>::max();
+    }
+};
+
+template <class T>
+struct checked_plus {
+    T operator()(T a, T b) const {
+        if (add_overflows(a, b)) throw std::overflow_error("scan: integer overflow in addition");
+        return static_cast<T>(a + b);
+    }
+};
+
+template <class T>
+struct checked_multiplies {
+    T operator()(T a, T b) const {
+        if (mul_overflows(a, b)) throw std::overflow_error("scan: integer overflow in multiplication");
+        return static_cast<T>(a * b);
+    }
+};
+
+namespace detail {
+
+// Chunk runner on std::execution::par; see exec::pool_policy for the one on our own pool.
+struct StdChunks {
+    template <class Fn>
+    void operator()(std::size_t n, std::size_t chunks, Fn fn) const { for_each_chunk(n, chunks, fn); }
+};
+
+// Sequential scan of one chunk. The iterators are taken by value so the loop keeps them in
+// registers instead of reloading them through the lambda captures after every store.
+template <bool Inclusive, bool Segmented, class InIt, class OutIt, class Acc, class BinaryOp, class UnaryOp>
+void scan_range(InIt first, std::size_t n, const std::uint8_t* heads, OutIt out, Acc running,
+                Acc init, BinaryOp op, UnaryOp f) {
+    for (std::size_t i = 0; i < n; ++i) {
+        if constexpr (Segmented) {
+            if (heads[i]) running = init;
+        }
+        if constexpr (Inclusive) {
+            running = op(running, static_cast<Acc>(f(first[i])));
+            out[i] = running;
+        } else {
+            out[i] = running;
+            running = op(running, static_cast<Acc>(f(first[i])));
+        }
+    }
+}
+
+// heads == nullptr: plain scan over [first, first + n). run_chunks(n, chunks, fn) runs the passes.
+template <bool Inclusive, class ForEachChunk, class InIt, class OutIt, class Acc, class BinaryOp, class UnaryOp>
+OutIt blocked_scan(ForEachChunk run_chunks, std::size_t chunks, InIt first, std::size_t n,
+                   const std::uint8_t* heads, OutIt out, Acc init, BinaryOp op, UnaryOp f) {
+    // pass 1: reduce each chunk (after its last head, for segmented scans)
+    std::vector<std::optional<Acc>> partial(chunks);
+    std::vector<std::uint8_t> has_head(chunks, 0);
+    if (chunks > 1) {
+        run_chunks(n, chunks, [&](std::size_t c, std::size_t b, std::size_t e) {
+            std::size_t start = b;
+            if (heads) {
+                for (std::size_t i = e; i-- > b;) {
+                    if (heads[i]) {
+                        start = i;
+                        has_head[c] = 1;
+                        break;
+                    }
+                }
+            }
+            if (start == e) return;
+            Acc sum = static_cast<Acc>(f(first[start]));
+            for (std::size_t i = start + 1; i < e; ++i) sum = op(sum, static_cast<Acc>(f(first[i])));
+            partial[c] = sum;
+        });
+    }
+
+    // carry-in of every chunk
+    std::vector<Acc> carry(chunks, init);
+    for (std::size_t c = 1; c < chunks; ++c) {
+        const Acc& before = has_head[c - 1] ? init : carry[c - 1];
+        carry[c] = partial[c - 1] ? op(before, *partial[c - 1]) : before;
+    }
+
+    // pass 2: scan each chunk from its carry-in
+    run_chunks(n, chunks, [&](std::size_t c, std::size_t b, std::size_t e) {
+        const auto offset = static_cast<std::ptrdiff_t>(b);
+        if (heads)
+            scan_range<Inclusive, true>(first + offset, e - b, heads + b, out + offset, carry[c], init, op, f);
+        else
+            scan_range<Inclusive, false>(first + offset, e - b, nullptr, out + offset, carry[c], init, op, f);
+    });
+    return out + static_cast<std::ptrdiff_t>(n);
+}
+
+} // namespace detail
+
+// Like std::transform_inclusive_scan(par, first, last, out, op, f, init).
+template <class InIt, class OutIt, class Acc, class BinaryOp = std::plus<>, class UnaryOp = std::identity>
+OutIt inclusive(InIt first, InIt last, OutIt out, Acc init, BinaryOp op = {}, UnaryOp f = {}) {
+    const auto n = static_cast<std::size_t>(last - first);
+    return detail::blocked_scan<true>(detail::StdChunks{}, default_chunks(n), first, n, nullptr, out, init, op, f);
+}
+
+// Like std::transform_exclusive_scan(par, first, last, out, init, op, f).
+template <class InIt, class OutIt, class Acc, class BinaryOp = std::plus<>, class UnaryOp = std::identity>
+OutIt exclusive(InIt first, InIt last, OutIt out, Acc init, BinaryOp op = {}, UnaryOp f = {}) {
+    const auto n = static_cast<std::size_t>(last - first);
+    return detail::blocked_scan<false>(detail::StdChunks{}, default_chunks(n), first, n, nullptr, out, init, op, f);
+}
+
+// Inclusive scan restarting from init at every element whose head flag is nonzero.
+template <class InIt, class OutIt, class Acc, class BinaryOp = std::plus<>, class UnaryOp = std::identity>
+OutIt segmented_inclusive(InIt first, InIt last, const std::uint8_t* heads, OutIt out, Acc init,
+                          BinaryOp op = {}, UnaryOp f = {}) {
+    const auto n = static_cast<std::size_t>(last - first);
+    return detail::blocked_scan<true>(detail::StdChunks{}, default_chunks(n), first, n, heads, out, init, op, f);
+}
+
+// Exclusive scan restarting from init at every element whose head flag is nonzero.
+template <class InIt, class OutIt, class Acc, class BinaryOp = std::plus<>, class UnaryOp = std::identity>
+OutIt segmented_exclusive(InIt first, InIt last, const std::uint8_t* heads, OutIt out, Acc init,
+                          BinaryOp op = {}, UnaryOp f = {}) {
+    const auto n = static_cast<std::size_t>(last - first);
+    return detail::blocked_scan<false>(detail::StdChunks{}, default_chunks(n), first, n, heads, out, init, op, f);
+}
+
+} // namespace scan
+
+void prefix_scan_benchmark(bench::Runner& runner) {
+    std::cout << "\n[prefix_scan_benchmark]" << std::endl;
+
+    constexpr std::size_t N = 1'000'000;
+    std::vector<int> vec(N);
+    std::iota(vec.begin(), vec.end(), 0);
+    std::shuffle(vec.begin(), vec.end(), std::mt19937{42});
+    auto twice = [](int n) { return n * 2; };
+
+    // what the int accumulator of the original demo produces (computed with unsigned
+    // wrap-around, since signed overflow is undefined), next to the exact value
+    std::vector<std::int64_t> wide(N), expected(N);
+    std::transform_inclusive_scan(vec.begin(), vec.end(), expected.begin(), std::plus<>(), twice, std::int64_t{0});
+    std::cout << "last element, int accumulator: " << static_cast<int>(std::accumulate(
+                     vec.begin(), vec.end(), 0u, [](unsigned a, int n) { return a + static_cast<unsigned>(n) * 2u; }))
+              << ", int64 accumulator: " << expected.back() << std::endl;
+
+    runner.run("inclusive scan int64", "std::transform_inclusive_scan(par)", N,
+        [&] { std::transform_inclusive_scan(std::execution::par, vec.begin(), vec.end(), wide.begin(), std::plus<>(), twice, std::int64_t{0}); });
+    runner.run("inclusive scan int64", "scan::inclusive", N,
+        [&] { scan::inclusive(vec.begin(), vec.end(), wide.begin(), std::int64_t{0}, std::plus<>(), twice); });
+    if (wide != expected) throw std::runtime_error("scan::inclusive result differs from std::transform_inclusive_scan");
+
+    runner.run("inclusive scan int64", "scan::inclusive checked_plus", N,
+        [&] { scan::inclusive(vec.begin(), vec.end(), wide.begin(), std::int64_t{0}, scan::checked_plus<std::int64_t>{}, twice); });
+    runner.run("inclusive scan int64", "scan::inclusive saturating_plus", N,
+        [&] { scan::inclusive(vec.begin(), vec.end(), wide.begin(), std::int64_t{0}, scan::saturating_plus<std::int64_t>{}, twice); });
+
+    runner.run("exclusive scan int64", "std::transform_exclusive_scan(par)", N,
+        [&] { std::transform_exclusive_scan(std::execution::par, vec.begin(), vec.end(), wide.begin(), std::int64_t{0}, std::plus<>(), twice); });
+    runner.run("exclusive scan int64", "scan::exclusive", N,
+        [&] { scan::exclusive(vec.begin(), vec.end(), wide.begin(), std::int64_t{0}, std::plus<>(), twice); });
+    std::transform_exclusive_scan(vec.begin(), vec.end(), expected.begin(), std::int64_t{0}, std::plus<>(), twice);
+    if (wide != expected) throw std::runtime_error("scan::exclusive result differs from std::transform_exclusive_scan");
+
+    // segments of 1000 elements
+    std::vector<std::uint8_t> heads(N, 0);
+    for (std::size_t i = 0; i < N; i += 1000) heads[i] = 1;
+    runner.run("segmented inclusive scan int64", "scan::segmented_inclusive", N,
+        [&] { scan::segmented_inclusive(vec.begin(), vec.end(), heads.data(), wide.begin(), std::int64_t{0}, std::plus<>(), twice); });
+    for (std::size_t i = 0; i < N; i += 1000)
+        std::transform_inclusive_scan(vec.begin() + i, vec.begin() + i + 1000, expected.begin() + i, std::plus<>(), twice, std::int64_t{0});
+    if (wide != expected) throw std::runtime_error("scan::segmented_inclusive result differs from per-segment scans");
+
+    // the product scan overflows 64 bits as well: saturate, or detect it
+    // (the std version runs on uint64, where the wrap-around is at least well defined)
+    std::vector<std::uint64_t> wrapped(N);
+    runner.run("inclusive scan product int64", "std::transform_inclusive_scan(par) uint64", N,
+        [&] { std::transform_inclusive_scan(std::execution::par, vec.begin(), vec.end(), wrapped.begin(), std::multiplies<>(),
+                                            [](int n) { return static_cast<std::uint64_t>(n) * 2 + 1; }, std::uint64_t{1}); });
+    runner.run("inclusive scan product int64", "scan::inclusive saturating_multiplies", N,
+        [&] { scan::inclusive(vec.begin(), vec.end(), wide.begin(), std::int64_t{1}, scan::saturating_multiplies<std::int64_t>{},
+                              [](int n) { return static_cast<std::int64_t>(n) * 2 + 1; }); });
+    std::cout << "saturated product, last element: " << wide.back() << std::endl;
+    try {
+        scan::inclusive(vec.begin(), vec.end(), wide.begin(), std::int64_t{1}, scan::checked_multiplies<std::int64_t>{},
+                        [](int n) { return static_cast<std::int64_t>(n) * 2 + 1; });
+        std::cout << "checked product: no overflow" << std::endl;
+    } catch (const std::overflow_error& e) {
+        std::cout << "checked product: " << e.what() << std::endl;
+    }
+}
+
+/*
+    SIMD kernels with runtime dispatch
+
+    std::reduce, std::count and std::find get whatever the compiler auto-vectorizes for the
+    instruction set the binary was built for, which is SSE2 for a default x86-64 build, and
+    std::find usually not at all (an early-exit loop does not vectorize). The kernels below
+    are written by hand for three instruction-set levels:
+
+    - SSE2    (128-bit, every x86-64 CPU)
+    - AVX2    (256-bit)
+    - AVX-512 (512-bit, AVX512F)
+
+    plus a portable baseline. Every level is compiled into the same binary (GCC and Clang
+    through target attributes, MSVC accepts the intrinsics anywhere) and simd::best() picks
+    the highest level the CPU and OS support, detected once with CPUID/XGETBV. Calling a
+    level that is not supported is an illegal instruction, so simd::kernels() refuses it.
+
+    Kernels for int32 and float: reduce (sum, accumulated in int64 / double lanes so it
+    cannot overflow and loses no precision on float inputs), count, find (index of the first
+    match, n when there is none), min, max and minmax. Float min/max assume the input has no
+    NaNs. Every kernel works on a plain pointer range, so it combines with the chunking of
+    for_each_chunk: simd::chunked_reduce() runs a kernel on every chunk in parallel and
+    combines the per-chunk results.
+*/
+#if defined(__GNUC__) || defined(__clang__)
+#define SIMD_TARGET(isa) __attribute__((target(isa)))
+#else
+#define SIMD_TARGET(isa)
+#endif
+
+namespace simd {
+
+enum class Isa { baseline, sse2, avx2, avx512 };
+
+inline const char* to_string(Isa isa) {
+    switch (isa) {
+    case Isa::baseline: return "baseline";
+    case Isa::sse2: return "sse2";
+    case Isa::avx2: return "avx2";
+    case Isa::avx512: return "avx512";
+    }
+    return "?";
+}
+
+// Portable kernels: plain loops, vectorized by the compiler as far as the build target allows.
+namespace baseline {
+
+inline std::int64_t reduce(const std::int32_t* p, std::size_t n) {
+    std::int64_t sum = 0;
+    for (std::size_t i = 0; i < n; ++i) sum += p[i];
+    return sum;
+}
+inline double reduce(const float* p, std::size_t n) {
+    double sum = 0;
+    for (std::size_t i = 0; i < n; ++i) sum += p[i];
+    return sum;
+}
+template <class T>
+std::size_t count(const T* p, std::size_t n, T value) {
+    std::size_t c = 0;
+    for (std::size_t i = 0; i < n; ++i) c += p[i] == value;
+    return c;
+}
+template <class T>
+std::size_t find(const T* p, std::size_t n, T value) {
+    for (std::size_t i = 0; i < n; ++i)
+        if (p[i] == value) return i;
+    return n;
+}
+template <bool Max, class T>
+T extreme(const T* p, std::size_t n) {
+    T m = Max ? std::numeric_limits<T>::lowest() : std::numeric_limits<T>::max();
+    for (std::size_t i = 0; i < n; ++i) m = Max ? std::max(m, p[i]) : std::min(m, p[i]);
+    return m;
+}
+template <class T>
+std::pair<T, T> minmax(const T* p, std::size_t n) {
+    return {extreme<false>(p, n), extreme<true>(p, n)};
+}
+
+} // namespace baseline
+
+#if HAS_X86_SIMD
+namespace sse2 {
+
+#define TARGET SIMD_TARGET("sse2")
+
+TARGET inline std::int64_t reduce(const std::int32_t* p, std::size_t n) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i acc0 = zero, acc1 = zero;
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        __m128i sign = _mm_cmpgt_epi32(zero, v);  // SSE2 has no cvtepi32_epi64: widen by hand
+        acc0 = _mm_add_epi64(acc0, _mm_unpacklo_epi32(v, sign));
+        acc1 = _mm_add_epi64(acc1, _mm_unpackhi_epi32(v, sign));
+    }
+    alignas(16) std::int64_t lanes[2];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes), _mm_add_epi64(acc0, acc1));
+    std::int64_t sum = lanes[0] + lanes[1];
+    for (; i < n; ++i) sum += p[i];
+    return sum;
+}
+
+TARGET inline double reduce(const float* p, std::size_t n) {
+    __m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 v = _mm_loadu_ps(p + i);
+        acc0 = _mm_add_pd(acc0, _mm_cvtps_pd(v));
+        acc1 = _mm_add_pd(acc1, _mm_cvtps_pd(_mm_movehl_ps(v, v)));
+    }
+    alignas(16) double lanes[2];
+    _mm_store_pd(lanes, _mm_add_pd(acc0, acc1));
+    double sum = lanes[0] + lanes[1];
+    for (; i < n; ++i) sum += p[i];
+    return sum;
+}
+
+TARGET inline __m128i equal(__m128i v, __m128i key) { return _mm_cmpeq_epi32(v, key); }
+TARGET inline __m128i equal(__m128 v, __m128 key) { return _mm_castps_si128(_mm_cmpeq_ps(v, key)); }
+TARGET inline __m128i load(const std::int32_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+TARGET inline __m128 load(const float* p) { return _mm_loadu_ps(p); }
+TARGET inline __m128i broadcast(std::int32_t v) { return _mm_set1_epi32(v); }
+TARGET inline __m128 broadcast(float v) { return _mm_set1_ps(v); }
+
+template <class T>
+TARGET std::size_t count(const T* p, std::size_t n, T value) {
+    const auto key = broadcast(value);
+    std::size_t c = 0, i = 0;
+    // a lane counts at most one match per step in 32 bits, so it is added up before 2^32 steps
+    while (i + 4 <= n) {
+        __m128i acc = _mm_setzero_si128();  // a match is all ones (-1), so subtracting counts it
+        const std::size_t end = i + 4 * std::min<std::size_t>((n - i) / 4, std::numeric_limits<std::uint32_t>::max());
+        for (; i < end; i += 4) acc = _mm_sub_epi32(acc, equal(load(p + i), key));
+        alignas(16) std::uint32_t lanes[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), acc);
+        c += std::size_t{lanes[0]} + lanes[1] + lanes[2] + lanes[3];
+    }
+    for (; i < n; ++i) c += p[i] == value;
+    return c;
+}
+
+template <class T>
+TARGET std::size_t find(const T* p, std::size_t n, T value) {
+    const auto key = broadcast(value);
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i any = _mm_or_si128(_mm_or_si128(equal(load(p + i), key), equal(load(p + i + 4), key)),
+                                   _mm_or_si128(equal(load(p + i + 8), key), equal(load(p + i + 12), key)));
+        if (_mm_movemask_epi8(any)) break;
+    }
+    for (; i < n; ++i)
+        if (p[i] == value) return i;
+    return n;
+}
+
+// SSE2 has min/max for floats but not for int32 (that is SSE4.1): select through a compare.
+template <bool Max>
+TARGET inline __m128i pick(__m128i a, __m128i b) {
+    __m128i a_greater = _mm_cmpgt_epi32(a, b);
+    return Max ? _mm_or_si128(_mm_and_si128(a_greater, a), _mm_andnot_si128(a_greater, b))
+               : _mm_or_si128(_mm_and_si128(a_greater, b), _mm_andnot_si128(a_greater, a));
+}
+template <bool Max>
+TARGET inline __m128 pick(__m128 a, __m128 b) { return Max ? _mm_max_ps(a, b) : _mm_min_ps(a, b); }
+TARGET inline void store(std::int32_t* out, __m128i v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(out), v); }
+TARGET inline void store(float* out, __m128 v) { _mm_storeu_ps(out, v); }
+
+template <bool Max, class T>
+TARGET T extreme(const T* p, std::size_t n) {
+    const T identity = Max ? std::numeric_limits<T>::lowest() : std::numeric_limits<T>::max();
+    auto m0 = broadcast(identity), m1 = m0;
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        m0 = pick<Max>(m0, load(p + i));
+        m1 = pick<Max>(m1, load(p + i + 4));
+    }
+    T lanes[4];
+    store(lanes, pick<Max>(m0, m1));
+    T m = baseline::extreme<Max>(lanes, 4);
+    for (; i < n; ++i) m = Max ? std::max(m, p[i]) : std::min(m, p[i]);
+    return m;
+}
+
+template <class T>
+TARGET std::pair<T, T> minmax(const T* p, std::size_t n) {
+    auto lo = broadcast(std::numeric_limits<T>::max());
+    auto hi = broadcast(std::numeric_limits<T>::lowest());
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        auto v = load(p + i);
+        lo = pick<false>(lo, v);
+        hi = pick<true>(hi, v);
+    }
+    T lo_lanes[4], hi_lanes[4];
+    store(lo_lanes, lo);
+    store(hi_lanes, hi);
+    T mn = baseline::extreme<false>(lo_lanes, 4), mx = baseline::extreme<true>(hi_lanes, 4);
+    for (; i < n; ++i) {
+        mn = std::min(mn, p[i]);
+        mx = std::max(mx, p[i]);
+    }
+    return {mn, mx};
+}
+
+#undef TARGET
+} // namespace sse2
+
+namespace avx2 {
+
+#define TARGET SIMD_TARGET("avx2")
+
+TARGET inline std::int64_t reduce(const std::int32_t* p, std::size_t n) {
+    __m256i acc0 = _mm256_setzero_si256(), acc1 = acc0;
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+        acc0 = _mm256_add_epi64(acc0, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(v)));
+        acc1 = _mm256_add_epi64(acc1, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(v, 1)));
+    }
+    alignas(32) std::int64_t lanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), _mm256_add_epi64(acc0, acc1));
+    std::int64_t sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    for (; i < n; ++i) sum += p[i];
+    return sum;
+}
+
+TARGET inline double reduce(const float* p, std::size_t n) {
+    __m256d acc0 = _mm256_setzero_pd(), acc1 = acc0;
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 v = _mm256_loadu_ps(p + i);
+        acc0 = _mm256_add_pd(acc0, _mm256_cvtps_pd(_mm256_castps256_ps128(v)));
+        acc1 = _mm256_add_pd(acc1, _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1)));
+    }
+    alignas(32) double lanes[4];
+    _mm256_store_pd(lanes, _mm256_add_pd(acc0, acc1));
+    double sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    for (; i < n; ++i) sum += p[i];
+    return sum;
+}
+
+TARGET inline __m256i equal(__m256i v, __m256i key) { return _mm256_cmpeq_epi32(v, key); }
+TARGET inline __m256i equal(__m256 v, __m256 key) { return _mm256_castps_si256(_mm256_cmp_ps(v, key, _CMP_EQ_OQ)); }
+TARGET inline __m256i load(const std::int32_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+TARGET inline __m256 load(const float* p) { return _mm256_loadu_ps(p); }
+TARGET inline __m256i broadcast(std::int32_t v) { return _mm256_set1_epi32(v); }
+TARGET inline __m256 broadcast(float v) { return _mm256_set1_ps(v); }
+
+template <class T>
+TARGET std::size_t count(const T* p, std::size_t n, T value) {
+    const auto key = broadcast(value);
+    std::size_t c = 0, i = 0;
+    // 32-bit lanes, added up before 2^32 steps as in the SSE2 version
+    while (i + 8 <= n) {
+        __m256i acc = _mm256_setzero_si256();
+        const std::size_t end = i + 8 * std::min<std::size_t>((n - i) / 8, std::numeric_limits<std::uint32_t>::max());
+        for (; i < end; i += 8) acc = _mm256_sub_epi32(acc, equal(load(p + i), key));
+        alignas(32) std::uint32_t lanes[8];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), acc);
+        for (std::uint32_t lane : lanes) c += lane;
+    }
+    for (; i < n; ++i) c += p[i] == value;
+    return c;
+}
+
+template <class T>
+TARGET std::size_t find(const T* p, std::size_t n, T value) {
+    const auto key = broadcast(value);
+    std::size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i any = _mm256_or_si256(_mm256_or_si256(equal(load(p + i), key), equal(load(p + i + 8), key)),
+                                      _mm256_or_si256(equal(load(p + i + 16), key), equal(load(p + i + 24), key)));
+        if (!_mm256_testz_si256(any, any)) break;
+    }
+    for (; i < n; ++i)
+        if (p[i] == value) return i;
+    return n;
+}
+
+template <bool Max>
+TARGET inline __m256i pick(__m256i a, __m256i b) { return Max ? _mm256_max_epi32(a, b) : _mm256_min_epi32(a, b); }
+template <bool Max>
+TARGET inline __m256 pick(__m256 a, __m256 b) { return Max ? _mm256_max_ps(a, b) : _mm256_min_ps(a, b); }
+TARGET inline void store(std::int32_t* out, __m256i v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), v); }
+TARGET inline void store(float* out, __m256 v) { _mm256_storeu_ps(out, v); }
+
+template <bool Max, class T>
+TARGET T extreme(const T* p, std::size_t n) {
+    const T identity = Max ? std::numeric_limits<T>::lowest() : std::numeric_limits<T>::max();
+    auto m0 = broadcast(identity), m1 = m0;
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        m0 = pick<Max>(m0, load(p + i));
+        m1 = pick<Max>(m1, load(p + i + 8));
+    }
+    T lanes[8];
+    store(lanes, pick<Max>(m0, m1));
+    T m = baseline::extreme<Max>(lanes, 8);
+    for (; i < n; ++i) m = Max ? std::max(m, p[i]) : std::min(m, p[i]);
+    return m;
+}
+
+template <class T>
+TARGET std::pair<T, T> minmax(const T* p, std::size_t n) {
+    auto lo = broadcast(std::numeric_limits<T>::max());
+    auto hi = broadcast(std::numeric_limits<T>::lowest());
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        auto v = load(p + i);
+        lo = pick<false>(lo, v);
+        hi = pick<true>(hi, v);
+    }
+    T lo_lanes[8], hi_lanes[8];
+    store(lo_lanes, lo);
+    store(hi_lanes, hi);
+    T mn = baseline::extreme<false>(lo_lanes, 8), mx = baseline::extreme<true>(hi_lanes, 8);
+    for (; i < n; ++i) {
+        mn = std::min(mn, p[i]);
+        mx = std::max(mx, p[i]);
+    }
+    return {mn, mx};
+}
+
+#undef TARGET
+} // namespace avx2
+
+// GCC 12's AVX-512 headers initialize their "undefined" registers from themselves, which
+// -Wuninitialized reports at every inlined call
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+namespace avx512 {
+
+#define TARGET SIMD_TARGET("avx512f")
+
+TARGET inline std::int64_t reduce(const std::int32_t* p, std::size_t n) {
+    __m512i acc0 = _mm512_setzero_si512(), acc1 = acc0;
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512i v = _mm512_loadu_si512(p + i);
+        acc0 = _mm512_add_epi64(acc0, _mm512_cvtepi32_epi64(_mm512_castsi512_si256(v)));
+        acc1 = _mm512_add_epi64(acc1, _mm512_cvtepi32_epi64(_mm512_extracti64x4_epi64(v, 1)));
+    }
+    std::int64_t sum = _mm512_reduce_add_epi64(_mm512_add_epi64(acc0, acc1));
+    for (; i < n; ++i) sum += p[i];
+    return sum;
+}
+
+TARGET inline double reduce(const float* p, std::size_t n) {
+    __m512d acc0 = _mm512_setzero_pd(), acc1 = acc0;
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512 v = _mm512_loadu_ps(p + i);
+        __m256 high = _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(v), 1));
+        acc0 = _mm512_add_pd(acc0, _mm512_cvtps_pd(_mm512_castps512_ps256(v)));
+        acc1 = _mm512_add_pd(acc1, _mm512_cvtps_pd(high));
+    }
+    double sum = _mm512_reduce_add_pd(_mm512_add_pd(acc0, acc1));
+    for (; i < n; ++i) sum += p[i];
+    return sum;
+}
+
+TARGET inline __mmask16 equal(__m512i v, __m512i key) { return _mm512_cmpeq_epi32_mask(v, key); }
+TARGET inline __mmask16 equal(__m512 v, __m512 key) { return _mm512_cmp_ps_mask(v, key, _CMP_EQ_OQ); }
+TARGET inline __m512i load(const std::int32_t* p) { return _mm512_loadu_si512(p); }
+TARGET inline __m512 load(const float* p) { return _mm512_loadu_ps(p); }
+TARGET inline __m512i broadcast(std::int32_t v) { return _mm512_set1_epi32(v); }
+TARGET inline __m512 broadcast(float v) { return _mm512_set1_ps(v); }
+
+template <class T>
+TARGET std::size_t count(const T* p, std::size_t n, T value) {
+    const auto key = broadcast(value);
+    const __m512i one = _mm512_set1_epi32(1);
+    std::size_t c = 0, i = 0;
+    // 32-bit lanes, added up in 64 bits (not with _mm512_reduce_add_epi32, which wraps) before 2^32 steps
+    while (i + 16 <= n) {
+        __m512i acc = _mm512_setzero_si512();
+        const std::size_t end = i + 16 * std::min<std::size_t>((n - i) / 16, std::numeric_limits<std::uint32_t>::max());
+        for (; i < end; i += 16) acc = _mm512_mask_add_epi32(acc, equal(load(p + i), key), acc, one);
+        alignas(64) std::uint32_t lanes[16];
+        _mm512_store_si512(lanes, acc);
+        for (std::uint32_t lane : lanes) c += lane;
+    }
+    for (; i < n; ++i) c += p[i] == value;
+    return c;
+}
+
+template <class T>
+TARGET std::size_t find(const T* p, std::size_t n, T value) {
+    const auto key = broadcast(value);
+    std::size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        auto any = equal(load(p + i), key) | equal(load(p + i + 16), key) |
+                   equal(load(p + i + 32), key) | equal(load(p + i + 48), key);
+        if (any) break;
+    }
+    for (; i < n; ++i)
+        if (p[i] == value) return i;
+    return n;
+}
+
+template <bool Max>
+TARGET inline __m512i pick(__m512i a, __m512i b) { return Max ? _mm512_max_epi32(a, b) : _mm512_min_epi32(a, b); }
+template <bool Max>
+TARGET inline __m512 pick(__m512 a, __m512 b) { return Max ? _mm512_max_ps(a, b) : _mm512_min_ps(a, b); }
+TARGET inline std::int32_t horizontal_min(__m512i v) { return _mm512_reduce_min_epi32(v); }
+TARGET inline std::int32_t horizontal_max(__m512i v) { return _mm512_reduce_max_epi32(v); }
+TARGET inline float horizontal_min(__m512 v) { return _mm512_reduce_min_ps(v); }
+TARGET inline float horizontal_max(__m512 v) { return _mm512_reduce_max_ps(v); }
+
+template <bool Max, class T>
+TARGET T extreme(const T* p, std::size_t n) {
+    const T identity = Max ? std::numeric_limits<T>::lowest() : std::numeric_limits<T>::max();
+    auto m0 = broadcast(identity), m1 = m0;
+    std::size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        m0 = pick<Max>(m0, load(p + i));
+        m1 = pick<Max>(m1, load(p + i + 16));
+    }
+    auto m = pick<Max>(m0, m1);
+    T result = Max ? horizontal_max(m) : horizontal_min(m);
+    for (; i < n; ++i) result = Max ? std::max(result, p[i]) : std::min(result, p[i]);
+    return result;
+}
+
+template <class T>
+TARGET std::pair<T, T> minmax(const T* p, std::size_t n) {
+    auto lo = broadcast(std::numeric_limits<T>::max());
+    auto hi = broadcast(std::numeric_limits<T>::lowest());
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        auto v = load(p + i);
+        lo = pick<false>(lo, v);
+        hi = pick<true>(hi, v);
+    }
+    T mn = horizontal_min(lo), mx = horizontal_max(hi);
+    for (; i < n; ++i) {
+        mn = std::min(mn, p[i]);
+        mx = std::max(mx, p[i]);
+    }
+    return {mn, mx};
+}
+
+#undef TARGET
+} // namespace avx512
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+inline void cpuid(unsigned leaf, unsigned subleaf, unsigned regs[4]) {
+#if defined(_MSC_VER)
+    int r[4];
+    __cpuidex(r, static_cast<int>(leaf), static_cast<int>(subleaf));
+    for (int i = 0; i < 4; ++i) regs[i] = static_cast<unsigned>(r[i]);
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// XCR0: which register states the OS saves on a context switch
+inline std::uint64_t xgetbv0() {
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    unsigned eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (std::uint64_t{edx} << 32) | eax;
+#endif
+}
+#endif // HAS_X86_SIMD
+
+// Highest level supported by both the CPU and the OS.
+inline Isa detect() {
+#if HAS_X86_SIMD
+    unsigned r[4];
+    cpuid(0, 0, r);
+    const unsigned max_leaf = r[0];
+    cpuid(1, 0, r);
+    const bool sse2 = r[3] & (1u << 26);
+    const bool osxsave = r[2] & (1u << 27);
+    const bool avx = r[2] & (1u << 28);
+    if (!sse2) return Isa::baseline;
+    if (!osxsave || !avx || max_leaf < 7) return Isa::sse2;
+    const std::uint64_t xcr0 = xgetbv0();
+    if ((xcr0 & 0x6) != 0x6) return Isa::sse2;  // XMM and YMM state
+    cpuid(7, 0, r);
+    if (!(r[1] & (1u << 5))) return Isa::sse2;
+    if ((r[1] & (1u << 16)) && (xcr0 & 0xE0) == 0xE0) return Isa::avx512;  // opmask, ZMM state
+    return Isa::avx2;
+#else
+    return Isa::baseline;
+#endif
+}
+
+// Levels run on this machine, lowest first.
+inline std::vector<Isa> supported_levels() {
+    static const Isa best_level = detect();
+    std::vector<Isa> levels;
+    for (Isa isa : {Isa::baseline, Isa::sse2, Isa::avx2, Isa::avx512})
+        if (isa <= best_level) levels.push_back(isa);
+    return levels;
+}
+
+struct Kernels {
+    Isa isa;
+    std::int64_t (*reduce_i32)(const std::int32_t*, std::size_t);
+    double (*reduce_f32)(const float*, std::size_t);
+    std::size_t (*count_i32)(const std::int32_t*, std::size_t, std::int32_t);
+    std::size_t (*count_f32)(const float*, std::size_t, float);
+    std::size_t (*find_i32)(const std::int32_t*, std::size_t, std::int32_t);
+    std::size_t (*find_f32)(const float*, std::size_t, float);
+    std::int32_t (*min_i32)(const std::int32_t*, std::size_t);
+    std::int32_t (*max_i32)(const std::int32_t*, std::size_t);
+    float (*min_f32)(const float*, std::size_t);
+    float (*max_f32)(const float*, std::size_t);
+    std::pair<std::int32_t, std::int32_t> (*minmax_i32)(const std::int32_t*, std::size_t);
+    std::pair<float, float> (*minmax_f32)(const float*, std::size_t);
+};
+
+#define SIMD_KERNEL_TABLE(ns) \
+    Kernels{Isa::ns, ns::reduce, ns::reduce, ns::count, ns::count, ns::find, ns::find, \
+            ns::extreme<false>, ns::extreme<true>, ns::extreme<false>, ns::extreme<true>, ns::minmax, ns::minmax}
+
+// Kernel table of one level; throws if the machine cannot run it.
+inline const Kernels& kernels(Isa isa) {
+    static const Kernels tables[] = {
+        SIMD_KERNEL_TABLE(baseline),
+#if HAS_X86_SIMD
+        SIMD_KERNEL_TABLE(sse2),
+        SIMD_KERNEL_TABLE(avx2),
+        SIMD_KERNEL_TABLE(avx512),
+#endif
+    };
+    const auto levels = supported_levels();
+    if (std::find(levels.begin(), levels.end(), isa) == levels.end())
+        throw std::runtime_error(std::string{"simd: "} + to_string(isa) + " is not supported on this machine");
+    return tables[static_cast<int>(isa)];
+}
+#undef SIMD_KERNEL_TABLE
+
+// Kernels of the highest supported level, chosen on first use.
+inline const Kernels& best() {
+    static const Kernels& table = kernels(supported_levels().back());
+    return table;
+}
+
+// Runs per_chunk(begin, end) on every chunk in parallel and folds the results with combine.
+template <class T, class PerChunk, class Combine>
+T chunked_reduce(std::size_t n, T init, PerChunk per_chunk, Combine combine) {
+    const std::size_t chunks = default_chunks(n);
+    std::vector<T> partial(chunks, init);
+    for_each_chunk(n, chunks, [&](std::size_t c, std::size_t b, std::size_t e) { partial[c] = per_chunk(b, e); });
+    return std::accumulate(partial.begin(), partial.end(), init, combine);
+}
+
+} // namespace simd
+
+void simd_kernel_benchmark(bench::Runner& runner) {
+    std::cout << "\n[simd_kernel_benchmark]" << std::endl;
+    std::cout << "best instruction set: " << simd::to_string(simd::best().isa) << std::endl;
+
+    constexpr std::size_t N = 1'000'000;
+    std::vector<std::int32_t> ints(N);
+    std::iota(ints.begin(), ints.end(), 0);
+    std::shuffle(ints.begin(), ints.end(), std::mt19937{42});
+    std::vector<float> floats(ints.begin(), ints.end());  // exact: every value is below 2^24
+    const std::int32_t target = 500'000;
+    const std::int32_t* pi = ints.data();
+    const float* pf = floats.data();
+
+    // Runs one operation with the standard algorithm, every kernel level and the best level
+    // on all threads, and checks that all of them agree with the standard algorithm.
+    auto run_all = [&](const std::string& name, auto reference, auto kernel_call) {
+        const auto expected = reference();
+        runner.run(name, "std", N, [&] { bench::do_not_optimize(reference()); });
+        for (simd::Isa isa : simd::supported_levels()) {
+            const simd::Kernels& k = simd::kernels(isa);
+            runner.run(name, simd::to_string(isa), N, [&] { bench::do_not_optimize(kernel_call(k, 0, N)); });
+            if (kernel_call(k, 0, N) != expected)
+                throw std::runtime_error(name + ": " + simd::to_string(isa) + " kernel disagrees with the std algorithm");
+        }
+        return expected;
+    };
+    auto threaded = [&](const std::string& name, auto expected, auto call) {
+        runner.run(name, std::string{simd::to_string(simd::best().isa)} + " + threads", N,
+                   [&] { bench::do_not_optimize(call()); });
+        if (call() != expected) throw std::runtime_error(name + ": threaded kernel disagrees with the std algorithm");
+    };
+    const simd::Kernels& best = simd::best();
+
+    auto sum_i = run_all("reduce int32",
+        [&] { return std::reduce(ints.begin(), ints.end(), std::int64_t{0}); },
+        [&](const simd::Kernels& k, std::size_t b, std::size_t e) { return k.reduce_i32(pi + b, e - b); });
+    threaded("reduce int32", sum_i, [&] {
+        return simd::chunked_reduce(N, std::int64_t{0}, [&](std::size_t b, std::size_t e) { return best.reduce_i32(pi + b, e - b); }, std::plus<>());
+    });
+
+    auto sum_f = run_all("reduce float",
+        [&] { return std::transform_reduce(floats.begin(), floats.end(), 0.0, std::plus<>(), [](float x) { return double{x}; }); },
+        [&](const simd::Kernels& k, std::size_t b, std::size_t e) { return k.reduce_f32(pf + b, e - b); });
+    threaded("reduce float", sum_f, [&] {
+        return simd::chunked_reduce(N, 0.0, [&](std::size_t b, std::size_t e) { return best.reduce_f32(pf + b, e - b); }, std::plus<>());
+    });
+
+    auto count_i = run_all("count int32",
+        [&] { return static_cast<std::size_t>(std::count(ints.begin(), ints.end(), target)); },
+        [&](const simd::Kernels& k, std::size_t b, std::size_t e) { return k.count_i32(pi + b, e - b, target); });
+    threaded("count int32", count_i, [&] {
+        return simd::chunked_reduce(N, std::size_t{0}, [&](std::size_t b, std::size_t e) { return best.count_i32(pi + b, e - b, target); }, std::plus<>());
+    });
+
+    run_all("count float",
+        [&] { return static_cast<std::size_t>(std::count(floats.begin(), floats.end(), float(target))); },
+        [&](const simd::Kernels& k, std::size_t b, std::size_t e) { return k.count_f32(pf + b, e - b, float(target)); });
+
+    auto min_index = [](std::size_t a, std::size_t b) { return std::min(a, b); };
+    auto pos_i = run_all("find int32",
+        [&] { return static_cast<std::size_t>(std::find(ints.begin(), ints.end(), target) - ints.begin()); },
+        [&](const simd::Kernels& k, std::size_t b, std::size_t e) { return k.find_i32(pi + b, e - b, target); });
+    threaded("find int32", pos_i, [&] {
+        return simd::chunked_reduce(N, N, [&](std::size_t b, std::size_t e) {
+            std::size_t i = best.find_i32(pi + b, e - b, target);
+            return i == e - b ? N : b + i;
+        }, min_index);
+    });
+
+    run_all("find float",
+        [&] { return static_cast<std::size_t>(std::find(floats.begin(), floats.end(), float(target)) - floats.begin()); },
+        [&](const simd::Kernels& k, std::size_t b, std::size_t e) { return k.find_f32(pf + b, e - b, float(target)); });
+
+    run_all("min int32",
+        [&] { return *std::min_element(ints.begin(), ints.end()); },
+        [&](const simd::Kernels& k, std::size_t b, std::size_t e) { return k.min_i32(pi + b, e - b); });
+    run_all("max float",
+        [&] { return *std::max_element(floats.begin(), floats.end()); },
+        [&](const simd::Kernels& k, std::size_t b, std::size_t e) { return k.max_f32(pf + b, e - b); });
+
+    auto mm_i = run_all("minmax int32",
+        [&] { auto [lo, hi] = std::minmax_element(ints.begin(), ints.end()); return std::pair{*lo, *hi}; },
+        [&](const simd::Kernels& k, std::size_t b, std::size_t e) { return k.minmax_i32(pi + b, e - b); });
+    threaded("minmax int32", mm_i, [&] {
+        using MinMax = std::pair<std::int32_t, std::int32_t>;
+        return simd::chunked_reduce(N, MinMax{std::numeric_limits<std::int32_t>::max(), std::numeric_limits<std::int32_t>::lowest()},
+            [&](std::size_t b, std::size_t e) { return best.minmax_i32(pi + b, e - b); },
+            [](MinMax a, MinMax b) { return MinMax{std::min(a.first, b.first), std::max(a.second, b.second)}; });
+    });
+
+    run_all("minmax float",
+        [&] { auto [lo, hi] = std::minmax_element(floats.begin(), floats.end()); return std::pair{*lo, *hi}; },
+        [&](const simd::Kernels& k, std::size_t b, std::size_t e) { return k.minmax_f32(pf + b, e - b); });
+}
+
+/*
+    BLAS-1 kernels
+
+    The dot product and norm in dot_product_and_norm() go through std::transform_reduce,
+    which keeps a single accumulator: every addition waits for the previous one, and without
+    -ffast-math the compiler may not reorder the sum to vectorize it. The kernels below are
+    the double precision level-1 BLAS operations written per instruction-set level, on top
+    of the dispatch of the simd section:
+
+    - dot(x, y):   sum of x[i] * y[i]
+    - nrm2(x):     Euclidean norm without overflow or underflow in the squares
+    - axpy(a, x, y): y[i] += a * x[i]
+    - scal(a, x):  x[i] *= a
+
+    Each vector kernel keeps four independent accumulators (or four vectors in flight for
+    axpy/scal) to cover the latency of the FP adder. The AVX2 level also needs FMA, which
+    every AVX2 CPU so far has but CPUID reports separately; AVX-512F always includes it.
+    blas1::dot_threaded, nrm2_threaded, axpy_threaded and scal_threaded run the best level on
+    every chunk of for_each_chunk.
+
+    nrm2 sums the squares directly first. Only when that sum overflowed, or is so small that
+    squares may have lost bits to underflow, does it take a second pass: it finds max |x[i]|,
+    scales by the power of two that brings it into [0.5, 1) (exact), sums the scaled squares
+    and scales the root back. Unlike the reference BLAS, which rescales on every element, the
+    usual case therefore costs a single FMA per element.
+*/
+namespace blas1 {
+
+using simd::Isa;
+
+namespace baseline {
+
+inline double dot(const double* x, const double* y, std::size_t n) {
+    double sum = 0;
+    for (std::size_t i = 0; i < n; ++i) sum += x[i] * y[i];
+    return sum;
+}
+inline double sumsq(const double* x, std::size_t n, double scale) {
+    double sum = 0;
+    for (std::size_t i = 0; i < n; ++i) sum += (x[i] * scale) * (x[i] * scale);
+    return sum;
+}
+inline double amax(const double* x, std::size_t n) {
+    double m = 0;
+    for (std::size_t i = 0; i < n; ++i) m = std::max(m, std::abs(x[i]));
+    return m;
+}
+inline void axpy(double a, const double* x, double* y, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) y[i] += a * x[i];
+}
+inline void scal(double a, double* x, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) x[i] *= a;
+}
+
+} // namespace baseline
+
+#if HAS_X86_SIMD
+namespace sse2 {
+
+#define TARGET SIMD_TARGET("sse2")
+
+TARGET inline double hsum(__m128d v) { return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v))); }
+
+TARGET inline double dot(const double* x, const double* y, std::size_t n) {
+    __m128d acc0 = _mm_setzero_pd(), acc1 = acc0, acc2 = acc0, acc3 = acc0;
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm_add_pd(acc0, _mm_mul_pd(_mm_loadu_pd(x + i), _mm_loadu_pd(y + i)));
+        acc1 = _mm_add_pd(acc1, _mm_mul_pd(_mm_loadu_pd(x + i + 2), _mm_loadu_pd(y + i + 2)));
+        acc2 = _mm_add_pd(acc2, _mm_mul_pd(_mm_loadu_pd(x + i + 4), _mm_loadu_pd(y + i + 4)));
+        acc3 = _mm_add_pd(acc3, _mm_mul_pd(_mm_loadu_pd(x + i + 6), _mm_loadu_pd(y + i + 6)));
+    }
+    double sum = hsum(_mm_add_pd(_mm_add_pd(acc0, acc1), _mm_add_pd(acc2, acc3)));
+    for (; i < n; ++i) sum += x[i] * y[i];
+    return sum;
+}
+
+TARGET inline double sumsq(const double* x, std::size_t n, double scale) {
+    const __m128d s = _mm_set1_pd(scale);
+    __m128d acc0 = _mm_setzero_pd(), acc1 = acc0, acc2 = acc0, acc3 = acc0;
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128d v0 = _mm_mul_pd(_mm_loadu_pd(x + i), s), v1 = _mm_mul_pd(_mm_loadu_pd(x + i + 2), s);
+        __m128d v2 = _mm_mul_pd(_mm_loadu_pd(x + i + 4), s), v3 = _mm_mul_pd(_mm_loadu_pd(x + i + 6), s);
+        acc0 = _mm_add_pd(acc0, _mm_mul_pd(v0, v0));
+        acc1 = _mm_add_pd(acc1, _mm_mul_pd(v1, v1));
+        acc2 = _mm_add_pd(acc2, _mm_mul_pd(v2, v2));
+        acc3 = _mm_add_pd(acc3, _mm_mul_pd(v3, v3));
+    }
+    double sum = hsum(_mm_add_pd(_mm_add_pd(acc0, acc1), _mm_add_pd(acc2, acc3)));
+    for (; i < n; ++i) sum += (x[i] * scale) * (x[i] * scale);
+    return sum;
+}
+
+TARGET inline double amax(const double* x, std::size_t n) {
+    const __m128d sign = _mm_set1_pd(-0.0);
+    __m128d m0 = _mm_setzero_pd(), m1 = m0;
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        m0 = _mm_max_pd(m0, _mm_andnot_pd(sign, _mm_loadu_pd(x + i)));
+        m1 = _mm_max_pd(m1, _mm_andnot_pd(sign, _mm_loadu_pd(x + i + 2)));
+    }
+    m0 = _mm_max_pd(m0, m1);
+    double m = std::max(_mm_cvtsd_f64(m0), _mm_cvtsd_f64(_mm_unpackhi_pd(m0, m0)));
+    for (; i < n; ++i) m = std::max(m, std::abs(x[i]));
+    return m;
+}
+
+TARGET inline void axpy(double a, const double* x, double* y, std::size_t n) {
+    const __m128d va = _mm_set1_pd(a);
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        for (std::size_t j = 0; j < 8; j += 2)
+            _mm_storeu_pd(y + i + j, _mm_add_pd(_mm_loadu_pd(y + i + j), _mm_mul_pd(va, _mm_loadu_pd(x + i + j))));
+    }
+    for (; i < n; ++i) y[i] += a * x[i];
+}
+
+TARGET inline void scal(double a, double* x, std::size_t n) {
+    const __m128d va = _mm_set1_pd(a);
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        for (std::size_t j = 0; j < 8; j += 2) _mm_storeu_pd(x + i + j, _mm_mul_pd(va, _mm_loadu_pd(x + i + j)));
+    }
+    for (; i < n; ++i) x[i] *= a;
+}
+
+#undef TARGET
+} // namespace sse2
+
+namespace avx2 {
+
+#define TARGET SIMD_TARGET("avx2,fma")
+
+TARGET inline double hsum(__m256d v) {
+    __m128d s = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+}
+
+TARGET inline double dot(const double* x, const double* y, std::size_t n) {
+    __m256d acc0 = _mm256_setzero_pd(), acc1 = acc0, acc2 = acc0, acc3 = acc0;
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i), acc0);
+        acc1 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i + 4), _mm256_loadu_pd(y + i + 4), acc1);
+        acc2 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i + 8), _mm256_loadu_pd(y + i + 8), acc2);
+        acc3 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i + 12), _mm256_loadu_pd(y + i + 12), acc3);
+    }
+    double sum = hsum(_mm256_add_pd(_mm256_add_pd(acc0, acc1), _mm256_add_pd(acc2, acc3)));
+    for (; i < n; ++i) sum += x[i] * y[i];
+    return sum;
+}
+
+TARGET inline double sumsq(const double* x, std::size_t n, double scale) {
+    const __m256d s = _mm256_set1_pd(scale);
+    __m256d acc0 = _mm256_setzero_pd(), acc1 = acc0, acc2 = acc0, acc3 = acc0;
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256d v0 = _mm256_mul_pd(_mm256_loadu_pd(x + i), s), v1 = _mm256_mul_pd(_mm256_loadu_pd(x + i + 4), s);
+        __m256d v2 = _mm256_mul_pd(_mm256_loadu_pd(x + i + 8), s), v3 = _mm256_mul_pd(_mm256_loadu_pd(x + i + 12), s);
+        acc0 = _mm256_fmadd_pd(v0, v0, acc0);
+        acc1 = _mm256_fmadd_pd(v1, v1, acc1);
+        acc2 = _mm256_fmadd_pd(v2, v2, acc2);
+        acc3 = _mm256_fmadd_pd(v3, v3, acc3);
+    }
+    double sum = hsum(_mm256_add_pd(_mm256_add_pd(acc0, acc1), _mm256_add_pd(acc2, acc3)));
+    for (; i < n; ++i) sum += (x[i] * scale) * (x[i] * scale);
+    return sum;
+}
+
+TARGET inline double amax(const double* x, std::size_t n) {
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    __m256d m0 = _mm256_setzero_pd(), m1 = m0;
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        m0 = _mm256_max_pd(m0, _mm256_andnot_pd(sign, _mm256_loadu_pd(x + i)));
+        m1 = _mm256_max_pd(m1, _mm256_andnot_pd(sign, _mm256_loadu_pd(x + i + 4)));
+    }
+    m0 = _mm256_max_pd(m0, m1);
+    __m128d h = _mm_max_pd(_mm256_castpd256_pd128(m0), _mm256_extractf128_pd(m0, 1));
+    double m = std::max(_mm_cvtsd_f64(h), _mm_cvtsd_f64(_mm_unpackhi_pd(h, h)));
+    for (; i < n; ++i) m = std::max(m, std::abs(x[i]));
+    return m;
+}
+
+TARGET inline void axpy(double a, const double* x, double* y, std::size_t n) {
+    const __m256d va = _mm256_set1_pd(a);
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        for (std::size_t j = 0; j < 16; j += 4)
+            _mm256_storeu_pd(y + i + j, _mm256_fmadd_pd(va, _mm256_loadu_pd(x + i + j), _mm256_loadu_pd(y + i + j)));
+    }
+    for (; i < n; ++i) y[i] += a * x[i];
+}
+
+TARGET inline void scal(double a, double* x, std::size_t n) {
+    const __m256d va = _mm256_set1_pd(a);
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        for (std::size_t j = 0; j < 16; j += 4) _mm256_storeu_pd(x + i + j, _mm256_mul_pd(va, _mm256_loadu_pd(x + i + j)));
+    }
+    for (; i < n; ++i) x[i] *= a;
+}
+
+#undef TARGET
+} // namespace avx2
+
+// see the note on the simd avx512 kernels
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+namespace avx512 {
+
+#define TARGET SIMD_TARGET("avx512f")
+
+TARGET inline double dot(const double* x, const double* y, std::size_t n) {
+    __m512d acc0 = _mm512_setzero_pd(), acc1 = acc0, acc2 = acc0, acc3 = acc0;
+    std::size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        acc0 = _mm512_fmadd_pd(_mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i), acc0);
+        acc1 = _mm512_fmadd_pd(_mm512_loadu_pd(x + i + 8), _mm512_loadu_pd(y + i + 8), acc1);
+        acc2 = _mm512_fmadd_pd(_mm512_loadu_pd(x + i + 16), _mm512_loadu_pd(y + i + 16), acc2);
+        acc3 = _mm512_fmadd_pd(_mm512_loadu_pd(x + i + 24), _mm512_loadu_pd(y + i + 24), acc3);
+    }
+    double sum = _mm512_reduce_add_pd(_mm512_add_pd(_mm512_add_pd(acc0, acc1), _mm512_add_pd(acc2, acc3)));
+    for (; i < n; ++i) sum += x[i] * y[i];
+    return sum;
+}
+
+TARGET inline double sumsq(const double* x, std::size_t n, double scale) {
+    const __m512d s = _mm512_set1_pd(scale);
+    __m512d acc0 = _mm512_setzero_pd(), acc1 = acc0, acc2 = acc0, acc3 = acc0;
+    std::size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m512d v0 = _mm512_mul_pd(_mm512_loadu_pd(x + i), s), v1 = _mm512_mul_pd(_mm512_loadu_pd(x + i + 8), s);
+        __m512d v2 = _mm512_mul_pd(_mm512_loadu_pd(x + i + 16), s), v3 = _mm512_mul_pd(_mm512_loadu_pd(x + i + 24), s);
+        acc0 = _mm512_fmadd_pd(v0, v0, acc0);
+        acc1 = _mm512_fmadd_pd(v1, v1, acc1);
+        acc2 = _mm512_fmadd_pd(v2, v2, acc2);
+        acc3 = _mm512_fmadd_pd(v3, v3, acc3);
+    }
+    double sum = _mm512_reduce_add_pd(_mm512_add_pd(_mm512_add_pd(acc0, acc1), _mm512_add_pd(acc2, acc3)));
+    for (; i < n; ++i) sum += (x[i] * scale) * (x[i] * scale);
+    return sum;
+}
+
+TARGET inline double amax(const double* x, std::size_t n) {
+    __m512d m0 = _mm512_setzero_pd(), m1 = m0;
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        m0 = _mm512_max_pd(m0, _mm512_abs_pd(_mm512_loadu_pd(x + i)));
+        m1 = _mm512_max_pd(m1, _mm512_abs_pd(_mm512_loadu_pd(x + i + 8)));
+    }
+    double m = _mm512_reduce_max_pd(_mm512_max_pd(m0, m1));
+    for (; i < n; ++i) m = std::max(m, std::abs(x[i]));
+    return m;
+}
+
+TARGET inline void axpy(double a, const double* x, double* y, std::size_t n) {
+    const __m512d va = _mm512_set1_pd(a);
+    std::size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        for (std::size_t j = 0; j < 32; j += 8)
+            _mm512_storeu_pd(y + i + j, _mm512_fmadd_pd(va, _mm512_loadu_pd(x + i + j), _mm512_loadu_pd(y + i + j)));
+    }
+    for (; i < n; ++i) y[i] += a * x[i];
+}
+
+TARGET inline void scal(double a, double* x, std::size_t n) {
+    const __m512d va = _mm512_set1_pd(a);
+    std::size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        for (std::size_t j = 0; j < 32; j += 8) _mm512_storeu_pd(x + i + j, _mm512_mul_pd(va, _mm512_loadu_pd(x + i + j)));
+    }
+    for (; i < n; ++i) x[i] *= a;
+}
+
+#undef TARGET
+} // namespace avx512
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+inline bool has_fma() {
+    unsigned r[4];
+    simd::cpuid(1, 0, r);
+    return r[2] & (1u << 12);
+}
+#endif // HAS_X86_SIMD
+
+// simd::supported_levels() without AVX2 on the (hypothetical) CPUs that lack FMA.
+inline std::vector<Isa> supported_levels() {
+    std::vector<Isa> levels = simd::supported_levels();
+#if HAS_X86_SIMD
+    static const bool fma = has_fma();
+    if (!fma) std::erase(levels, Isa::avx2);
+#endif
+    return levels;
+}
+
+struct Kernels {
+    Isa isa;
+    double (*dot)(const double*, const double*, std::size_t);
+    double (*sumsq)(const double*, std::size_t, double);  // sum of (x[i] * scale)^2
+    double (*amax)(const double*, std::size_t);
+    void (*axpy)(double, const double*, double*, std::size_t);
+    void (*scal)(double, double*, std::size_t);
+};
+
+#define BLAS1_KERNEL_TABLE(ns) Kernels{Isa::ns, ns::dot, ns::sumsq, ns::amax, ns::axpy, ns::scal}
+
+// Kernel table of one level; throws if the machine cannot run it.
+inline const Kernels& kernels(Isa isa) {
+    static const Kernels tables[] = {
+        BLAS1_KERNEL_TABLE(baseline),
+#if HAS_X86_SIMD
+        BLAS1_KERNEL_TABLE(sse2),
+        BLAS1_KERNEL_TABLE(avx2),
+        BLAS1_KERNEL_TABLE(avx512),
+#endif
+    };
+    const auto levels = supported_levels();
+    if (std::find(levels.begin(), levels.end(), isa) == levels.end())
+        throw std::runtime_error(std::string{"blas1: "} + simd::to_string(isa) + " is not supported on this machine");
+    return tables[static_cast<int>(isa)];
+}
+#undef BLAS1_KERNEL_TABLE
+
+inline const Kernels& best() {
+    static const Kernels& table = blas1::kernels(blas1::supported_levels().back());
+    return table;
+}
+
+// nrm2 on top of a sum: sum(init, per_chunk, combine) folds per_chunk(b, e) over [0, n),
+// either in one call or over the chunks of simd::chunked_reduce.
+template <class Sum>
+double nrm2_with(const Kernels& k, const double* x, std::size_t n, Sum sum) {
+    constexpr double tiny = std::numeric_limits<double>::min() / std::numeric_limits<double>::epsilon();
+    const double ssq = sum(0.0, [&](std::size_t b, std::size_t e) { return k.sumsq(x + b, e - b, 1.0); }, std::plus<>());
+    // fast path unless the sum overflowed (or is NaN) or underflow could have cost precision
+    if (ssq <= std::numeric_limits<double>::max() && ssq >= tiny * static_cast<double>(n)) return std::sqrt(ssq);
+
+    const double m = sum(0.0, [&](std::size_t b, std::size_t e) { return k.amax(x + b, e - b); },
+                         [](double a, double b) { return std::max(a, b); });
+    if (m == 0.0 || std::isinf(m) || std::isnan(ssq)) return std::isnan(ssq) ? ssq : m;
+    int exponent = 0;
+    std::frexp(m, &exponent);  // m = f * 2^exponent, f in [0.5, 1)
+    // for subnormal m 2^-exponent would overflow; 2^1022 still makes every element normal
+    exponent = std::max(exponent, -1022);
+    const double scale = std::ldexp(1.0, -exponent);
+    const double scaled = sum(0.0, [&](std::size_t b, std::size_t e) { return k.sumsq(x + b, e - b, scale); }, std::plus<>());
+    return std::ldexp(std::sqrt(scaled), exponent);
+}
+
+inline double dot(const double* x, const double* y, std::size_t n, const Kernels& k = best()) { return k.dot(x, y, n); }
+
+inline double nrm2(const double* x, std::size_t n, const Kernels& k = best()) {
+    return nrm2_with(k, x, n, [n](double, auto per_chunk, auto) { return per_chunk(0, n); });
+}
+
+inline void axpy(double a, const double* x, double* y, std::size_t n, const Kernels& k = best()) { k.axpy(a, x, y, n); }
+
+inline void scal(double a, double* x, std::size_t n, const Kernels& k = best()) { k.scal(a, x, n); }
+
+inline double dot_threaded(const double* x, const double* y, std::size_t n) {
+    const Kernels& k = best();
+    return simd::chunked_reduce(n, 0.0, [&](std::size_t b, std::size_t e) { return k.dot(x + b, y + b, e - b); }, std::plus<>());
+}
+
+inline double nrm2_threaded(const double* x, std::size_t n) {
+    return nrm2_with(best(), x, n, [n](double init, auto per_chunk, auto combine) {
+        return simd::chunked_reduce(n, init, per_chunk, combine);
+    });
+}
+
+inline void axpy_threaded(double a, const double* x, double* y, std::size_t n) {
+    const Kernels& k = best();
+    for_each_chunk(n, default_chunks(n), [&](std::size_t, std::size_t b, std::size_t e) { k.axpy(a, x + b, y + b, e - b); });
+}
+
+inline void scal_threaded(double a, double* x, std::size_t n) {
+    const Kernels& k = best();
+    for_each_chunk(n, default_chunks(n), [&](std::size_t, std::size_t b, std::size_t e) { k.scal(a, x + b, e - b); });
+}
+
+} // namespace blas1
+
+// Data cache sizes in bytes (L1d, L2, last level), with common values where the OS does not say.
+std::array<std::size_t, 3> cache_sizes() {
+    std::array<std::size_t, 3> sizes{std::size_t{32} << 10, std::size_t{1} << 20, std::size_t{32} << 20};
+#if defined(_WIN32)
+    DWORD bytes = 0;
+    GetLogicalProcessorInformation(nullptr, &bytes);
+    std::vector<SYSTEM_LOGICAL_PROCESSOR_INFORMATION> info(bytes / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION));
+    if (!info.empty() && GetLogicalProcessorInformation(info.data(), &bytes)) {
+        for (const auto& entry : info) {
+            if (entry.Relationship != RelationCache || entry.Cache.Level < 1 || entry.Cache.Level > 3) continue;
+            if (entry.Cache.Level == 1 && entry.Cache.Type == CacheInstruction) continue;
+            sizes[entry.Cache.Level - 1] = entry.Cache.Size;
+        }
+    }
+#elif defined(_SC_LEVEL1_DCACHE_SIZE)
+    const long l1 = sysconf(_SC_LEVEL1_DCACHE_SIZE), l2 = sysconf(_SC_LEVEL2_CACHE_SIZE), l3 = sysconf(_SC_LEVEL3_CACHE_SIZE);
+    if (l1 > 0) sizes[0] = static_cast<std::size_t>(l1);
+    if (l2 > 0) sizes[1] = static_cast<std::size_t>(l2);
+    if (l3 > 0) sizes[2] = static_cast<std::size_t>(l3);
+    else if (l2 > 0) sizes[2] = sizes[1];
+#endif
+    return sizes;
+}
+
+// dot, nrm2, axpy and scal against the std::transform_reduce / std::transform forms, with
+// the working set (all vectors an operation touches) at half of L1, L2 and the last level
+// cache, and at 8 times the last level cache for DRAM. Throughput is in GB/s of vector data
+// read and written, which is what bounds these operations outside of L1.
+void blas1_benchmark(bench::Runner& runner) {
+    std::cout << "\n[blas1_benchmark]" << std::endl;
+    std::cout << "best instruction set: " << simd::to_string(blas1::best().isa) << std::endl;
+
+    const auto caches = cache_sizes();
+    const std::array<std::pair<const char*, std::size_t>, 4> levels{{
+        {"L1", caches[0] / 2}, {"L2", caches[1] / 2}, {"LLC", caches[2] / 2}, {"DRAM", caches[2] * 8}}};
+
+    for (const auto& [level, bytes] : levels) {
+        // x and y of dot/axpy make up the working set; nrm2 and scal touch x alone
+        const std::size_t n = std::max<std::size_t>(64, bytes / (2 * sizeof(double)));
+        std::cout << "-- " << level << ": " << n << " doubles per vector (" << (2 * n * sizeof(double) >> 10) << " KiB)" << std::endl;
+
+        std::vector<double> x(n), y(n);
+        std::mt19937_64 rng{7};
+        std::uniform_real_distribution<double> dist{-1.0, 1.0};
+        for (std::size_t i = 0; i < n; ++i) {
+            x[i] = dist(rng);
+            y[i] = dist(rng);
+        }
+        const double* px = x.data();
+        const double* py = y.data();
+        // a == 1 at run time, which the compiler cannot know: repeated scal calls leave y as it
+        // is and repeated axpy calls only add x again, so timing loops stay finite
+        volatile double a_source = 1.0;
+        const double a = a_source;
+
+        // |computed - exact| <= n * eps * sum |terms| bounds the error of any summation order
+        auto check = [&](const char* name, const std::string& variant, double got, double expected, double abs_sum) {
+            if (std::abs(got - expected) > static_cast<double>(n) * std::numeric_limits<double>::epsilon() * abs_sum)
+                throw std::runtime_error(std::string{name} + ": " + variant + " disagrees with the std algorithm");
+        };
+
+        const std::string label = std::string{" ("} + level + ")";
+        const std::size_t dot_bytes = 2 * n * sizeof(double), axpy_bytes = 3 * n * sizeof(double);
+
+        // dot
+        runner.set_bytes_per_call(dot_bytes);
+        const double dot_expected = std::transform_reduce(x.begin(), x.end(), y.begin(), 0.0);
+        const double dot_abs = std::transform_reduce(x.begin(), x.end(), y.begin(), 0.0, std::plus<>(),
+                                                     [](double u, double v) { return std::abs(u * v); });
+        runner.run("dot" + label, "transform_reduce", n,
+            [&] { bench::do_not_optimize(std::transform_reduce(x.begin(), x.end(), y.begin(), 0.0)); });
+        runner.run("dot" + label, "transform_reduce par", n,
+            [&] { bench::do_not_optimize(std::transform_reduce(std::execution::par, x.begin(), x.end(), y.begin(), 0.0)); });
+        for (simd::Isa isa : blas1::supported_levels()) {
+            const blas1::Kernels& k = blas1::kernels(isa);
+            runner.run("dot" + label, simd::to_string(isa), n, [&] { bench::do_not_optimize(blas1::dot(px, py, n, k)); });
+            check("dot", simd::to_string(isa), blas1::dot(px, py, n, k), dot_expected, dot_abs);
+        }
+        runner.run("dot" + label, "best + threads", n, [&] { bench::do_not_optimize(blas1::dot_threaded(px, py, n)); });
+        check("dot", "threaded", blas1::dot_threaded(px, py, n), dot_expected, dot_abs);
+
+        // nrm2
+        runner.set_bytes_per_call(n * sizeof(double));
+        auto square = [](double u) { return u * u; };
+        const double ssq = std::transform_reduce(x.begin(), x.end(), 0.0, std::plus<>(), square);
+        runner.run("nrm2" + label, "transform_reduce", n,
+            [&] { bench::do_not_optimize(std::sqrt(std::transform_reduce(x.begin(), x.end(), 0.0, std::plus<>(), square))); });
+        runner.run("nrm2" + label, "transform_reduce par", n,
+            [&] { bench::do_not_optimize(std::sqrt(std::transform_reduce(std::execution::par, x.begin(), x.end(), 0.0, std::plus<>(), square))); });
+        for (simd::Isa isa : blas1::supported_levels()) {
+            const blas1::Kernels& k = blas1::kernels(isa);
+            runner.run("nrm2" + label, simd::to_string(isa), n, [&] { bench::do_not_optimize(blas1::nrm2(px, n, k)); });
+            check("nrm2", simd::to_string(isa), blas1::nrm2(px, n, k) * blas1::nrm2(px, n, k), ssq, 2 * ssq);
+        }
+        runner.run("nrm2" + label, "best + threads", n, [&] { bench::do_not_optimize(blas1::nrm2_threaded(px, n)); });
+        check("nrm2", "threaded", blas1::nrm2_threaded(px, n) * blas1::nrm2_threaded(px, n), ssq, 2 * ssq);
+
+        // axpy; the results are checked on a copy of y taken after the timing
+        std::vector<double> out(n);
+        runner.set_bytes_per_call(axpy_bytes);
+        runner.run("axpy" + label, "transform", n,
+            [&] { std::transform(x.begin(), x.end(), y.begin(), y.begin(), [a](double u, double v) { return v + a * u; }); });
+        runner.run("axpy" + label, "transform par", n,
+            [&] { std::transform(std::execution::par, x.begin(), x.end(), y.begin(), y.begin(), [a](double u, double v) { return v + a * u; }); });
+        std::vector<double> expected(n);
+        std::transform(x.begin(), x.end(), y.begin(), expected.begin(), [a](double u, double v) { return v + a * u; });
+        auto check_axpy = [&](const std::string& variant) {
+            for (std::size_t i = 0; i < n; ++i)
+                if (std::abs(out[i] - expected[i]) > 2 * std::numeric_limits<double>::epsilon() * (std::abs(a * x[i]) + std::abs(y[i])))
+                    throw std::runtime_error("axpy: " + variant + " disagrees with the std algorithm");
+        };
+        double* pout = out.data();
+        for (simd::Isa isa : blas1::supported_levels()) {
+            const blas1::Kernels& k = blas1::kernels(isa);
+            runner.run("axpy" + label, simd::to_string(isa), n, [&] { blas1::axpy(a, px, y.data(), n, k); });
+            std::copy(y.begin(), y.end(), out.begin());
+            // y has moved on during the timing; recompute the expectation from its current value
+            std::transform(x.begin(), x.end(), y.begin(), expected.begin(), [a](double u, double v) { return v + a * u; });
+            blas1::axpy(a, px, pout, n, k);
+            check_axpy(simd::to_string(isa));
+        }
+        runner.run("axpy" + label, "best + threads", n, [&] { blas1::axpy_threaded(a, px, y.data(), n); });
+        std::copy(y.begin(), y.end(), out.begin());
+        std::transform(x.begin(), x.end(), y.begin(), expected.begin(), [a](double u, double v) { return v + a * u; });
+        blas1::axpy_threaded(a, px, pout, n);
+        check_axpy("threaded");
+
+        // scal
+        runner.set_bytes_per_call(2 * n * sizeof(double));
+        runner.run("scal" + label, "transform", n,
+            [&] { std::transform(y.begin(), y.end(), y.begin(), [a](double v) { return a * v; }); });
+        runner.run("scal" + label, "transform par", n,
+            [&] { std::transform(std::execution::par, y.begin(), y.end(), y.begin(), [a](double v) { return a * v; }); });
+        for (simd::Isa isa : blas1::supported_levels()) {
+            const blas1::Kernels& k = blas1::kernels(isa);
+            runner.run("scal" + label, simd::to_string(isa), n, [&] { blas1::scal(a, y.data(), n, k); });
+        }
+        runner.run("scal" + label, "best + threads", n, [&] { blas1::scal_threaded(a, y.data(), n); });
+    }
+
+    // nrm2 where summing the squares directly overflows or underflows, down to subnormals
+    // (among zeros, which must not turn the scaled sum into NaN)
+    for (double magnitude : {1e200, 1e-200, 1e-310}) {
+        std::vector<double> v(2000, 0.0);
+        for (std::size_t i = 0; i < v.size(); i += 2) v[i] = magnitude;
+        const double expected = magnitude * std::sqrt(1000.0);
+        for (simd::Isa isa : blas1::supported_levels()) {
+            const double got = blas1::nrm2(v.data(), v.size(), blas1::kernels(isa));
+            if (!(std::abs(got - expected) <= 1e-14 * expected))
+                throw std::runtime_error(std::string{"nrm2: "} + simd::to_string(isa) + " loses range on scaled input");
+        }
+    }
+    std::cout << "nrm2 of 1000 x 1e200, 1e-200 and 1e-310 among zeros: no overflow or underflow" << std::endl;
+    runner.set_bytes_per_call(0);
+}
+
+/*
+    Execution policy on our own thread pool
+
+    With libstdc++, std::execution::par only runs in parallel when TBB is linked, and no
+    standard library lets the caller choose how many threads it uses or see how the work is
+    split. exec::pool_policy is an execution policy whose algorithms run on an exec::ThreadPool
+    owned by the caller:
+
+        exec::ThreadPool pool{8};
+        exec::sort(exec::par_on(pool), v.begin(), v.end());
+        auto sum = exec::reduce(exec::par_on(pool), v.begin(), v.end(), std::int64_t{0});
+
+    The overloads mirror the standard algorithms used in this file: sort, reduce,
+    transform_reduce, for_each, transform, find, count, inclusive/exclusive_scan and the
+    transform scans, plus the searches find_if, any_of, all_of, none_of and mismatch, which
+    stop early (see find_first), and the selections partition, nth_element and top_k. They
+    are found by argument-dependent lookup too, so sort(policy, ...) works unqualified.
+
+    The pool runs one fork-join job at a time: parallel_for(tasks, fn) hands out task indices
+    through an atomic counter to the workers and to the calling thread, which takes part in
+    the work, and returns when every task is done. A pool of t threads therefore starts t - 1
+    workers. parallel_for_each_thread(fn) is the static schedule: task i always runs on
+    thread i of the pool (0 is the caller), so work split by thread lands on the same thread
+    every time. Calling either from inside a task runs the nested job inline instead of
+    deadlocking. Every algorithm splits its input into up to 4 tasks per thread (at least
+    policy.grain elements each) so a slow thread does not hold up the rest.
+
+    sort is a sample sort: splitters taken from an evenly spaced sample divide the input into
+    one bucket per task, the chunks are scattered into the buckets with per-chunk counts
+    (as in the radix sort above), and the buckets are sorted in parallel. Inputs with very
+    few distinct values put most elements in one bucket and lose most of the parallelism.
+
+    Often only the median or the k smallest elements are needed, and sorting everything
+    does far more work than that:
+
+    - partition scatters the two groups with the same per-chunk counts as sort, so unlike
+      std::partition it is stable, at the price of a buffer as large as the input.
+    - nth_element takes two splitters from a sorted sample just below and just above the
+      rank of nth, scatters the input into the three groups below, between and above them,
+      and continues only with the group that holds nth, usually a few percent of the input.
+    - top_k keeps a heap of the k best elements per task and merges the heaps at the end, so
+      it reads the input once and never moves it; it pays off for k well below n / tasks.
+*/
+namespace exec {
+
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned threads = std::max(1u, std::thread::hardware_concurrency())) {
+        for (unsigned i = 1; i < std::max(1u, threads); ++i) workers.emplace_back([this, i] { worker_loop(i); });
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool() {
+        {
+            std::lock_guard lock(mtx);
+            stop = true;
+        }
+        cv.notify_all();
+        for (auto& t : workers) t.join();
+    }
+
+    // number of threads working on a job, including the caller
+    unsigned size() const { return static_cast<unsigned>(workers.size()) + 1; }
+
+    // Runs fn(i) for every i in [0, tasks) and returns when all calls are done. The first
+    // exception thrown by fn is rethrown here.
+    template <class Fn>
+    void parallel_for(std::size_t tasks, Fn&& fn) {
+        run(tasks, fn, false);
+    }
+
+    // Runs fn(i) for every i in [0, size()), task i on thread i: the caller runs task 0 and
+    // worker i task i, on every call.
+    template <class Fn>
+    void parallel_for_each_thread(Fn&& fn) {
+        run(size(), fn, true);
+    }
+
+private:
+    template <class Fn>
+    void run(std::size_t tasks, Fn& fn, bool pinned) {
+        if (tasks == 0) return;
+        if (workers.empty() || tasks == 1 || current == this) {
+            for (std::size_t i = 0; i < tasks; ++i) fn(i);
+            return;
+        }
+
+        std::lock_guard one_job_at_a_time(run_mtx);
+        {
+            std::lock_guard lock(mtx);
+            job = std::ref(fn);
+            job_tasks = tasks;
+            job_pinned = pinned;
+            next.store(0, std::memory_order_relaxed);
+            active = workers.size();
+            error = nullptr;
+            ++generation;
+        }
+        cv.notify_all();
+
+        ThreadPool* outer = current;
+        current = this;
+        work(0);
+        current = outer;
+
+        std::unique_lock lock(mtx);
+        done_cv.wait(lock, [this] { return active == 0; });
+        job = nullptr;
+        if (error) std::rethrow_exception(error);
+    }
+
+    void worker_loop(unsigned index) {
+        current = this;
+        std::size_t seen = 0;
+        while (true) {
+            {
+                std::unique_lock lock(mtx);
+                cv.wait(lock, [&] { return stop || generation != seen; });
+                if (stop) return;
+                seen = generation;
+            }
+            work(index);
+            {
+                std::lock_guard lock(mtx);
+                if (--active == 0) done_cv.notify_one();
+            }
+        }
+    }
+
+    // thread 'index' of the pool runs its share of the current job
+    void work(std::size_t index) {
+        auto task = [&](std::size_t i) {
+            try {
+                job(i);
+            } catch (...) {
+                std::lock_guard lock(mtx);
+                if (!error) error = std::current_exception();
+            }
+        };
+        if (job_pinned) {
+            if (index < job_tasks) task(index);
+            return;
+        }
+        for (std::size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < job_tasks;) task(i);
+    }
+
+    static inline thread_local ThreadPool* current = nullptr;  // pool whose task this thread is running
+
+    std::vector<std::thread> workers;
+    std::mutex mtx;
+    std::mutex run_mtx;
+    std::condition_variable cv;
+    std::condition_variable done_cv;
+    std::function<void(std::size_t)> job;
+    std::size_t job_tasks = 0;
+    bool job_pinned = false;  // task i on thread i instead of from 'next'
+    std::atomic<std::size_t> next{0};
+    std::size_t generation = 0;
+    std::size_t active = 0;
+    std::exception_ptr error;
+    bool stop = false;
+};
+
+struct pool_policy {
+    ThreadPool* pool;
+    std::size_t grain = 4096;  // minimum number of elements per task
+};
+
+inline pool_policy par_on(ThreadPool& pool, std::size_t grain = 4096) { return {&pool, grain}; }
+
+// Pool sized to the machine, for callers that do not manage their own.
+inline ThreadPool& default_pool() {
+    static ThreadPool pool;
+    return pool;
+}
+
+inline std::size_t task_count(const pool_policy& policy, std::size_t n) {
+    if (policy.pool->size() == 1) return 1;
+    return std::clamp<std::size_t>(n / std::max<std::size_t>(policy.grain, 1), 1, std::size_t{policy.pool->size()} * 4);
+}
+
+// Runs fn(chunk, begin, end) for 'chunks' contiguous pieces of [0, n) on the pool; same
+// split as ::for_each_chunk.
+template <class Fn>
+void for_each_chunk(const pool_policy& policy, std::size_t n, std::size_t chunks, Fn fn) {
+    policy.pool->parallel_for(chunks, [&](std::size_t c) { fn(c, n * c / chunks, n * (c + 1) / chunks); });
+}
+
+// for_each_chunk with one chunk per thread of the pool, chunk c always on thread c.
+template <class Fn>
+void for_each_thread_chunk(const pool_policy& policy, std::size_t n, Fn fn) {
+    const std::size_t chunks = policy.pool->size();
+    policy.pool->parallel_for_each_thread([&](std::size_t c) { fn(c, n * c / chunks, n * (c + 1) / chunks); });
+}
+
+template <class It, class Fn>
+void for_each(const pool_policy& policy, It first, It last, Fn fn) {
+    const auto n = static_cast<std::size_t>(last - first);
+    for_each_chunk(policy, n, task_count(policy, n), [&](std::size_t, std::size_t b, std::size_t e) {
+        std::for_each(first + b, first + e, fn);
+    });
+}
+
+template <class InIt, class OutIt, class UnaryOp>
+OutIt transform(const pool_policy& policy, InIt first, InIt last, OutIt out, UnaryOp op) {
+    const auto n = static_cast<std::size_t>(last - first);
+    for_each_chunk(policy, n, task_count(policy, n), [&](std::size_t, std::size_t b, std::size_t e) {
+        std::transform(first + b, first + e, out + b, op);
+    });
+    return out + static_cast<std::ptrdiff_t>(n);
+}
+
+// Reduction of one non-empty chunk, with the iterator in a register (see scan::detail::scan_range).
+// Four interleaved accumulators break the dependency chain through op; like std::reduce this
+// requires op to be associative and commutative.
+template <class T, class It, class BinaryOp, class UnaryOp>
+T reduce_range(It first, std::size_t n, BinaryOp op, UnaryOp f) {
+    if (n < 8) {
+        T sum = f(first[0]);
+        for (std::size_t i = 1; i < n; ++i) sum = op(std::move(sum), f(first[i]));
+        return sum;
+    }
+    T s0 = f(first[0]), s1 = f(first[1]), s2 = f(first[2]), s3 = f(first[3]);
+    std::size_t i = 4;
+    for (; i + 4 <= n; i += 4) {
+        s0 = op(std::move(s0), f(first[i]));
+        s1 = op(std::move(s1), f(first[i + 1]));
+        s2 = op(std::move(s2), f(first[i + 2]));
+        s3 = op(std::move(s3), f(first[i + 3]));
+    }
+    for (; i < n; ++i) s0 = op(std::move(s0), f(first[i]));
+    return op(op(std::move(s0), std::move(s1)), op(std::move(s2), std::move(s3)));
+}
+
+template <class It, class T, class BinaryOp, class UnaryOp>
+T transform_reduce(const pool_policy& policy, It first, It last, T init, BinaryOp op, UnaryOp f) {
+    const auto n = static_cast<std::size_t>(last - first);
+    const std::size_t chunks = task_count(policy, n);
+    std::vector<std::optional<T>> partial(chunks);
+    for_each_chunk(policy, n, chunks, [&](std::size_t c, std::size_t b, std::size_t e) {
+        if (b != e) partial[c] = reduce_range<T>(first + static_cast<std::ptrdiff_t>(b), e - b, op, f);
+    });
+    for (auto& p : partial)
+        if (p) init = op(std::move(init), std::move(*p));
+    return init;
+}
+
+template <class It, class T, class BinaryOp = std::plus<>>
+T reduce(const pool_policy& policy, It first, It last, T init, BinaryOp op = {}) {
+    return exec::transform_reduce(policy, first, last, std::move(init), op, std::identity{});
+}
+
+template <class It, class Pred>
+std::size_t count_if(const pool_policy& policy, It first, It last, Pred pred) {
+    return exec::transform_reduce(policy, first, last, std::size_t{0}, std::plus<>(),
+                                  [&](const auto& x) { return pred(x) ? std::size_t{1} : std::size_t{0}; });
+}
+
+template <class It, class T>
+std::size_t count(const pool_policy& policy, It first, It last, const T& value) {
+    return exec::count_if(policy, first, last, [&](const auto& x) { return x == value; });
+}
+
+// Smallest index in [0, n) at which the search matches, or n. scan(b, e) returns the first
+// match in [b, e), or e. The range is cut into blocks of policy.grain elements that the pool
+// hands out in ascending order, and all threads share the smallest match found so far: a
+// block that starts past it is skipped, so once the first match is found every thread stops
+// after at most the block it is in. With matches near the front, the work done is close to
+// that of the sequential search.
+template <class Scan>
+std::size_t find_first(const pool_policy& policy, std::size_t n, Scan scan) {
+    const std::size_t block = std::max<std::size_t>(policy.grain, 1);
+    if (policy.pool->size() == 1 || n <= block) return scan(std::size_t{0}, n);
+    std::atomic<std::size_t> best{n};
+    policy.pool->parallel_for((n + block - 1) / block, [&](std::size_t k) {
+        const std::size_t b = k * block;
+        if (b >= best.load(std::memory_order_relaxed)) return;
+        const std::size_t e = std::min(n, b + block);
+        const std::size_t i = scan(b, e);
+        if (i == e) return;
+        std::size_t prev = best.load(std::memory_order_relaxed);
+        while (i < prev && !best.compare_exchange_weak(prev, i, std::memory_order_relaxed)) {}
+    });
+    return best.load(std::memory_order_relaxed);
+}
+
+template <class It, class Pred>
+It find_if(const pool_policy& policy, It first, It last, Pred pred) {
+    const auto n = static_cast<std::size_t>(last - first);
+    return first + static_cast<std::ptrdiff_t>(find_first(policy, n, [&](std::size_t b, std::size_t e) {
+        return static_cast<std::size_t>(std::find_if(first + static_cast<std::ptrdiff_t>(b), first + static_cast<std::ptrdiff_t>(e), pred) - first);
+    }));
+}
+
+template <class It, class T>
+It find(const pool_policy& policy, It first, It last, const T& value) {
+    return exec::find_if(policy, first, last, [&](const auto& x) { return x == value; });
+}
+
+template <class It, class Pred>
+bool any_of(const pool_policy& policy, It first, It last, Pred pred) {
+    return exec::find_if(policy, first, last, pred) != last;
+}
+
+template <class It, class Pred>
+bool all_of(const pool_policy& policy, It first, It last, Pred pred) {
+    return exec::find_if(policy, first, last, [&](const auto& x) { return !pred(x); }) == last;
+}
+
+template <class It, class Pred>
+bool none_of(const pool_policy& policy, It first, It last, Pred pred) {
+    return !exec::any_of(policy, first, last, pred);
+}
+
+template <class It1, class It2, class Pred = std::equal_to<>>
+std::pair<It1, It2> mismatch(const pool_policy& policy, It1 first1, It1 last1, It2 first2, Pred pred = {}) {
+    const auto n = static_cast<std::size_t>(last1 - first1);
+    const std::size_t i = find_first(policy, n, [&](std::size_t b, std::size_t e) {
+        const auto offset = static_cast<std::ptrdiff_t>(b);
+        auto [it, _] = std::mismatch(first1 + offset, first1 + static_cast<std::ptrdiff_t>(e), first2 + offset, pred);
+        return static_cast<std::size_t>(it - first1);
+    });
+    return {first1 + static_cast<std::ptrdiff_t>(i), first2 + static_cast<std::ptrdiff_t>(i)};
+}
+
+template <class InIt, class OutIt, class BinaryOp, class UnaryOp, class T>
+OutIt transform_inclusive_scan(const pool_policy& policy, InIt first, InIt last, OutIt out, BinaryOp op, UnaryOp f, T init) {
+    const auto n = static_cast<std::size_t>(last - first);
+    auto run_chunks = [&](std::size_t count, std::size_t chunks, auto fn) { for_each_chunk(policy, count, chunks, fn); };
+    return scan::detail::blocked_scan<true>(run_chunks, task_count(policy, n), first, n, nullptr, out, init, op, f);
+}
+
+template <class InIt, class OutIt, class T, class BinaryOp, class UnaryOp>
+OutIt transform_exclusive_scan(const pool_policy& policy, InIt first, InIt last, OutIt out, T init, BinaryOp op, UnaryOp f) {
+    const auto n = static_cast<std::size_t>(last - first);
+    auto run_chunks = [&](std::size_t count, std::size_t chunks, auto fn) { for_each_chunk(policy, count, chunks, fn); };
+    return scan::detail::blocked_scan<false>(run_chunks, task_count(policy, n), first, n, nullptr, out, init, op, f);
+}
+
+template <class InIt, class OutIt, class BinaryOp, class T>
+OutIt inclusive_scan(const pool_policy& policy, InIt first, InIt last, OutIt out, BinaryOp op, T init) {
+    return exec::transform_inclusive_scan(policy, first, last, out, op, std::identity{}, init);
+}
+
+template <class InIt, class OutIt, class T, class BinaryOp = std::plus<>>
+OutIt exclusive_scan(const pool_policy& policy, InIt first, InIt last, OutIt out, T init, BinaryOp op = {}) {
+    return exec::transform_exclusive_scan(policy, first, last, out, init, op, std::identity{});
+}
+
+namespace detail {
+
+// Moves [first, first + n) into 'buffer' grouped by class, class_of(i) in [0, classes) being
+// the class of first[i], keeping the input order within each class: per-chunk counts are
+// prefix-summed class-major into write offsets, then every chunk scatters its elements.
+// Returns where each class starts in the buffer, followed by n. class_of is called twice
+// per element. The result does not depend on the number of chunks.
+template <class It, class T, class ClassOf>
+std::vector<std::size_t> distribute(const pool_policy& policy, It first, std::size_t n, std::size_t classes, ClassOf class_of,
+                                    std::vector<T>& buffer) {
+    const std::size_t chunks = task_count(policy, n);
+    std::vector<std::vector<std::size_t>> offsets(chunks, std::vector<std::size_t>(classes, 0));
+    for_each_chunk(policy, n, chunks, [&](std::size_t c, std::size_t b, std::size_t e) {
+        for (std::size_t i = b; i < e; ++i) ++offsets[c][class_of(i)];
+    });
+    std::vector<std::size_t> class_start(classes + 1, 0);
+    std::size_t offset = 0;
+    for (std::size_t k = 0; k < classes; ++k) {
+        class_start[k] = offset;
+        for (std::size_t c = 0; c < chunks; ++c) {
+            std::size_t count = offsets[c][k];
+            offsets[c][k] = offset;
+            offset += count;
+        }
+    }
+    class_start[classes] = n;
+
+    buffer.resize(n);
+    for_each_chunk(policy, n, chunks, [&](std::size_t c, std::size_t b, std::size_t e) {
+        for (std::size_t i = b; i < e; ++i) buffer[offsets[c][class_of(i)]++] = std::move(first[static_cast<std::ptrdiff_t>(i)]);
+    });
+    return class_start;
+}
+
+template <class T, class It>
+void move_back(const pool_policy& policy, std::vector<T>& buffer, It first) {
+    for_each_chunk(policy, buffer.size(), task_count(policy, buffer.size()), [&](std::size_t, std::size_t b, std::size_t e) {
+        std::move(buffer.begin() + static_cast<std::ptrdiff_t>(b), buffer.begin() + static_cast<std::ptrdiff_t>(e),
+                  first + static_cast<std::ptrdiff_t>(b));
+    });
+}
+
+} // namespace detail
+
+template <class It, class Compare = std::less<>>
+void sort(const pool_policy& policy, It first, It last, Compare comp = {}) {
+    using T = typename std::iterator_traits<It>::value_type;
+    const auto n = static_cast<std::size_t>(last - first);
+    const std::size_t buckets = task_count(policy, n);
+    if (buckets <= 1 || policy.pool->size() == 1) {
+        std::sort(first, last, comp);
+        return;
+    }
+
+    // splitters from an evenly spaced, sorted sample of 32 elements per bucket
+    constexpr std::size_t oversample = 32;
+    std::vector<T> sample(buckets * oversample);
+    for (std::size_t i = 0; i < sample.size(); ++i) sample[i] = first[static_cast<std::ptrdiff_t>(i * n / sample.size())];
+    std::sort(sample.begin(), sample.end(), comp);
+    std::vector<T> splitters(buckets - 1);
+    for (std::size_t i = 0; i + 1 < buckets; ++i) splitters[i] = sample[(i + 1) * oversample];
+    auto bucket_of = [&](const T& x) {
+        return static_cast<std::size_t>(std::upper_bound(splitters.begin(), splitters.end(), x, comp) - splitters.begin());
+    };
+
+    std::vector<T> buffer;
+    const std::vector<std::size_t> bucket_start = detail::distribute(
+        policy, first, n, buckets, [&](std::size_t i) { return bucket_of(first[static_cast<std::ptrdiff_t>(i)]); }, buffer);
+
+    policy.pool->parallel_for(buckets, [&](std::size_t k) {
+        auto b = buffer.begin() + static_cast<std::ptrdiff_t>(bucket_start[k]);
+        auto e = buffer.begin() + static_cast<std::ptrdiff_t>(bucket_start[k + 1]);
+        std::sort(b, e, comp);
+        std::move(b, e, first + static_cast<std::ptrdiff_t>(bucket_start[k]));
+    });
+}
+
+// Stable: both groups keep the input order, as with std::stable_partition.
+template <class It, class Pred>
+It partition(const pool_policy& policy, It first, It last, Pred pred) {
+    using T = typename std::iterator_traits<It>::value_type;
+    const auto n = static_cast<std::size_t>(last - first);
+    if (task_count(policy, n) <= 1) return std::stable_partition(first, last, pred);
+    std::vector<T> buffer;
+    const auto starts = detail::distribute(
+        policy, first, n, 2, [&](std::size_t i) { return pred(first[static_cast<std::ptrdiff_t>(i)]) ? std::size_t{0} : std::size_t{1}; }, buffer);
+    detail::move_back(policy, buffer, first);
+    return first + static_cast<std::ptrdiff_t>(starts[1]);
+}
+
+template <class It, class Compare = std::less<>>
+void nth_element(const pool_policy& policy, It first, It nth, It last, Compare comp = {}) {
+    using T = typename std::iterator_traits<It>::value_type;
+    const auto n = static_cast<std::size_t>(last - first);
+    if (nth == last) return;
+    if (task_count(policy, n) <= 1) {
+        std::nth_element(first, nth, last, comp);
+        return;
+    }
+
+    // splitters 2 * sqrt(m) sample ranks either side of nth, at least four standard deviations
+    const std::size_t m = std::min<std::size_t>(n, 8192);
+    std::vector<T> sample(m);
+    for (std::size_t i = 0; i < m; ++i) sample[i] = first[static_cast<std::ptrdiff_t>(i * n / m)];
+    std::sort(sample.begin(), sample.end(), comp);
+    const std::size_t rank = static_cast<std::size_t>(nth - first) * m / n;
+    const auto margin = static_cast<std::size_t>(2 * std::sqrt(static_cast<double>(m)));
+    const T lo = sample[rank > margin ? rank - margin : 0];
+    const T hi = sample[std::min(m - 1, rank + margin)];
+    auto class_of = [&](std::size_t i) {
+        const T& x = first[static_cast<std::ptrdiff_t>(i)];
+        return comp(x, lo) ? std::size_t{0} : comp(hi, x) ? std::size_t{2} : std::size_t{1};
+    };
+
+    std::vector<T> buffer;
+    const auto starts = detail::distribute(policy, first, n, 3, class_of, buffer);
+    detail::move_back(policy, buffer, first);
+
+    const auto k = static_cast<std::size_t>(nth - first);
+    const std::size_t group = k < starts[1] ? 0 : k < starts[2] ? 1 : 2;
+    if (group == 1 && !comp(lo, hi)) return;  // every element between equal splitters is equal
+    auto b = first + static_cast<std::ptrdiff_t>(starts[group]);
+    auto e = first + static_cast<std::ptrdiff_t>(starts[group + 1]);
+    if (static_cast<std::size_t>(e - b) == n)
+        std::nth_element(first, nth, last, comp);  // the sample did not split the input
+    else
+        exec::nth_element(policy, b, nth, e, comp);
+}
+
+// The k smallest elements of [first, last) under comp in sorted order, like std::partial_sort_copy
+// into k elements; pass std::greater<>() for the k largest.
+template <class It, class Compare = std::less<>>
+std::vector<typename std::iterator_traits<It>::value_type> top_k(const pool_policy& policy, It first, It last, std::size_t k, Compare comp = {}) {
+    using T = typename std::iterator_traits<It>::value_type;
+    const auto n = static_cast<std::size_t>(last - first);
+    k = std::min(k, n);
+    if (k == 0) return {};
+
+    // per task a max-heap (under comp) of the k best elements seen so far
+    const std::size_t chunks = task_count(policy, n);
+    std::vector<std::vector<T>> heaps(chunks);
+    for_each_chunk(policy, n, chunks, [&](std::size_t c, std::size_t b, std::size_t e) {
+        std::vector<T>& heap = heaps[c];
+        heap.reserve(std::min(k, e - b));
+        auto it = first + static_cast<std::ptrdiff_t>(b);
+        const auto end = first + static_cast<std::ptrdiff_t>(e);
+        for (; it != end && heap.size() < k; ++it) {
+            heap.push_back(*it);
+            std::push_heap(heap.begin(), heap.end(), comp);
+        }
+        if (heap.empty()) return;
+        // the worst of the k kept in a local, so the common case is one comparison per element
+        T worst = heap.front();
+        for (; it != end; ++it) {
+            if (!comp(*it, worst)) continue;
+            std::pop_heap(heap.begin(), heap.end(), comp);
+            heap.back() = *it;
+            std::push_heap(heap.begin(), heap.end(), comp);
+            worst = heap.front();
+        }
+    });
+
+    std::vector<T> best;
+    for (std::size_t c = 0; c < chunks; ++c) best.insert(best.end(), heaps[c].begin(), heaps[c].end());
+    std::partial_sort(best.begin(), best.begin() + static_cast<std::ptrdiff_t>(k), best.end(), comp);
+    best.resize(k);
+    return best;
+}
+
+} // namespace exec
+
+/*
+    Counter-based random numbers and a parallel shuffle
+
+    A std::mt19937 is a sequence: the millionth number needs the 999,999 before it, so one
+    engine fills a buffer serially, and std::shuffle of 1G elements with it takes longer
+    than most of the benchmarks it prepares. A counter-based generator is a function
+    instead: rng::philox4x32(counter, key) encrypts a 128-bit counter with a 64-bit key
+    (Philox4x32-10, Salmon et al., "Parallel random numbers: as easy as 1, 2, 3", SC11) and
+    any counter can be computed directly.
+
+    rng::Philox wraps it as a standard random number engine whose stream number is the upper
+    half of the counter, so every stream is an independent sequence of 2^64 blocks.
+    rng::generate gives element i its own stream i, which makes the output a function of the
+    seed and the index only: the same for any thread count or chunking. rng::bounded draws
+    an integer in [0, range) (Lemire's multiply-shift with rejection), the same on every
+    standard library, which the std distributions are not.
+
+    rng::shuffle is a bucket shuffle (Sanders, "Random permutations on distributed, external
+    and hierarchical memory", 1998): element i goes to a bucket chosen by its own stream,
+    the buckets are filled in input order (exec::detail::distribute), and each bucket is
+    shuffled by Fisher-Yates with a stream of its own. Both steps are uniform, so the
+    permutation is too, and since the bucket count depends on n only, so is the result.
+*/
+namespace rng {
+
+using Block = std::array<std::uint32_t, 4>;
+
+inline Block philox4x32(Block counter, std::uint64_t key) {
+    auto k0 = static_cast<std::uint32_t>(key), k1 = static_cast<std::uint32_t>(key >> 32);
+    for (int round = 0; round < 10; ++round) {
+        const std::uint64_t p0 = std::uint64_t{0xD2511F53} * counter[0];
+        const std::uint64_t p1 = std::uint64_t{0xCD9E8D57} * counter[2];
+        counter = {static_cast<std::uint32_t>(p1 >> 32) ^ counter[1] ^ k0, static_cast<std::uint32_t>(p1),
+                   static_cast<std::uint32_t>(p0 >> 32) ^ counter[3] ^ k1, static_cast<std::uint32_t>(p0)};
+        k0 += 0x9E3779B9;
+        k1 += 0xBB67AE85;
+    }
+    return counter;
+}
+
+// Eight blocks at once, with the lanes laid out so that the compiler vectorizes the rounds.
+inline void philox4x32_x8(const Block (&counters)[8], std::uint64_t key, Block (&out)[8]) {
+    std::uint32_t c0[8], c1[8], c2[8], c3[8];
+    for (int l = 0; l < 8; ++l) {
+        c0[l] = counters[l][0];
+        c1[l] = counters[l][1];
+        c2[l] = counters[l][2];
+        c3[l] = counters[l][3];
+    }
+    auto k0 = static_cast<std::uint32_t>(key), k1 = static_cast<std::uint32_t>(key >> 32);
+    for (int round = 0; round < 10; ++round) {
+        for (int l = 0; l < 8; ++l) {
+            const std::uint64_t p0 = std::uint64_t{0xD2511F53} * c0[l];
+            const std::uint64_t p1 = std::uint64_t{0xCD9E8D57} * c2[l];
+            c0[l] = static_cast<std::uint32_t>(p1 >> 32) ^ c1[l] ^ k0;
+            c1[l] = static_cast<std::uint32_t>(p1);
+            c2[l] = static_cast<std::uint32_t>(p0 >> 32) ^ c3[l] ^ k1;
+            c3[l] = static_cast<std::uint32_t>(p0);
+        }
+        k0 += 0x9E3779B9;
+        k1 += 0xBB67AE85;
+    }
+    for (int l = 0; l < 8; ++l) out[l] = {c0[l], c1[l], c2[l], c3[l]};
+}
+
+// Standard random number engine over one stream of Philox4x32-10; discard is O(1).
+class Philox {
+public:
+    using result_type = std::uint32_t;
+
+    explicit Philox(std::uint64_t seed = 0, std::uint64_t stream = 0) : key(seed), stream(stream) {}
+    // with the first block of the stream already computed (see philox4x32_x8)
+    Philox(std::uint64_t seed, std::uint64_t stream, const Block& first) : key(seed), stream(stream), cached(0), words(first) {}
+
+    static Block counter(std::uint64_t block, std::uint64_t stream) {
+        return {static_cast<std::uint32_t>(block), static_cast<std::uint32_t>(block >> 32),
+                static_cast<std::uint32_t>(stream), static_cast<std::uint32_t>(stream >> 32)};
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    result_type operator()() {
+        const std::uint64_t block = position / 4;
+        if (block != cached) {
+            words = philox4x32(counter(block, stream), key);
+            cached = block;
+        }
+        return words[position++ % 4];
+    }
+
+    void discard(unsigned long long z) { position += z; }
+
+private:
+    std::uint64_t key;
+    std::uint64_t stream;
+    std::uint64_t position = 0;  // words consumed
+    std::uint64_t cached = std::numeric_limits<std::uint64_t>::max();
+    Block words{};
+};
+
+// Uniform integer in [0, range), range > 0, without bias.
+template <class Engine>
+std::uint32_t bounded(Engine& engine, std::uint32_t range) {
+    std::uint64_t m = std::uint64_t{engine()} * range;
+    if (static_cast<std::uint32_t>(m) < range) {
+        const std::uint32_t threshold = static_cast<std::uint32_t>(-range) % range;
+        while (static_cast<std::uint32_t>(m) < threshold) m = std::uint64_t{engine()} * range;
+    }
+    return static_cast<std::uint32_t>(m >> 32);
+}
+
+// first[i] = fn(engine) for an engine on stream i of 'seed', in parallel. The first blocks
+// of the streams are computed eight at a time.
+template <class It, class Fn>
+void generate(const exec::pool_policy& policy, It first, It last, std::uint64_t seed, Fn fn) {
+    const auto n = static_cast<std::size_t>(last - first);
+    exec::for_each_chunk(policy, n, exec::task_count(policy, n), [&](std::size_t, std::size_t b, std::size_t e) {
+        std::size_t i = b;
+        for (; i + 8 <= e; i += 8) {
+            Block counters[8], blocks[8];
+            for (std::size_t l = 0; l < 8; ++l) counters[l] = Philox::counter(0, i + l);
+            philox4x32_x8(counters, seed, blocks);
+            for (std::size_t l = 0; l < 8; ++l) {
+                Philox engine{seed, i + l, blocks[l]};
+                first[static_cast<std::ptrdiff_t>(i + l)] = fn(engine);
+            }
+        }
+        for (; i < e; ++i) {
+            Philox engine{seed, i};
+            first[static_cast<std::ptrdiff_t>(i)] = fn(engine);
+        }
+    });
+}
+
+inline constexpr std::size_t shuffle_bucket = std::size_t{1} << 14;  // elements per bucket on average, fits in L1/L2
+
+template <class It>
+void shuffle(const exec::pool_policy& policy, It first, It last, std::uint64_t seed) {
+    using T = typename std::iterator_traits<It>::value_type;
+    const auto n = static_cast<std::size_t>(last - first);
+    const std::size_t buckets = std::max<std::size_t>(1, (n + shuffle_bucket - 1) / shuffle_bucket);
+    const std::uint64_t bucket_seed = seed ^ 0x9E3779B97F4A7C15;  // Fisher-Yates streams, apart from the element streams
+
+    auto fisher_yates = [&](auto b, auto e, std::size_t bucket) {
+        Philox engine{bucket_seed, bucket};
+        for (auto i = e - b; i > 1; --i) std::iter_swap(b + (i - 1), b + bounded(engine, static_cast<std::uint32_t>(i)));
+    };
+    if (buckets == 1) {
+        fisher_yates(first, last, 0);
+        return;
+    }
+
+    std::vector<std::uint32_t> bucket_of(n);
+    rng::generate(policy, bucket_of.begin(), bucket_of.end(), seed,
+                  [&](Philox& engine) { return bounded(engine, static_cast<std::uint32_t>(buckets)); });
+    std::vector<T> buffer;
+    const auto start = exec::detail::distribute(policy, first, n, buckets, [&](std::size_t i) { return std::size_t{bucket_of[i]}; }, buffer);
+    policy.pool->parallel_for(buckets, [&](std::size_t k) {
+        auto b = buffer.begin() + static_cast<std::ptrdiff_t>(start[k]);
+        auto e = buffer.begin() + static_cast<std::ptrdiff_t>(start[k + 1]);
+        fisher_yates(b, e, k);
+        std::move(b, e, first + static_cast<std::ptrdiff_t>(start[k]));
+    });
+}
+
+} // namespace rng
+
+/*
+    Reproducible floating-point reductions
+
+    Floating-point addition is not associative, so a parallel sum depends on how the input
+    is split: std::transform_reduce(std::execution::par, ...) and exec::transform_reduce give
+    results that can change with the thread count, the scheduling and the library, which
+    breaks golden-output tests. repro:: offers two reductions whose results depend only on
+    the input:
+
+    - Fixed tree (repro::sum, dot, nrm2): the input is cut into blocks of repro::block
+      elements, independent of the thread count. Each block is summed in a fixed order (eight
+      interleaved accumulators, plain C++ so every instruction set computes the same thing),
+      and the block sums are combined pairwise in a fixed tree. Threads only decide who
+      computes which block. Cost: close to the non-reproducible path; the result is as
+      accurate as any pairwise-blocked sum, but not correctly rounded.
+    - Exact (repro::exact_sum, exact_dot): every term is added without rounding into a
+      Superaccumulator, a fixed-point integer wide enough for the whole double range (the
+      Kulisch long accumulator), and rounded once at the end. The result is the correctly
+      rounded sum, so it is the same for any split, order, thread count or machine. A dot
+      product adds each product as the exact pair p + e with e = fma(x, y, -p); this is
+      exact unless e underflows. Cost: several times the non-reproducible path.
+
+    Both need the compiler to keep the written operations: no -ffast-math or /fp:fast, and
+    no FMA contraction (-ffp-contract=off, the GCC default in ISO mode, /fp:precise with MSVC),
+    otherwise the fixed tree differs between builds, although not between thread counts.
+    reproducible_reduction_benchmark() checks the results across thread counts and reports
+    the cost of each mode relative to the non-reproducible reductions.
+*/
+namespace repro {
+
+inline constexpr std::size_t block = 8192;
+
+// Fixed-order kernels of one block: eight interleaved accumulators, combined pairwise.
+inline double combine8(const double (&s)[8]) { return ((s[0] + s[1]) + (s[2] + s[3])) + ((s[4] + s[5]) + (s[6] + s[7])); }
+
+inline double sum_block(const double* x, std::size_t n) {
+    double s[8] = {};
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+        for (std::size_t j = 0; j < 8; ++j) s[j] += x[i + j];
+    for (; i < n; ++i) s[i % 8] += x[i];
+    return combine8(s);
+}
+
+inline double dot_block(const double* x, const double* y, std::size_t n) {
+    double s[8] = {};
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+        for (std::size_t j = 0; j < 8; ++j) s[j] += x[i + j] * y[i + j];
+    for (; i < n; ++i) s[i % 8] += x[i] * y[i];
+    return combine8(s);
+}
+
+inline double sumsq_block(const double* x, std::size_t n, double scale) {
+    double s[8] = {};
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+        for (std::size_t j = 0; j < 8; ++j) s[j] += (x[i + j] * scale) * (x[i + j] * scale);
+    for (; i < n; ++i) s[i % 8] += (x[i] * scale) * (x[i] * scale);
+    return combine8(s);
+}
+
+// Folds per_block(b, e) over the blocks of [0, n) on the pool and combines the block results
+// pairwise in a tree that only depends on n.
+template <class T, class PerBlock, class Combine>
+T fixed_tree(const exec::pool_policy& policy, std::size_t n, T init, PerBlock per_block, Combine combine) {
+    const std::size_t blocks = (n + block - 1) / block;
+    if (blocks == 0) return init;
+    std::vector<T> partial(blocks);
+    exec::for_each_chunk(policy, blocks, std::min(blocks, exec::task_count(policy, n)), [&](std::size_t, std::size_t b, std::size_t e) {
+        for (std::size_t k = b; k < e; ++k) partial[k] = per_block(k * block, std::min(n, (k + 1) * block));
+    });
+    for (std::size_t width = blocks; width > 1; width = (width + 1) / 2) {
+        for (std::size_t i = 0; i < width / 2; ++i) partial[i] = combine(partial[2 * i], partial[2 * i + 1]);
+        if (width % 2) partial[width / 2] = partial[width - 1];
+    }
+    return combine(init, partial[0]);
+}
+
+inline double sum(const exec::pool_policy& policy, const double* x, std::size_t n) {
+    return fixed_tree(policy, n, 0.0, [&](std::size_t b, std::size_t e) { return sum_block(x + b, e - b); }, std::plus<>());
+}
+
+inline double dot(const exec::pool_policy& policy, const double* x, const double* y, std::size_t n) {
+    return fixed_tree(policy, n, 0.0, [&](std::size_t b, std::size_t e) { return dot_block(x + b, y + b, e - b); }, std::plus<>());
+}
+
+// blas1::nrm2_with on the fixed-order kernels (amax is exact in any order).
+inline double nrm2(const exec::pool_policy& policy, const double* x, std::size_t n) {
+    static const blas1::Kernels portable{simd::Isa::baseline, dot_block, sumsq_block, blas1::baseline::amax, nullptr, nullptr};
+    return blas1::nrm2_with(portable, x, n, [&](double init, auto per_block, auto combine) {
+        return fixed_tree(policy, n, init, per_block, combine);
+    });
+}
+
+// Exact sum of doubles: a two's complement fixed-point number with one bit for every power
+// of two a double can hold (2^-1074 .. 2^1023) plus headroom for carries, in 32-bit digits
+// stored in 64-bit limbs so that additions can skip carry propagation for 2^29 terms.
+// Infinities and NaNs are summed separately in ordinary floating point.
+class Superaccumulator {
+public:
+    void add(double x) {
+        if (x == 0.0) return;
+        if (!std::isfinite(x)) {
+            special += x;
+            return;
+        }
+        const auto bits = std::bit_cast<std::uint64_t>(x);
+        const auto biased = static_cast<unsigned>((bits >> 52) & 0x7ff);
+        std::uint64_t mantissa = bits & ((std::uint64_t{1} << 52) - 1);
+        if (biased != 0) mantissa |= std::uint64_t{1} << 52;
+        const unsigned shift = (biased == 0 ? 1 : biased) - 1;  // |x| = mantissa * 2^(shift - 1074)
+        const unsigned digit = shift / 32, offset = shift % 32;
+        // mantissa << offset spans three digits
+        const auto d0 = static_cast<std::int64_t>((mantissa << offset) & digit_mask);
+        const auto d1 = static_cast<std::int64_t>((offset ? mantissa >> (32 - offset) : mantissa >> 32) & digit_mask);
+        const auto d2 = static_cast<std::int64_t>(offset ? mantissa >> (64 - offset) : 0);
+        if (bits >> 63) {
+            limbs[digit] -= d0;
+            limbs[digit + 1] -= d1;
+            limbs[digit + 2] -= d2;
+        } else {
+            limbs[digit] += d0;
+            limbs[digit + 1] += d1;
+            limbs[digit + 2] += d2;
+        }
+        if (++pending == normalize_interval) normalize();
+    }
+
+    void add(Superaccumulator other) {
+        normalize();
+        other.normalize();
+        for (std::size_t i = 0; i < digits; ++i) limbs[i] += other.limbs[i];
+        pending = 2;  // every digit is now below 2^33 in magnitude
+        special += other.special;
+    }
+
+    // The sum rounded to nearest, ties to even.
+    double result() const {
+        if (special != 0.0 || std::isnan(special)) return special;
+        Limbs value = limbs;
+        normalize(value);
+        const bool negative = value[digits - 1] < 0;
+        if (negative) {
+            for (auto& limb : value) limb = -limb;
+            normalize(value);
+        }
+        std::size_t top = digits;
+        while (top > 0 && value[top - 1] == 0) --top;
+        if (top == 0) return 0.0;
+        const std::size_t h = top - 1;
+        auto digit_at = [&](std::size_t i, std::size_t below) { return i >= below ? static_cast<std::uint64_t>(value[i - below]) : std::uint64_t{0}; };
+        const std::uint64_t d0 = static_cast<std::uint64_t>(value[h]), d1 = digit_at(h, 1), d2 = digit_at(h, 2);
+        const int lz = std::countl_zero(static_cast<std::uint32_t>(d0));
+        // the 64 bits below and including the leading one, and whether anything below is set
+        const std::uint64_t window = (d0 << (32 + lz)) | (d1 << lz) | (lz ? d2 >> (32 - lz) : 0);
+        bool sticky = lz != 32 && (d2 & ((std::uint64_t{1} << (32 - lz)) - 1)) != 0;
+        for (std::size_t i = 0; i + 2 < h && !sticky; ++i) sticky = value[i] != 0;
+        std::uint64_t mantissa = window >> 11;
+        const bool round = (window >> 10) & 1;
+        sticky = sticky || (window & 0x3ff) != 0;
+        if (round && (sticky || (mantissa & 1))) ++mantissa;
+        // the leading one is bit 32 * h + 31 - lz of the fixed-point number, i.e. 2^(that - 1074)
+        const int exponent = static_cast<int>(32 * h) + 31 - lz - 52 - 1074;
+        const double magnitude = std::ldexp(static_cast<double>(mantissa), exponent);
+        return negative ? -magnitude : magnitude;
+    }
+
+private:
+    static constexpr std::size_t digits = 68;  // 2098 bits of range + 2 digits of carries, rounded up
+    static constexpr std::uint64_t digit_mask = 0xffffffff;
+    static constexpr std::size_t normalize_interval = std::size_t{1} << 29;
+    using Limbs = std::array<std::int64_t, digits>;
+
+    // Moves everything above 32 bits into the next digit; the top limb keeps the sign.
+    static void normalize(Limbs& value) {
+        for (std::size_t i = 0; i + 1 < digits; ++i) {
+            const std::int64_t carry = value[i] >> 32;  // floor division, also for negative limbs
+            value[i] -= carry * (std::int64_t{1} << 32);
+            value[i + 1] += carry;
+        }
+    }
+    void normalize() {
+        normalize(limbs);
+        pending = 0;
+    }
+
+    Limbs limbs{};
+    std::size_t pending = 0;
+    double special = 0.0;
+};
+
+// Exact reductions: one accumulator per task, merged at the end, so any split gives the same bits.
+template <class AddRange>
+double exact_reduce(const exec::pool_policy& policy, std::size_t n, AddRange add_range) {
+    const std::size_t chunks = exec::task_count(policy, n);
+    std::vector<Superaccumulator> partial(chunks);
+    exec::for_each_chunk(policy, n, chunks, [&](std::size_t c, std::size_t b, std::size_t e) { add_range(partial[c], b, e); });
+    Superaccumulator total;
+    for (const auto& p : partial) total.add(p);
+    return total.result();
+}
+
+inline double exact_sum(const exec::pool_policy& policy, const double* x, std::size_t n) {
+    return exact_reduce(policy, n, [&](Superaccumulator& acc, std::size_t b, std::size_t e) {
+        for (std::size_t i = b; i < e; ++i) acc.add(x[i]);
+    });
+}
+
+inline double exact_dot(const exec::pool_policy& policy, const double* x, const double* y, std::size_t n) {
+    return exact_reduce(policy, n, [&](Superaccumulator& acc, std::size_t b, std::size_t e) {
+        for (std::size_t i = b; i < e; ++i) {
+            const double p = x[i] * y[i];
+            acc.add(p);
+            if (std::isfinite(p)) acc.add(std::fma(x[i], y[i], -p));  // the rounding error of p, exactly
+        }
+    });
+}
+
+} // namespace repro
+
+// Runs every reduction on pools of 1 to 16 threads, shows which ones give the same bits every
+// time, and times the reproducible modes against the non-reproducible ones on the default pool.
+void reproducible_reduction_benchmark(bench::Runner& runner) {
+    std::cout << "\n[reproducible_reduction_benchmark]" << std::endl;
+
+    // values spread over 2^-30 .. 2^30 with both signs, so the summation order shows in the result
+    constexpr std::size_t N = std::size_t{1} << 22;
+    std::vector<double> x(N), y(N);
+    std::mt19937_64 rng{11};
+    std::uniform_real_distribution<double> mantissa{-1.0, 1.0};
+    std::uniform_int_distribution<int> exponent{-30, 30};
+    for (std::size_t i = 0; i < N; ++i) {
+        x[i] = std::ldexp(mantissa(rng), exponent(rng));
+        y[i] = std::ldexp(mantissa(rng), exponent(rng));
+    }
+    const double* px = x.data();
+    const double* py = y.data();
+    // x scaled down to 2^-1090 .. 2^-1030: subnormals and zeros, for the scaling path of nrm2
+    std::vector<double> tiny(N);
+    std::transform(x.begin(), x.end(), tiny.begin(), [](double v) { return std::ldexp(v, -1060); });
+
+    struct Variant {
+        const char* name;
+        bool reproducible;
+        std::function<double(const exec::pool_policy&)> run;
+    };
+    const std::vector<Variant> variants{
+        {"sum  exec::reduce", false, [&](const exec::pool_policy& p) { return exec::reduce(p, x.begin(), x.end(), 0.0); }},
+        {"sum  repro::sum", true, [&](const exec::pool_policy& p) { return repro::sum(p, px, N); }},
+        {"sum  repro::exact_sum", true, [&](const exec::pool_policy& p) { return repro::exact_sum(p, px, N); }},
+        {"dot  exec::transform_reduce", false, [&](const exec::pool_policy& p) {
+            auto index = std::views::iota(std::size_t{0}, N);
+            return exec::transform_reduce(p, index.begin(), index.end(), 0.0, std::plus<>(), [&](std::size_t i) { return px[i] * py[i]; });
+        }},
+        {"dot  repro::dot", true, [&](const exec::pool_policy& p) { return repro::dot(p, px, py, N); }},
+        {"dot  repro::exact_dot", true, [&](const exec::pool_policy& p) { return repro::exact_dot(p, px, py, N); }},
+        {"nrm2 repro::nrm2", true, [&](const exec::pool_policy& p) { return repro::nrm2(p, px, N); }},
+        {"nrm2 repro::nrm2, subnormal", true, [&](const exec::pool_policy& p) { return repro::nrm2(p, tiny.data(), N); }},
+    };
+
+    const std::vector<unsigned> thread_counts{1, 2, 3, 4, 7, 8, 16};
+    std::vector<std::vector<double>> results(variants.size());
+    for (unsigned t : thread_counts) {
+        exec::ThreadPool pool{t};
+        const exec::pool_policy policy = exec::par_on(pool);
+        for (std::size_t v = 0; v < variants.size(); ++v) results[v].push_back(variants[v].run(policy));
+    }
+
+    std::cout << "results on pools of";
+    for (unsigned t : thread_counts) std::cout << ' ' << t;
+    std::cout << " threads:" << std::endl;
+    for (std::size_t v = 0; v < variants.size(); ++v) {
+        const auto& r = results[v];
+        std::vector<std::uint64_t> bits(r.size());
+        std::transform(r.begin(), r.end(), bits.begin(), [](double d) { return std::bit_cast<std::uint64_t>(d); });
+        std::sort(bits.begin(), bits.end());
+        const auto distinct = static_cast<std::size_t>(std::unique(bits.begin(), bits.end()) - bits.begin());
+        const bool identical = distinct == 1;
+        std::ostringstream line;
+        line << std::hexfloat << r.front();
+        std::cout << "  " << std::left << std::setw(30) << variants[v].name << std::right << std::setw(26) << line.str()
+                  << (identical ? "  bit-identical" : "  " + std::to_string(distinct) + " different results") << std::endl;
+        if (variants[v].reproducible && !identical)
+            throw std::runtime_error(std::string{variants[v].name} + " changed with the thread count");
+        if (!std::isfinite(r.front())) throw std::runtime_error(std::string{variants[v].name} + " is not finite");
+    }
+
+    // how far the fixed tree is from the correctly rounded result
+    std::cout << "exact sum - fixed tree sum = " << results[2].front() - results[1].front()
+              << ", exact dot - fixed tree dot = " << results[5].front() - results[4].front() << std::endl;
+
+    // cost on the default pool, relative to the non-reproducible reduction of each operation
+    const exec::pool_policy pool = exec::par_on(exec::default_pool());
+    auto cost = [&](const std::string& name, std::initializer_list<std::pair<const char*, std::function<double()>>> runs) {
+        double base = 0;
+        std::ostringstream ratios;
+        ratios << std::fixed << std::setprecision(2);
+        for (const auto& [variant, fn] : runs) {
+            bench::Result& r = runner.run(name, variant, N, [&] { bench::do_not_optimize(fn()); });
+            r.threads = exec::default_pool().size();
+            if (base == 0) base = r.stats.median;
+            else ratios << "  " << variant << " " << r.stats.median / base << "x";
+        }
+        std::cout << "  -> cost vs the non-reproducible path:" << ratios.str() << std::endl;
+    };
+    cost("repro sum", {{"exec::reduce", [&] { return exec::reduce(pool, x.begin(), x.end(), 0.0); }},
+                       {"fixed tree", [&] { return repro::sum(pool, px, N); }},
+                       {"exact", [&] { return repro::exact_sum(pool, px, N); }}});
+    cost("repro dot", {{"blas1 threaded", [&] { return blas1::dot_threaded(px, py, N); }},
+                       {"fixed tree", [&] { return repro::dot(pool, px, py, N); }},
+                       {"exact", [&] { return repro::exact_dot(pool, px, py, N); }}});
+    cost("repro nrm2", {{"blas1 threaded", [&] { return blas1::nrm2_threaded(px, N); }},
+                        {"fixed tree", [&] { return repro::nrm2(pool, px, N); }}});
+}
+
+// Searches with the match at the beginning, middle and end of 16M ints and with no match:
+// std seq, std par and the pool (exec::find_first). Besides the times, one extra run of
+// each parallel search counts how many elements the predicate looked at, which shows
+// whether the threads stop once a match is known.
+void early_exit_search_benchmark(bench::Runner& runner) {
+    std::cout << "\n[early_exit_search_benchmark]" << std::endl;
+
+    constexpr std::size_t N = std::size_t{1} << 24;
+    constexpr int hit = 1;
+    std::vector<int> data(N, 0), other(N, 0);
+    const exec::pool_policy pool = exec::par_on(exec::default_pool());
+
+    const std::array<std::pair<const char*, std::size_t>, 4> positions{{
+        {"begin", N / 1000}, {"middle", N / 2}, {"end", N - 1}, {"none", N}}};
+    for (const auto& [where, pos] : positions) {
+        if (pos < N) data[pos] = hit;
+        const std::string at = std::string{" ("} + where + ")";
+        auto is_hit = [](int v) { return v == hit; };
+        auto is_zero = [](int v) { return v == 0; };
+
+        bench::compare(runner, "find" + at, N,
+            [&] { bench::do_not_optimize(std::find(data.begin(), data.end(), hit)); },
+            [&] { bench::do_not_optimize(std::find(std::execution::par, data.begin(), data.end(), hit)); },
+            [&] { bench::do_not_optimize(exec::find(pool, data.begin(), data.end(), hit)); });
+        bench::compare(runner, "find_if" + at, N,
+            [&] { bench::do_not_optimize(std::find_if(data.begin(), data.end(), is_hit)); },
+            [&] { bench::do_not_optimize(std::find_if(std::execution::par, data.begin(), data.end(), is_hit)); },
+            [&] { bench::do_not_optimize(exec::find_if(pool, data.begin(), data.end(), is_hit)); });
+        bench::compare(runner, "any_of" + at, N,
+            [&] { bench::do_not_optimize(std::any_of(data.begin(), data.end(), is_hit)); },
+            [&] { bench::do_not_optimize(std::any_of(std::execution::par, data.begin(), data.end(), is_hit)); },
+            [&] { bench::do_not_optimize(exec::any_of(pool, data.begin(), data.end(), is_hit)); });
+        bench::compare(runner, "all_of" + at, N,
+            [&] { bench::do_not_optimize(std::all_of(data.begin(), data.end(), is_zero)); },
+            [&] { bench::do_not_optimize(std::all_of(std::execution::par, data.begin(), data.end(), is_zero)); },
+            [&] { bench::do_not_optimize(exec::all_of(pool, data.begin(), data.end(), is_zero)); });
+        bench::compare(runner, "mismatch" + at, N,
+            [&] { bench::do_not_optimize(std::mismatch(data.begin(), data.end(), other.begin())); },
+            [&] { bench::do_not_optimize(std::mismatch(std::execution::par, data.begin(), data.end(), other.begin())); },
+            [&] { bench::do_not_optimize(exec::mismatch(pool, data.begin(), data.end(), other.begin())); });
+
+        // the same search once more with a predicate that counts its calls
+        std::atomic<std::size_t> looked{0};
+        auto counting = [&](int v) {
+            looked.fetch_add(1, std::memory_order_relaxed);
+            return v == hit;
+        };
+        const std::size_t expected = std::min(pos, N - 1) + 1;  // what the sequential search looks at
+        auto share = [&](auto search) {
+            looked = 0;
+            if (search() != (pos < N ? data.begin() + static_cast<std::ptrdiff_t>(pos) : data.end()))
+                throw std::runtime_error(std::string{"find_if"} + at + " returned the wrong position");
+            std::ostringstream os;
+            os << std::fixed << std::setprecision(2) << static_cast<double>(looked.load()) / static_cast<double>(expected) << "x";
+            return os.str();
+        };
+        const std::string par_share = share([&] { return std::find_if(std::execution::par, data.begin(), data.end(), counting); });
+        const std::string pool_share = share([&] { return exec::find_if(pool, data.begin(), data.end(), counting); });
+        std::cout << "  -> elements examined relative to the sequential search: par " << par_share << ", pool " << pool_share << std::endl;
+
+        if (pos < N) data[pos] = 0;
+    }
+}
+
+// Selection on shuffled ints: the 1M vector of compare_seq_vs_par and 16M. Compares
+// partition (even values first), nth_element (the median) and top-k (k = 10 and 1000)
+// between std seq, std par and the pool, plus top-k by nth_element and sorting the front.
+// The results of the pool versions are checked before they are timed.
+void selection_benchmark(bench::Runner& runner) {
+    std::cout << "\n[selection_benchmark]" << std::endl;
+
+    const exec::pool_policy pool = exec::par_on(exec::default_pool());
+    for (std::size_t N : {std::size_t{1'000'000}, std::size_t{16'000'000}}) {
+        std::vector<int> vec(N);
+        std::iota(vec.begin(), vec.end(), 0);
+        rng::shuffle(pool, vec.begin(), vec.end(), std::random_device{}());
+        std::vector<int> work(N);
+        auto reset_work = [&] { std::copy(vec.begin(), vec.end(), work.begin()); };
+        auto is_even = [](int v) { return v % 2 == 0; };
+        const std::string size = " (" + std::to_string(N / 1'000'000) + "M)";
+
+        reset_work();
+        std::vector<int> expected = vec;
+        std::stable_partition(expected.begin(), expected.end(), is_even);
+        if (exec::partition(pool, work.begin(), work.end(), is_even) != work.begin() + static_cast<std::ptrdiff_t>(N / 2) || work != expected)
+            throw std::runtime_error("exec::partition gave a wrong result");
+        bench::compare(runner, "partition" + size, N, reset_work,
+            [&] { bench::do_not_optimize(std::partition(work.begin(), work.end(), is_even)); },
+            [&] { bench::do_not_optimize(std::partition(std::execution::par, work.begin(), work.end(), is_even)); },
+            [&] { bench::do_not_optimize(exec::partition(pool, work.begin(), work.end(), is_even)); });
+
+        const auto mid = static_cast<std::ptrdiff_t>(N / 2);
+        reset_work();
+        exec::nth_element(pool, work.begin(), work.begin() + mid, work.end());
+        if (work[static_cast<std::size_t>(mid)] != mid || *std::max_element(work.begin(), work.begin() + mid) >= mid)
+            throw std::runtime_error("exec::nth_element gave a wrong result");
+        bench::compare(runner, "nth_element (median)" + size, N, reset_work,
+            [&] { std::nth_element(work.begin(), work.begin() + mid, work.end()); },
+            [&] { std::nth_element(std::execution::par, work.begin(), work.begin() + mid, work.end()); },
+            [&] { exec::nth_element(pool, work.begin(), work.begin() + mid, work.end()); });
+
+        for (std::size_t k : {std::size_t{10}, std::size_t{1000}}) {
+            const auto top = exec::top_k(pool, vec.begin(), vec.end(), k);
+            for (std::size_t i = 0; i < k; ++i)
+                if (top.size() != k || top[i] != static_cast<int>(i)) throw std::runtime_error("exec::top_k gave a wrong result");
+            const auto kk = static_cast<std::ptrdiff_t>(k);
+            const std::string name = "top-k (k=" + std::to_string(k) + ")" + size;
+            bench::compare(runner, name, N, reset_work,
+                [&] { std::partial_sort(work.begin(), work.begin() + kk, work.end()); },
+                [&] { std::partial_sort(std::execution::par, work.begin(), work.begin() + kk, work.end()); },
+                [&] { bench::do_not_optimize(exec::top_k(pool, work.begin(), work.end(), k)); });
+            runner.run(name, "nth_element + sort", N, reset_work, [&] {
+                std::nth_element(work.begin(), work.begin() + kk, work.end());
+                std::sort(work.begin(), work.begin() + kk);
+            });
+        }
+    }
+}
+
+// sort and nth_element (the median) for one element type on every input distribution:
+// std seq, std par and the pool, after checking the pool results.
+template <class T>
+void benchmark_distributions(bench::Runner& runner, const std::string& type, std::size_t n) {
+    const exec::pool_policy pool = exec::par_on(exec::default_pool());
+    const InputLess less;
+    const auto mid = static_cast<std::ptrdiff_t>(n / 2);
+    for (Distribution d : all_distributions) {
+        const std::vector<T> input = make_input<T>(n, d, 4);
+        std::vector<T> work(n);
+        auto reset = [&] { std::copy(input.begin(), input.end(), work.begin()); };
+        const std::string suffix = " " + type + " " + to_string(d);
+
+        std::vector<T> expected = input;
+        std::sort(expected.begin(), expected.end(), less);
+        reset();
+        exec::sort(pool, work.begin(), work.end(), less);
+        if (!std::is_sorted(work.begin(), work.end(), less)) throw std::runtime_error("exec::sort" + suffix + ": not sorted");
+        reset();
+        exec::nth_element(pool, work.begin(), work.begin() + mid, work.end(), less);
+        if (less(work[n / 2], expected[n / 2]) || less(expected[n / 2], work[n / 2]))
+            throw std::runtime_error("exec::nth_element" + suffix + ": wrong median");
+
+        bench::compare(runner, "sort" + suffix, n, reset,
+            [&] { std::sort(work.begin(), work.end(), less); },
+            [&] { std::sort(std::execution::par, work.begin(), work.end(), less); },
+            [&] { exec::sort(pool, work.begin(), work.end(), less); });
+        bench::compare(runner, "nth_element" + suffix, n, reset,
+            [&] { std::nth_element(work.begin(), work.begin() + mid, work.end(), less); },
+            [&] { std::nth_element(std::execution::par, work.begin(), work.begin() + mid, work.end(), less); },
+            [&] { exec::nth_element(pool, work.begin(), work.begin() + mid, work.end(), less); });
+    }
+}
+
+// Every input distribution of make_input for ints, doubles, strings and key-value pairs;
+// the radix suite covers the same distributions for the radix sorts.
+void input_distribution_benchmark(bench::Runner& runner) {
+    std::cout << "\n[input_distribution_benchmark]" << std::endl;
+
+    benchmark_distributions<std::int32_t>(runner, "int32", 1'000'000);
+    benchmark_distributions<double>(runner, "double", 1'000'000);
+    benchmark_distributions<std::string>(runner, "string", 200'000);
+    benchmark_distributions<KeyValue>(runner, "key-value", 1'000'000);
+}
+
+/*
+    Histograms with privatized bins
+
+    std::count answers how often one value occurs with a full pass over the data; counting
+    k buckets that way costs k passes. hist::histogram() counts every bucket in one pass on
+    the thread pool, with the bucket edges described by a hist::Binning:
+
+        hist::Binning::fixed(0, 100, 20)            20 bins of width 5 on [0, 100)
+        hist::Binning::log(1e-6, 1.0, 18)           18 bins, 3 per decade, on [1e-6, 1)
+        hist::Binning::custom({0, 1, 10, 100, 1e3}) 4 bins between the given edges
+
+    A bin includes its lower edge and excludes its upper one. Values below the first edge
+    count as underflow, values at or above the last edge, and NaNs, as overflow.
+
+    Every task counts into its own bins (privatization), which the caller sums at the end,
+    so threads never write to the same cache line; a shared array of atomic bins, the
+    obvious alternative, turns every increment into a contended read-modify-write.
+
+    For int32 input with at most simd_max_bins bins there is a SIMD path: instead of
+    computing the bin of every element, it counts for every edge how many elements lie at or
+    above it, eight edges at a time with AVX2 compares on blocks small enough to stay in
+    L1, and the bins are the differences of neighbouring counts. That costs one compare per
+    element and edge, but no dependent loads and stores of bin counters, and wins while the
+    edges are few. The integer edges are derived from Binning::slot itself, so both paths
+    give the same counts.
+*/
+namespace hist {
+
+class Binning {
+public:
+    static Binning fixed(double lo, double hi, std::size_t bins) {
+        if (!(lo < hi) || bins == 0) throw std::invalid_argument("hist::Binning::fixed: needs lo < hi and at least one bin");
+        Binning b{Kind::fixed, lo, hi, static_cast<double>(bins) / (hi - lo), bins};
+        for (std::size_t i = 0; i <= bins; ++i) b.edge_values.push_back(lo + (hi - lo) * static_cast<double>(i) / static_cast<double>(bins));
+        return b;
+    }
+
+    static Binning log(double lo, double hi, std::size_t bins) {
+        if (!(0 < lo && lo < hi) || bins == 0) throw std::invalid_argument("hist::Binning::log: needs 0 < lo < hi and at least one bin");
+        Binning b{Kind::log, lo, hi, static_cast<double>(bins) / std::log(hi / lo), bins};
+        for (std::size_t i = 0; i <= bins; ++i) b.edge_values.push_back(lo * std::pow(hi / lo, static_cast<double>(i) / static_cast<double>(bins)));
+        return b;
+    }
+
+    // edges must be strictly increasing, at least two
+    static Binning custom(std::vector<double> edges) {
+        if (edges.size() < 2 || std::adjacent_find(edges.begin(), edges.end(), std::greater_equal<>()) != edges.end())
+            throw std::invalid_argument("hist::Binning::custom: needs at least two strictly increasing edges");
+        Binning b{Kind::custom, edges.front(), edges.back(), 0, edges.size() - 1};
+        b.edge_values = std::move(edges);
+        return b;
+    }
+
+    std::size_t bins() const { return count; }
+    // bin edges, bins() + 1 of them
+    const std::vector<double>& edges() const { return edge_values; }
+
+    // 0 for underflow, 1 + bin, or bins() + 1 for overflow; never decreases as x grows
+    std::size_t slot(double x) const {
+        switch (kind) {
+        case Kind::fixed: return slot_fixed(x);
+        case Kind::log: return slot_log(x);
+        case Kind::custom: return slot_custom(x);
+        }
+        return count + 1;
+    }
+
+    // Calls fn with a slot function specialized for the kind of binning, so that the loop
+    // over the data does not switch on it per element.
+    template <class Fn>
+    decltype(auto) visit(Fn fn) const {
+        switch (kind) {
+        case Kind::fixed: return fn([this](double x) { return slot_fixed(x); });
+        case Kind::log: return fn([this](double x) { return slot_log(x); });
+        case Kind::custom: break;
+        }
+        return fn([this](double x) { return slot_custom(x); });
+    }
+
+private:
+    enum class Kind { fixed, log, custom };
+
+    Binning(Kind kind, double lo, double hi, double scale, std::size_t bins) : kind(kind), lo(lo), hi(hi), scale(scale), count(bins) {}
+
+    std::size_t slot_fixed(double x) const {
+        if (x < lo) return 0;
+        if (!(x < hi)) return count + 1;
+        return 1 + std::min(count - 1, static_cast<std::size_t>((x - lo) * scale));
+    }
+    std::size_t slot_log(double x) const {
+        if (x < lo) return 0;
+        if (!(x < hi)) return count + 1;
+        return 1 + std::min(count - 1, static_cast<std::size_t>(std::log(x / lo) * scale));
+    }
+    std::size_t slot_custom(double x) const {
+        return static_cast<std::size_t>(std::upper_bound(edge_values.begin(), edge_values.end(), x) - edge_values.begin());
+    }
+
+    Kind kind;
+    double lo, hi, scale;
+    std::size_t count;
+    std::vector<double> edge_values;
+};
+
+struct Histogram {
+    std::vector<std::uint64_t> counts;
+    std::uint64_t underflow = 0;
+    std::uint64_t overflow = 0;
+
+    std::uint64_t total() const { return std::accumulate(counts.begin(), counts.end(), underflow + overflow); }
+};
+
+inline constexpr std::size_t simd_max_bins = 16;
+
+// Count kernels of the SIMD path: out[j] += number of elements of p[0, n) greater than t[j],
+// for j < 8. n must stay below 2^32 / 8 so the 32-bit lanes cannot overflow.
+namespace baseline {
+
+inline void count_greater8(const std::int32_t* p, std::size_t n, const std::int32_t* t, std::uint64_t* out) {
+    for (int j = 0; j < 8; ++j) {
+        std::uint32_t c = 0;
+        for (std::size_t i = 0; i < n; ++i) c += p[i] > t[j];
+        out[j] += c;
+    }
+}
+
+} // namespace baseline
+
+#if HAS_X86_SIMD
+namespace avx2 {
+
+#define TARGET SIMD_TARGET("avx2")
+
+TARGET inline void count_greater8(const std::int32_t* p, std::size_t n, const std::int32_t* t, std::uint64_t* out) {
+    const __m256i t0 = _mm256_set1_epi32(t[0]), t1 = _mm256_set1_epi32(t[1]), t2 = _mm256_set1_epi32(t[2]), t3 = _mm256_set1_epi32(t[3]);
+    const __m256i t4 = _mm256_set1_epi32(t[4]), t5 = _mm256_set1_epi32(t[5]), t6 = _mm256_set1_epi32(t[6]), t7 = _mm256_set1_epi32(t[7]);
+    __m256i a0 = _mm256_setzero_si256(), a1 = a0, a2 = a0, a3 = a0, a4 = a0, a5 = a0, a6 = a0, a7 = a0;
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+        a0 = _mm256_sub_epi32(a0, _mm256_cmpgt_epi32(v, t0));  // true is -1
+        a1 = _mm256_sub_epi32(a1, _mm256_cmpgt_epi32(v, t1));
+        a2 = _mm256_sub_epi32(a2, _mm256_cmpgt_epi32(v, t2));
+        a3 = _mm256_sub_epi32(a3, _mm256_cmpgt_epi32(v, t3));
+        a4 = _mm256_sub_epi32(a4, _mm256_cmpgt_epi32(v, t4));
+        a5 = _mm256_sub_epi32(a5, _mm256_cmpgt_epi32(v, t5));
+        a6 = _mm256_sub_epi32(a6, _mm256_cmpgt_epi32(v, t6));
+        a7 = _mm256_sub_epi32(a7, _mm256_cmpgt_epi32(v, t7));
+    }
+    const __m256i acc[8] = {a0, a1, a2, a3, a4, a5, a6, a7};
+    for (int j = 0; j < 8; ++j) {
+        alignas(32) std::uint32_t lanes[8];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), acc[j]);
+        std::uint64_t c = 0;
+        for (std::uint32_t lane : lanes) c += lane;
+        for (std::size_t k = i; k < n; ++k) c += p[k] > t[j];
+        out[j] += c;
+    }
+}
+
+#undef TARGET
+
+} // namespace avx2
+#endif // HAS_X86_SIMD
+
+namespace detail {
+
+using CountGreater8 = void (*)(const std::int32_t*, std::size_t, const std::int32_t*, std::uint64_t*);
+
+inline CountGreater8 count_greater8() {
+#if HAS_X86_SIMD
+    const auto levels = simd::supported_levels();
+    if (std::find(levels.begin(), levels.end(), simd::Isa::avx2) != levels.end()) return avx2::count_greater8;
+#endif
+    return baseline::count_greater8;
+}
+
+// Sums the per-task slot counts into a Histogram.
+inline Histogram merge(const std::vector<std::vector<std::uint64_t>>& slots, std::size_t bins) {
+    std::vector<std::uint64_t> total(bins + 2, 0);
+    for (const auto& s : slots)
+        for (std::size_t i = 0; i < total.size(); ++i) total[i] += s[i];
+    return Histogram{std::vector<std::uint64_t>(total.begin() + 1, total.end() - 1), total.front(), total.back()};
+}
+
+// Slots of int32 data through the edge counts of the SIMD path.
+inline Histogram histogram_int32(const exec::pool_policy& policy, std::span<const std::int32_t> data, const Binning& binning) {
+    const std::size_t bins = binning.bins();
+    constexpr std::int64_t min = std::numeric_limits<std::int32_t>::min(), max = std::numeric_limits<std::int32_t>::max();
+
+    // at[j]: the smallest int with slot >= j + 1 (max + 1 if there is none), by bisection
+    std::vector<std::int64_t> at(bins + 1);
+    for (std::size_t j = 0; j <= bins; ++j) {
+        std::int64_t lo = min, hi = max + 1;
+        while (lo < hi) {
+            const std::int64_t mid = lo + (hi - lo) / 2;
+            if (binning.slot(static_cast<double>(mid)) >= j + 1) hi = mid;
+            else lo = mid + 1;
+        }
+        at[j] = lo;
+    }
+    // x >= at[j] is x > at[j] - 1; at[j] == min would need min - 1, but then every element counts
+    const std::size_t groups = (at.size() + 7) / 8;
+    std::vector<std::int32_t> greater(groups * 8, static_cast<std::int32_t>(max));  // padding counts nothing
+    for (std::size_t j = 0; j < at.size(); ++j) greater[j] = static_cast<std::int32_t>(std::max(at[j], min + 1) - 1);
+
+    const CountGreater8 kernel = count_greater8();
+    const std::size_t n = data.size();
+    const std::size_t chunks = exec::task_count(policy, n);
+    std::vector<std::vector<std::uint64_t>> at_least(chunks);
+    exec::for_each_chunk(policy, n, chunks, [&](std::size_t c, std::size_t b, std::size_t e) {
+        constexpr std::size_t block = 4096;  // 16 KiB, reread from L1 once per group of 8 edges
+        std::vector<std::uint64_t> counts(groups * 8, 0);
+        for (std::size_t i = b; i < e; i += block)
+            for (std::size_t g = 0; g < groups; ++g) kernel(data.data() + i, std::min(block, e - i), greater.data() + 8 * g, counts.data() + 8 * g);
+        at_least[c] = std::move(counts);
+    });
+
+    std::vector<std::uint64_t> ge(bins + 1, 0);  // elements with slot >= j + 1
+    for (const auto& counts : at_least)
+        for (std::size_t j = 0; j <= bins; ++j) ge[j] += counts[j];
+    for (std::size_t j = 0; j <= bins; ++j)
+        if (at[j] == min) ge[j] = n;
+    Histogram h;
+    h.underflow = n - ge[0];
+    for (std::size_t j = 0; j < bins; ++j) h.counts.push_back(ge[j] - ge[j + 1]);
+    h.overflow = ge[bins];
+    return h;
+}
+
+} // namespace detail
+
+// Counts data into the bins of 'binning' on the pool. use_simd = false forces the scalar
+// path for int32 data with few bins (for comparisons).
+template <class T>
+Histogram histogram(const exec::pool_policy& policy, std::span<const T> data, const Binning& binning, bool use_simd = true) {
+    if constexpr (std::is_same_v<T, std::int32_t>)
+        if (use_simd && binning.bins() <= simd_max_bins) return detail::histogram_int32(policy, data, binning);
+
+    const std::size_t n = data.size();
+    const std::size_t chunks = exec::task_count(policy, n);
+    std::vector<std::vector<std::uint64_t>> slots(chunks);
+    binning.visit([&](auto slot_of) {
+        exec::for_each_chunk(policy, n, chunks, [&](std::size_t c, std::size_t b, std::size_t e) {
+            // four interleaved copies of the slots, so that runs of equal values do not wait on
+            // the store of the previous increment; allocated by the thread that fills them
+            const std::size_t width = binning.bins() + 2;
+            std::vector<std::uint64_t> local(4 * width, 0);
+            std::uint64_t* copy[4] = {local.data(), local.data() + width, local.data() + 2 * width, local.data() + 3 * width};
+            std::size_t i = b;
+            for (; i + 4 <= e; i += 4)
+                for (std::size_t k = 0; k < 4; ++k) ++copy[k][slot_of(static_cast<double>(data[i + k]))];
+            for (; i < e; ++i) ++copy[0][slot_of(static_cast<double>(data[i]))];
+            for (std::size_t k = 1; k < 4; ++k)
+                for (std::size_t s = 0; s < width; ++s) local[s] += copy[k][s];
+            local.resize(width);
+            slots[c] = std::move(local);
+        });
+    });
+    return detail::merge(slots, binning.bins());
+}
+
+} // namespace hist
+
+// Histograms of 1M ints in [0, bins), one value per bin so that a bin count is what
+// std::count of that value returns: repeated std::count(par), one pass per bin, shared
+// atomic bins updated from std::for_each(par), and hist::histogram with the scalar and the
+// SIMD path. Then a log-scale histogram of log-normal "latencies" in doubles, printed.
+void histogram_benchmark(bench::Runner& runner) {
+    std::cout << "\n[histogram_benchmark]" << std::endl;
+
+    constexpr std::size_t N = 1'000'000;
+    const exec::pool_policy pool = exec::par_on(exec::default_pool());
+    std::mt19937 rng{std::random_device{}()};
+
+    for (std::size_t bins : {4, 16, 64, 256}) {
+        std::vector<std::int32_t> data(N);
+        std::uniform_int_distribution<std::int32_t> value(0, static_cast<std::int32_t>(bins) - 1);
+        for (auto& x : data) x = value(rng);
+        const auto binning = hist::Binning::fixed(0, static_cast<double>(bins), bins);
+        const std::span<const std::int32_t> span{data};
+        const std::string name = "histogram " + std::to_string(bins) + " bins";
+
+        std::vector<std::uint64_t> expected(bins);
+        for (std::size_t b = 0; b < bins; ++b) expected[b] = static_cast<std::uint64_t>(std::count(data.begin(), data.end(), static_cast<std::int32_t>(b)));
+        if (hist::histogram(pool, span, binning, false).counts != expected || hist::histogram(pool, span, binning).counts != expected)
+            throw std::runtime_error(name + ": hist::histogram disagrees with std::count");
+
+        runner.run(name, "repeated std::count(par)", N, [&] {
+            for (std::size_t b = 0; b < bins; ++b) bench::do_not_optimize(std::count(std::execution::par, data.begin(), data.end(), static_cast<std::int32_t>(b)));
+        });
+        std::vector<std::atomic<std::uint64_t>> shared(bins + 2);
+        runner.run(name, "shared atomic bins (par)", N, [&] {
+            std::for_each(std::execution::par, data.begin(), data.end(), [&](std::int32_t x) {
+                shared[binning.slot(x)].fetch_add(1, std::memory_order_relaxed);
+            });
+        });
+        runner.run(name, "hist privatized", N, [&] { bench::do_not_optimize(hist::histogram(pool, span, binning, false)); });
+        if (bins <= hist::simd_max_bins)
+            runner.run(name, "hist privatized simd", N, [&] { bench::do_not_optimize(hist::histogram(pool, span, binning)); });
+    }
+
+    // latencies around 1 ms, three bins per decade from 1 us to 1 s
+    std::vector<double> latency(N);
+    std::lognormal_distribution<double> lognormal(std::log(1e-3), 1.5);
+    for (auto& x : latency) x = lognormal(rng);
+    const auto log_bins = hist::Binning::log(1e-6, 1.0, 18);
+    const std::span<const double> latencies{latency};
+    runner.run("histogram log-scale 18 bins", "hist privatized", N, [&] { bench::do_not_optimize(hist::histogram(pool, latencies, log_bins)); });
+    const auto custom_bins = hist::Binning::custom({0, 1e-4, 1e-3, 2e-3, 5e-3, 1e-2, 1e-1, 1});
+    runner.run("histogram custom 7 bins", "hist privatized", N, [&] { bench::do_not_optimize(hist::histogram(pool, latencies, custom_bins)); });
+
+    const hist::Histogram h = hist::histogram(pool, latencies, log_bins);
+    const std::uint64_t widest = std::max(*std::max_element(h.counts.begin(), h.counts.end()), std::uint64_t{1});
+    std::cout << "log-normal latencies, " << h.underflow << " below 1 us, " << h.overflow << " at or above 1 s:" << std::endl;
+    for (std::size_t b = 0; b < h.counts.size(); ++b) {
+        std::ostringstream row;
+        row << std::scientific << std::setprecision(1) << std::setw(9) << log_bins.edges()[b] << " s " << std::setw(8) << h.counts[b] << ' '
+            << std::string(static_cast<std::size_t>(50 * h.counts[b] / widest), '#');
+        std::cout << row.str() << std::endl;
+    }
+}
+
+/*
+    Stable stream compaction
+
+    std::copy_if appends one element at a time, so it runs on one thread, and its parallel
+    form does not say how it keeps the order. compact::copy_if and compact::remove_if run on
+    the pool in three steps and keep the input order (stable):
+
+    1. every chunk counts its matches,
+    2. a prefix sum of the counts gives every chunk the offset of its first output,
+    3. every chunk copies its matches to its own part of the output.
+
+    For contiguous ranges of 4- or 8-byte trivially copyable types (int, float, int64_t,
+    double, ...) step 1 also stores the predicate as one byte per element, and step 3 is a
+    SIMD compress of those flags: AVX-512 packs the selected lanes with vpcompressd/q, AVX2
+    with a permutation looked up from the 8-bit lane mask (vpermd). The predicate is then
+    evaluated once per element, in a loop the compiler can vectorize, and the scatter has no
+    branches at any selectivity. A compress stores whole vectors, so each chunk switches to
+    the scalar loop before a store would cross into the output of the next chunk.
+
+    The output must be random access (no back_inserter): the offsets are computed before
+    anything is written. remove_if compacts into a buffer and moves the result back.
+*/
+namespace compact {
+
+// Compress kernels: copy the elements of in[0, n) (Size bytes each) whose flag is nonzero
+// to out, in input order. 'count' is the number of nonzero flags, the room there is in out.
+using Compress = void (*)(const void* in, const std::uint8_t* flags, std::size_t n, void* out, std::size_t count);
+
+namespace baseline {
+
+template <std::size_t Size>
+void compress(const void* in, const std::uint8_t* flags, std::size_t n, void* out, std::size_t) {
+    const auto* src = static_cast<const unsigned char*>(in);
+    auto* dst = static_cast<unsigned char*>(out);
+    for (std::size_t i = 0; i < n; ++i)
+        if (flags[i]) {
+            std::memcpy(dst, src + i * Size, Size);
+            dst += Size;
+        }
+}
+
+} // namespace baseline
+
+#if HAS_X86_SIMD
+namespace avx2 {
+
+#define TARGET SIMD_TARGET("avx2")
+
+// Byte k of lut[mask]: index of the k-th set lane of an 8 x 32-bit mask.
+constexpr std::array<std::uint64_t, 256> lane_lut32() {
+    std::array<std::uint64_t, 256> lut{};
+    for (unsigned mask = 0; mask < 256; ++mask) {
+        unsigned k = 0;
+        for (unsigned lane = 0; lane < 8; ++lane)
+            if (mask & (1u << lane)) lut[mask] |= std::uint64_t{lane} << (8 * k++);
+    }
+    return lut;
+}
+// The same for 4 x 64-bit lanes, as pairs of 32-bit lanes.
+constexpr std::array<std::uint64_t, 16> lane_lut64() {
+    std::array<std::uint64_t, 16> lut{};
+    for (unsigned mask = 0; mask < 16; ++mask) {
+        unsigned k = 0;
+        for (unsigned lane = 0; lane < 4; ++lane)
+            if (mask & (1u << lane)) {
+                lut[mask] |= std::uint64_t{2 * lane} << (8 * k++);
+                lut[mask] |= std::uint64_t{2 * lane + 1} << (8 * k++);
+            }
+    }
+    return lut;
+}
+inline constexpr auto lut32 = lane_lut32();
+inline constexpr auto lut64 = lane_lut64();
+
+// Lane mask of flags[0, 8): bit k set if flags[k] is nonzero.
+TARGET inline unsigned flag_mask8(const std::uint8_t* flags) {
+    const __m128i f = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(flags));
+    return static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpgt_epi8(f, _mm_setzero_si128()))) & 0xFF;
+}
+
+template <std::size_t Size>
+TARGET void compress(const void* in, const std::uint8_t* flags, std::size_t n, void* out, std::size_t count) {
+    constexpr std::size_t lanes = 32 / Size;
+    const auto* src = static_cast<const unsigned char*>(in);
+    auto* dst = static_cast<unsigned char*>(out);
+    std::size_t i = 0, written = 0;
+    for (; i + 8 <= n && written + 8 <= count; i += 8) {
+        const unsigned mask = flag_mask8(flags + i);
+        for (std::size_t half = 0; half < 8 / lanes; ++half) {  // one vector of 32-bit lanes, two of 64-bit lanes
+            const unsigned m = (mask >> (half * lanes)) & ((1u << lanes) - 1);
+            const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + (i + half * lanes) * Size));
+            const __m256i idx = _mm256_cvtepu8_epi32(_mm_cvtsi64_si128(static_cast<long long>(Size == 4 ? lut32[m] : lut64[m])));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + written * Size), _mm256_permutevar8x32_epi32(v, idx));
+            written += static_cast<std::size_t>(std::popcount(m));
+        }
+    }
+    baseline::compress<Size>(src + i * Size, flags + i, n - i, dst + written * Size, count - written);
+}
+
+#undef TARGET
+
+} // namespace avx2
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+namespace avx512 {
+
+#define TARGET SIMD_TARGET("avx512f")
+
+template <std::size_t Size>
+TARGET void compress(const void* in, const std::uint8_t* flags, std::size_t n, void* out, std::size_t count) {
+    constexpr std::size_t lanes = 64 / Size;
+    const auto* src = static_cast<const unsigned char*>(in);
+    auto* dst = static_cast<unsigned char*>(out);
+    std::size_t i = 0, written = 0;
+    for (; i + lanes <= n && written + lanes <= count; i += lanes) {
+        const auto* f_ptr = reinterpret_cast<const __m128i*>(flags + i);
+        const __m128i f = lanes == 16 ? _mm_loadu_si128(f_ptr) : _mm_loadl_epi64(f_ptr);  // one flag per lane
+        const auto mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpgt_epi8(f, _mm_setzero_si128()))) & ((1u << lanes) - 1);
+        const __m512i v = _mm512_loadu_si512(src + i * Size);
+        if constexpr (Size == 4) _mm512_storeu_si512(dst + written * Size, _mm512_maskz_compress_epi32(static_cast<__mmask16>(mask), v));
+        else _mm512_storeu_si512(dst + written * Size, _mm512_maskz_compress_epi64(static_cast<__mmask8>(mask), v));
+        written += static_cast<std::size_t>(std::popcount(mask));
+    }
+    baseline::compress<Size>(src + i * Size, flags + i, n - i, dst + written * Size, count - written);
+}
+
+#undef TARGET
+
+} // namespace avx512
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#endif // HAS_X86_SIMD
+
+// Compress kernel of the highest supported level for Size-byte elements.
+template <std::size_t Size>
+Compress best_compress() {
+#if HAS_X86_SIMD
+    switch (simd::supported_levels().back()) {
+    case simd::Isa::avx512: return avx512::compress<Size>;
+    case simd::Isa::avx2: return avx2::compress<Size>;
+    default: break;
+    }
+#endif
+    return baseline::compress<Size>;
+}
+
+// Stable copy_if on the pool; returns the end of the output. use_simd = false forces the
+// generic path (for comparisons).
+template <class It, class OutIt, class Pred>
+OutIt copy_if(const exec::pool_policy& policy, It first, It last, OutIt out, Pred pred, bool use_simd = true) {
+    using T = std::iter_value_t<It>;
+    const auto n = static_cast<std::size_t>(last - first);
+    const std::size_t chunks = exec::task_count(policy, n);
+    std::vector<std::size_t> offset(chunks + 1, 0);  // offset[c + 1]: matches in chunk c, then prefix-summed
+    auto prefix_sum = [&] { std::partial_sum(offset.begin(), offset.end(), offset.begin()); };
+
+    constexpr bool compressible = std::contiguous_iterator<It> && std::contiguous_iterator<OutIt> && std::is_same_v<std::iter_value_t<OutIt>, T> &&
+                                  std::is_trivially_copyable_v<T> && (sizeof(T) == 4 || sizeof(T) == 8);
+    if constexpr (compressible) {
+        if (use_simd) {
+            const auto flags = std::make_unique_for_overwrite<std::uint8_t[]>(n);
+            exec::for_each_chunk(policy, n, chunks, [&](std::size_t c, std::size_t b, std::size_t e) {
+                std::size_t count = 0;
+                for (std::size_t i = b; i < e; ++i) {
+                    flags[i] = pred(first[static_cast<std::ptrdiff_t>(i)]) ? 1 : 0;
+                    count += flags[i];
+                }
+                offset[c + 1] = count;
+            });
+            prefix_sum();
+            static const Compress kernel = best_compress<sizeof(T)>();
+            exec::for_each_chunk(policy, n, chunks, [&](std::size_t c, std::size_t b, std::size_t e) {
+                kernel(std::to_address(first) + b, flags.get() + b, e - b, std::to_address(out) + offset[c], offset[c + 1] - offset[c]);
+            });
+            return out + static_cast<std::ptrdiff_t>(offset[chunks]);
+        }
+    }
+
+    exec::for_each_chunk(policy, n, chunks, [&](std::size_t c, std::size_t b, std::size_t e) {
+        offset[c + 1] = static_cast<std::size_t>(std::count_if(first + static_cast<std::ptrdiff_t>(b), first + static_cast<std::ptrdiff_t>(e), pred));
+    });
+    prefix_sum();
+    exec::for_each_chunk(policy, n, chunks, [&](std::size_t c, std::size_t b, std::size_t e) {
+        std::copy_if(first + static_cast<std::ptrdiff_t>(b), first + static_cast<std::ptrdiff_t>(e), out + static_cast<std::ptrdiff_t>(offset[c]), pred);
+    });
+    return out + static_cast<std::ptrdiff_t>(offset[chunks]);
+}
+
+// Stable remove_if on the pool; returns the new end of the range.
+template <class It, class Pred>
+It remove_if(const exec::pool_policy& policy, It first, It last, Pred pred, bool use_simd = true) {
+    std::vector<std::iter_value_t<It>> kept(static_cast<std::size_t>(last - first));
+    const auto kept_end = compact::copy_if(policy, first, last, kept.begin(), [&](const auto& x) { return !pred(x); }, use_simd);
+    kept.erase(kept_end, kept.end());
+    exec::detail::move_back(policy, kept, first);
+    return first + static_cast<std::ptrdiff_t>(kept.size());
+}
+
+} // namespace compact
+
+// Compaction of 16M ints in [0, 1000) at selectivities from 1% to 99%: std::copy_if into a
+// back_inserter (as in lambda.cpp) and into a sized output, std::copy_if(par), and
+// compact::copy_if with the generic and the SIMD compress path; then 16M doubles at 50%
+// for the 8-byte kernels, and remove_if. Every compact result is checked against std.
+void compaction_benchmark(bench::Runner& runner) {
+    std::cout << "\n[compaction_benchmark]" << std::endl;
+
+    constexpr std::size_t N = std::size_t{1} << 24;
+    const exec::pool_policy pool = exec::par_on(exec::default_pool());
+    std::vector<int> ints(N);
+    rng::generate(pool, ints.begin(), ints.end(), 5, [](rng::Philox& engine) { return static_cast<int>(rng::bounded(engine, 1000)); });
+    std::vector<int> out(N), expected(N);
+
+    for (int percent : {1, 10, 50, 90, 99}) {
+        const int limit = percent * 10;
+        auto keep = [limit](int x) { return x < limit; };
+        const std::string name = "copy_if int32 " + std::to_string(percent) + "% kept";
+
+        expected.erase(std::copy_if(ints.begin(), ints.end(), expected.begin(), keep), expected.end());
+        for (bool simd : {false, true})
+            if (!std::equal(out.begin(), compact::copy_if(pool, ints.begin(), ints.end(), out.begin(), keep, simd), expected.begin(), expected.end()))
+                throw std::runtime_error(name + ": compact::copy_if differs from std::copy_if");
+        expected.resize(N);
+
+        runner.set_bytes_per_call(N * sizeof(int) * (100 + static_cast<std::size_t>(percent)) / 100);
+        runner.run(name, "std::copy_if back_inserter", N, [&] {
+            std::vector<int> filtered;
+            std::copy_if(ints.begin(), ints.end(), std::back_inserter(filtered), keep);
+            bench::do_not_optimize(filtered.data());
+        });
+        runner.run(name, "std::copy_if", N, [&] { bench::do_not_optimize(std::copy_if(ints.begin(), ints.end(), out.begin(), keep)); });
+        runner.run(name, "std::copy_if(par)", N, [&] { bench::do_not_optimize(std::copy_if(std::execution::par, ints.begin(), ints.end(), out.begin(), keep)); });
+        runner.run(name, "compact generic", N, [&] { bench::do_not_optimize(compact::copy_if(pool, ints.begin(), ints.end(), out.begin(), keep, false)); });
+        runner.run(name, "compact simd", N, [&] { bench::do_not_optimize(compact::copy_if(pool, ints.begin(), ints.end(), out.begin(), keep)); });
+    }
+
+    std::vector<double> doubles(N), double_out(N);
+    std::transform(ints.begin(), ints.end(), doubles.begin(), [](int x) { return x * 0.5; });
+    auto half = [](double x) { return x < 250.0; };
+    const auto expected_end = std::copy_if(doubles.begin(), doubles.end(), double_out.begin(), half);
+    const std::vector<double> expected_doubles(double_out.begin(), expected_end);
+    std::fill(double_out.begin(), double_out.end(), 0.0);
+    if (!std::equal(double_out.begin(), compact::copy_if(pool, doubles.begin(), doubles.end(), double_out.begin(), half), expected_doubles.begin(), expected_doubles.end()))
+        throw std::runtime_error("copy_if double: compact::copy_if differs from std::copy_if");
+    runner.set_bytes_per_call(N * sizeof(double) * 3 / 2);
+    runner.run("copy_if double 50% kept", "std::copy_if", N, [&] { bench::do_not_optimize(std::copy_if(doubles.begin(), doubles.end(), double_out.begin(), half)); });
+    runner.run("copy_if double 50% kept", "std::copy_if(par)", N, [&] { bench::do_not_optimize(std::copy_if(std::execution::par, doubles.begin(), doubles.end(), double_out.begin(), half)); });
+    runner.run("copy_if double 50% kept", "compact simd", N, [&] { bench::do_not_optimize(compact::copy_if(pool, doubles.begin(), doubles.end(), double_out.begin(), half)); });
+    runner.set_bytes_per_call(0);
+
+    // remove_if works in place, so every call starts from a fresh copy
+    auto odd = [](int x) { return x % 2 != 0; };
+    std::vector<int> work(N);
+    auto reset = [&] { std::copy(ints.begin(), ints.end(), work.begin()); };
+    reset();
+    std::vector<int> kept(work.begin(), compact::remove_if(pool, work.begin(), work.end(), odd));
+    if (kept != std::vector<int>(expected.begin(), std::remove_copy_if(ints.begin(), ints.end(), expected.begin(), odd)))
+        throw std::runtime_error("remove_if int32: compact::remove_if differs from std::remove_if");
+    bench::compare(runner, "remove_if int32 (odd)", N, reset,
+        [&] { bench::do_not_optimize(std::remove_if(work.begin(), work.end(), odd)); },
+        [&] { bench::do_not_optimize(std::remove_if(std::execution::par, work.begin(), work.end(), odd)); },
+        [&] { bench::do_not_optimize(compact::remove_if(pool, work.begin(), work.end(), odd)); });
+}
+
+/*
+    Matrix multiply (GEMM)
+
+    dot_product_and_norm multiplies two vectors; C += A * B is the same dot product taken
+    m * n times over rows of A and columns of B. Written as that triple loop it runs at
+    memory speed: every multiply-add loads one element of B from a column k elements apart,
+    so the loop touches a new cache line per flop once B outgrows the cache. gemm::gemm
+    follows the blocking of BLIS/GotoBLAS instead:
+
+    - the k dimension is cut into panels of kc and n into blocks of nc; per (nc, kc) block
+      B is copied ("packed") into slivers of nr columns, each stored row after row, so the
+      micro-kernel reads it contiguously and one sliver (kc * nr) stays in L1,
+    - A is packed the same way into slivers of mr rows, stored column after column, and an
+      mc * kc block of them stays in L2 while the slivers of B stream past,
+    - the micro-kernel keeps an mr * nr tile of C in vector registers (mr broadcasts of A
+      times nr / width vectors of B per step of k) and touches C once per panel.
+
+    The tile sizes come from the registers (6 x 2 AVX2 vectors, 8 x 2 AVX-512 vectors, so
+    both fill 12 to 16 of the accumulator registers) and kc, mc and nc from cache_sizes().
+    Threads split each packed block into macro-tiles of mc rows by a few slivers of
+    columns, so skinny shapes (one of m or n small) still give every thread work; packing
+    is split by slivers as well. Edge tiles run the same kernel on a zero-padded buffer.
+    Matrices are row-major with leading dimensions lda/ldb/ldc, as in cblas with
+    CblasRowMajor and no transposes.
+*/
+namespace gemm {
+
+using simd::Isa;
+
+template <class T>
+struct Kernel {
+    Isa isa;
+    std::size_t mr, nr;
+    // c[0, mr) x [0, nr) (row stride ldc) += alpha * a * b, with a packed as kc columns of
+    // mr and b as kc rows of nr
+    void (*micro)(std::size_t kc, const T* a, const T* b, T* c, std::size_t ldc, T alpha);
+    // multiply-adds per second that one thread sustains in registers
+    double (*fma_rate)();
+};
+
+// Multiply-add rate of a loop over 'chains' independent accumulators of 'width' lanes.
+template <class Step>
+double measure_fma_rate(std::size_t width, std::size_t chains, Step step) {
+    constexpr std::size_t iterations = std::size_t{1} << 22;
+    const auto start = std::chrono::steady_clock::now();
+    step(iterations);
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return static_cast<double>(iterations * width * chains) / elapsed.count();
+}
 
-    std::vector<int> vec(1'000'000);
+#if defined(__GNUC__)
+#define GEMM_UNROLL _Pragma("GCC unroll 16")
+#else
+#define GEMM_UNROLL
+#endif
+
+namespace baseline {
+
+constexpr std::size_t mr = 4, nr = 4;
+
+template <class T>
+void micro(std::size_t kc, const T* a, const T* b, T* c, std::size_t ldc, T alpha) {
+    T acc[mr][nr] = {};
+    for (std::size_t p = 0; p < kc; ++p, a += mr, b += nr)
+        GEMM_UNROLL for (std::size_t i = 0; i < mr; ++i)
+            GEMM_UNROLL for (std::size_t j = 0; j < nr; ++j) acc[i][j] += a[i] * b[j];
+    for (std::size_t i = 0; i < mr; ++i)
+        for (std::size_t j = 0; j < nr; ++j) c[i * ldc + j] += alpha * acc[i][j];
+}
+
+template <class T>
+double fma_rate() {
+    return measure_fma_rate(1, 8, [](std::size_t iterations) {
+        T acc[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+        const T x = T(0.999999), y = T(1e-6);
+        for (std::size_t it = 0; it < iterations; ++it)
+            GEMM_UNROLL for (auto& v : acc) v = v * x + y;
+        bench::do_not_optimize(acc);
+    });
+}
+
+} // namespace baseline
+
+#if HAS_X86_SIMD
+// The micro-kernel and the peak loop over a vector type V (load, broadcast, fma, ...), for
+// both SIMD levels; TARGET is the level's target attribute.
+#define GEMM_SIMD_KERNELS                                                                                  \
+    template <class V, std::size_t MR, std::size_t NV>                                                     \
+    TARGET void micro(std::size_t kc, const typename V::T* a, const typename V::T* b, typename V::T* c,    \
+                      std::size_t ldc, typename V::T alpha) {                                              \
+        constexpr std::size_t nr = NV * V::width;                                                          \
+        typename V::R acc[MR][NV];                                                                         \
+        GEMM_UNROLL for (std::size_t i = 0; i < MR; ++i)                                                   \
+            GEMM_UNROLL for (std::size_t v = 0; v < NV; ++v) acc[i][v] = V::zero();                        \
+        for (std::size_t p = 0; p < kc; ++p, a += MR, b += nr) {                                           \
+            typename V::R bv[NV];                                                                          \
+            GEMM_UNROLL for (std::size_t v = 0; v < NV; ++v) bv[v] = V::load(b + v * V::width);            \
+            GEMM_UNROLL for (std::size_t i = 0; i < MR; ++i) {                                             \
+                const typename V::R av = V::broadcast(a[i]);                                               \
+                GEMM_UNROLL for (std::size_t v = 0; v < NV; ++v) acc[i][v] = V::fma(av, bv[v], acc[i][v]); \
+            }                                                                                              \
+        }                                                                                                  \
+        const typename V::R va = V::broadcast(alpha);                                                      \
+        GEMM_UNROLL for (std::size_t i = 0; i < MR; ++i)                                                   \
+            GEMM_UNROLL for (std::size_t v = 0; v < NV; ++v) {                                             \
+                typename V::T* ci = c + i * ldc + v * V::width;                                            \
+                V::store(ci, V::fma(va, acc[i][v], V::load(ci)));                                          \
+            }                                                                                              \
+    }                                                                                                      \
+                                                                                                           \
+    template <class V>                                                                                     \
+    TARGET void fma_loop(std::size_t iterations) {                                                         \
+        typename V::R acc[12];                                                                             \
+        GEMM_UNROLL for (std::size_t i = 0; i < 12; ++i) acc[i] = V::broadcast(typename V::T(i));          \
+        const typename V::R x = V::broadcast(typename V::T(0.999999)), y = V::broadcast(typename V::T(1e-6)); \
+        for (std::size_t it = 0; it < iterations; ++it)                                                    \
+            GEMM_UNROLL for (std::size_t i = 0; i < 12; ++i) acc[i] = V::fma(acc[i], x, y);                \
+        typename V::T out[V::width];                                                                       \
+        GEMM_UNROLL for (std::size_t i = 1; i < 12; ++i) acc[0] = V::fma(acc[0], x, acc[i]);               \
+        V::store(out, acc[0]);                                                                             \
+        bench::do_not_optimize(out);                                                                       \
+    }                                                                                                      \
+                                                                                                           \
+    template <class V>                                                                                     \
+    double fma_rate() { return measure_fma_rate(V::width, 12, fma_loop<V>); }
+
+namespace avx2 {
+
+#define TARGET SIMD_TARGET("avx2,fma")
+
+struct F64 {
+    using T = double;
+    using R = __m256d;
+    static constexpr std::size_t width = 4;
+    TARGET static R zero() { return _mm256_setzero_pd(); }
+    TARGET static R load(const T* p) { return _mm256_loadu_pd(p); }
+    TARGET static void store(T* p, R v) { _mm256_storeu_pd(p, v); }
+    TARGET static R broadcast(T x) { return _mm256_set1_pd(x); }
+    TARGET static R fma(R a, R b, R c) { return _mm256_fmadd_pd(a, b, c); }
+};
+
+struct F32 {
+    using T = float;
+    using R = __m256;
+    static constexpr std::size_t width = 8;
+    TARGET static R zero() { return _mm256_setzero_ps(); }
+    TARGET static R load(const T* p) { return _mm256_loadu_ps(p); }
+    TARGET static void store(T* p, R v) { _mm256_storeu_ps(p, v); }
+    TARGET static R broadcast(T x) { return _mm256_set1_ps(x); }
+    TARGET static R fma(R a, R b, R c) { return _mm256_fmadd_ps(a, b, c); }
+};
+
+constexpr std::size_t mr = 6, nv = 2;
+
+GEMM_SIMD_KERNELS
+
+#undef TARGET
+
+} // namespace avx2
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+namespace avx512 {
+
+#define TARGET SIMD_TARGET("avx512f")
+
+struct F64 {
+    using T = double;
+    using R = __m512d;
+    static constexpr std::size_t width = 8;
+    TARGET static R zero() { return _mm512_setzero_pd(); }
+    TARGET static R load(const T* p) { return _mm512_loadu_pd(p); }
+    TARGET static void store(T* p, R v) { _mm512_storeu_pd(p, v); }
+    TARGET static R broadcast(T x) { return _mm512_set1_pd(x); }
+    TARGET static R fma(R a, R b, R c) { return _mm512_fmadd_pd(a, b, c); }
+};
+
+struct F32 {
+    using T = float;
+    using R = __m512;
+    static constexpr std::size_t width = 16;
+    TARGET static R zero() { return _mm512_setzero_ps(); }
+    TARGET static R load(const T* p) { return _mm512_loadu_ps(p); }
+    TARGET static void store(T* p, R v) { _mm512_storeu_ps(p, v); }
+    TARGET static R broadcast(T x) { return _mm512_set1_ps(x); }
+    TARGET static R fma(R a, R b, R c) { return _mm512_fmadd_ps(a, b, c); }
+};
+
+constexpr std::size_t mr = 8, nv = 2;
+
+GEMM_SIMD_KERNELS
+
+#undef TARGET
+
+} // namespace avx512
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#undef GEMM_SIMD_KERNELS
+#endif // HAS_X86_SIMD
+#undef GEMM_UNROLL
+
+// Kernel of one level (one of blas1::supported_levels(); SSE2 has no FMA and uses baseline).
+template <class T>
+Kernel<T> kernel(Isa isa) {
+    const auto levels = blas1::supported_levels();
+    if (std::find(levels.begin(), levels.end(), isa) == levels.end())
+        throw std::runtime_error(std::string{"gemm: "} + simd::to_string(isa) + " is not supported on this machine");
+#if HAS_X86_SIMD
+    using V2 = std::conditional_t<std::is_same_v<T, float>, avx2::F32, avx2::F64>;
+    using V512 = std::conditional_t<std::is_same_v<T, float>, avx512::F32, avx512::F64>;
+    if (isa == Isa::avx512)
+        return {isa, avx512::mr, avx512::nv * V512::width, avx512::micro<V512, avx512::mr, avx512::nv>, avx512::fma_rate<V512>};
+    if (isa == Isa::avx2)
+        return {isa, avx2::mr, avx2::nv * V2::width, avx2::micro<V2, avx2::mr, avx2::nv>, avx2::fma_rate<V2>};
+#endif
+    return {Isa::baseline, baseline::mr, baseline::nr, baseline::micro<T>, baseline::fma_rate<T>};
+}
+
+template <class T>
+const Kernel<T>& best() {
+    static const Kernel<T> k = gemm::kernel<T>(blas1::supported_levels().back());
+    return k;
+}
+
+// kc, mc and nc for a kernel: a kc x nr sliver of B fills half of L1, an mc x kc block of
+// A half of L2 and a kc x nc block of B half of the last level.
+struct Blocking {
+    std::size_t kc, mc, nc;
+};
+
+template <class T>
+Blocking blocking(const Kernel<T>& k) {
+    static const auto caches = cache_sizes();
+    const std::size_t kc = std::clamp<std::size_t>(caches[0] / 2 / (k.nr * sizeof(T)), 64, 1024);
+    const std::size_t mc = std::clamp<std::size_t>(caches[1] / 2 / (kc * sizeof(T)) / k.mr, 1, 64) * k.mr;
+    const std::size_t nc = std::clamp<std::size_t>(caches[2] / 2 / (kc * sizeof(T)) / k.nr, 1, 512) * k.nr;
+    return {kc, mc, nc};
+}
+
+// C = alpha * A * B + beta * C for row-major A (m x k), B (k x n) and C (m x n).
+template <class T>
+void gemm(const exec::pool_policy& policy, std::size_t m, std::size_t n, std::size_t k, T alpha, const T* A, std::size_t lda,
+          const T* B, std::size_t ldb, T beta, T* C, std::size_t ldc, const Kernel<T>& kern = best<T>()) {
+    static_assert(std::is_same_v<T, float> || std::is_same_v<T, double>);
+    if (m == 0 || n == 0) return;
+    exec::ThreadPool& pool = *policy.pool;
+    if (beta != T(1))
+        pool.parallel_for(m, [&](std::size_t i) {
+            for (std::size_t j = 0; j < n; ++j) C[i * ldc + j] = beta == T(0) ? T(0) : beta * C[i * ldc + j];
+        });
+    if (k == 0 || alpha == T(0)) return;
+
+    const std::size_t mr = kern.mr, nr = kern.nr;
+    const auto [kc_max, mc, nc_max] = blocking(kern);
+    const std::size_t a_slivers = (m + mr - 1) / mr;
+    std::vector<T> a_pack(a_slivers * mr * kc_max);
+    std::vector<T> b_pack((std::min(n, nc_max) + nr - 1) / nr * nr * kc_max);
+
+    for (std::size_t jc = 0; jc < n; jc += nc_max) {
+        const std::size_t nc = std::min(nc_max, n - jc);
+        const std::size_t b_slivers = (nc + nr - 1) / nr;
+        // macro-tiles of mc rows by tile_slivers slivers, about four per thread when the shape allows
+        const std::size_t row_tiles = (m + mc - 1) / mc;
+        const std::size_t col_tiles = std::clamp<std::size_t>(pool.size() * 4 / row_tiles, 1, b_slivers);
+        const std::size_t tile_slivers = (b_slivers + col_tiles - 1) / col_tiles;
+
+        for (std::size_t pc = 0; pc < k; pc += kc_max) {
+            const std::size_t kc = std::min(kc_max, k - pc);
+            pool.parallel_for(b_slivers, [&](std::size_t s) {
+                T* dst = b_pack.data() + s * nr * kc;
+                const std::size_t j0 = jc + s * nr, cols = std::min(nr, n - j0);
+                for (std::size_t p = 0; p < kc; ++p, dst += nr) {
+                    const T* src = B + (pc + p) * ldb + j0;
+                    std::copy(src, src + cols, dst);
+                    std::fill(dst + cols, dst + nr, T(0));
+                }
+            });
+            // A only depends on pc; it is packed again per block of nc only when n > nc
+            pool.parallel_for(a_slivers, [&](std::size_t s) {
+                T* dst = a_pack.data() + s * mr * kc;
+                const std::size_t i0 = s * mr, rows = std::min(mr, m - i0);
+                for (std::size_t p = 0; p < kc; ++p, dst += mr) {
+                    for (std::size_t i = 0; i < rows; ++i) dst[i] = A[(i0 + i) * lda + pc + p];
+                    std::fill(dst + rows, dst + mr, T(0));
+                }
+            });
+
+            pool.parallel_for(row_tiles * col_tiles, [&](std::size_t t) {
+                const std::size_t i_begin = (t / col_tiles) * mc, i_end = std::min(m, i_begin + mc);
+                const std::size_t s_begin = (t % col_tiles) * tile_slivers, s_end = std::min(b_slivers, s_begin + tile_slivers);
+                std::array<T, 8 * 32> edge;  // largest mr * nr
+                for (std::size_t s = s_begin; s < s_end; ++s) {
+                    const T* b = b_pack.data() + s * nr * kc;
+                    const std::size_t j0 = jc + s * nr, cols = std::min(nr, n - j0);
+                    for (std::size_t i0 = i_begin; i0 < i_end; i0 += mr) {
+                        const T* a = a_pack.data() + i0 * kc;
+                        const std::size_t rows = std::min(mr, m - i0);
+                        if (rows == mr && cols == nr) {
+                            kern.micro(kc, a, b, C + i0 * ldc + j0, ldc, alpha);
+                            continue;
+                        }
+                        std::fill(edge.begin(), edge.begin() + static_cast<std::ptrdiff_t>(mr * nr), T(0));
+                        kern.micro(kc, a, b, edge.data(), nr, alpha);
+                        for (std::size_t i = 0; i < rows; ++i)
+                            for (std::size_t j = 0; j < cols; ++j) C[(i0 + i) * ldc + j0 + j] += edge[i * nr + j];
+                    }
+                }
+            });
+        }
+    }
+}
+
+// The triple loop, for reference: C = A * B, one dot product per element.
+template <class T>
+void naive(std::size_t m, std::size_t n, std::size_t k, const T* A, const T* B, T* C) {
+    for (std::size_t i = 0; i < m; ++i)
+        for (std::size_t j = 0; j < n; ++j) {
+            T sum = 0;
+            for (std::size_t p = 0; p < k; ++p) sum += A[i * k + p] * B[p * n + j];
+            C[i * n + j] = sum;
+        }
+}
+
+} // namespace gemm
+
+// GFLOP/s of the naive triple loop and of gemm::gemm (one thread and the pool), float and
+// double, for square shapes and for skinny ones (a few rows times a wide B, a tall A times a
+// few columns, and a small k). The peak is the multiply-add rate of a loop that keeps 12
+// accumulators in registers (2 flops each), per thread times the pool size; it stands in
+// for clock x FMA units x lanes, which the program cannot read portably. The naive loop
+// only runs up to 2^27 multiply-adds; gemm results are checked against it, or against the
+// single-thread gemm above that. The skinny shapes reuse each packed element only a few
+// times, so they run at the speed of packing and of C, well below the square ones.
+template <class T>
+void benchmark_gemm(bench::Runner& runner, const std::string& type) {
+    struct Shape {
+        const char* kind;
+        std::size_t m, n, k;
+    };
+    static constexpr Shape shapes[] = {
+        {"square", 128, 128, 128}, {"square", 512, 512, 512}, {"square", 1024, 1024, 1024},
+        {"wide", 8, 4096, 1024},   {"tall", 4096, 16, 1024},  {"small k", 1024, 1024, 16},
+    };
+
+    const gemm::Kernel<T>& kern = gemm::best<T>();
+    const exec::pool_policy pool = exec::par_on(exec::default_pool());
+    exec::ThreadPool single{1};
+    const exec::pool_policy one = exec::par_on(single);
+    const double thread_peak = 2 * kern.fma_rate() / 1e9;
+    const double pool_peak = thread_peak * pool.pool->size();
+    std::cout << "-- " << type << ": " << simd::to_string(kern.isa) << " micro-kernel " << kern.mr << "x" << kern.nr
+              << ", peak " << std::fixed << std::setprecision(1) << thread_peak << " GFLOP/s per thread, " << pool_peak
+              << " GFLOP/s on " << pool.pool->size() << " threads" << std::defaultfloat << std::endl;
+
+    for (const Shape& s : shapes) {
+        const std::size_t mnk = s.m * s.n * s.k;
+        std::vector<T> A(s.m * s.k), B(s.k * s.n), C(s.m * s.n), reference(s.m * s.n);
+        auto fill = [&](std::vector<T>& v, std::uint64_t seed) {
+            rng::generate(pool, v.begin(), v.end(), seed, [](rng::Philox& engine) { return T(static_cast<int>(rng::bounded(engine, 65536)) - 32768) / T(32768); });
+        };
+        fill(A, 1);
+        fill(B, 2);
+
+        std::ostringstream name;
+        name << "gemm " << type << " " << s.kind << " " << s.m << "x" << s.n << "x" << s.k;
+        const bool run_naive = mnk <= (std::size_t{1} << 27);
+        auto gflops = [&](const bench::Result& r) { return 2.0 * static_cast<double>(mnk) / r.stats.median; };  // flops per ns
+
+        double naive_rate = 0;
+        if (run_naive) {
+            naive_rate = gflops(runner.run(name.str(), "naive triple loop", mnk, [&] {
+                gemm::naive(s.m, s.n, s.k, A.data(), B.data(), reference.data());
+                bench::do_not_optimize(reference.data());
+            }));
+        } else {
+            gemm::gemm(one, s.m, s.n, s.k, T(1), A.data(), s.k, B.data(), s.n, T(0), reference.data(), s.n, kern);
+        }
+        const double one_rate = gflops(runner.run(name.str(), "blocked 1 thread", mnk, [&] {
+            gemm::gemm(one, s.m, s.n, s.k, T(1), A.data(), s.k, B.data(), s.n, T(0), C.data(), s.n, kern);
+            bench::do_not_optimize(C.data());
+        }));
+        const double pool_rate = gflops(runner.run(name.str(), "blocked pool", mnk, [&] {
+            gemm::gemm(pool, s.m, s.n, s.k, T(1), A.data(), s.k, B.data(), s.n, T(0), C.data(), s.n, kern);
+            bench::do_not_optimize(C.data());
+        }));
+
+        // both sum k products of values in [-1, 1), in different orders
+        const double tolerance = 4.0 * static_cast<double>(s.k) * std::numeric_limits<T>::epsilon();
+        for (std::size_t i = 0; i < C.size(); ++i)
+            if (std::abs(static_cast<double>(C[i]) - static_cast<double>(reference[i])) > tolerance)
+                throw std::runtime_error(name.str() + ": blocked result differs from the reference");
+
+        std::cout << "  -> " << std::fixed << std::setprecision(2);
+        if (run_naive) std::cout << "naive " << naive_rate << ", ";
+        std::cout << "blocked " << one_rate << " (" << std::setprecision(0) << 100 * one_rate / thread_peak << "% of peak)"
+                  << std::setprecision(2) << ", pool " << pool_rate << " GFLOP/s (" << std::setprecision(0)
+                  << 100 * pool_rate / pool_peak << "% of peak)";
+        if (run_naive) std::cout << std::setprecision(1) << ", " << pool_rate / naive_rate << "x the naive loop";
+        std::cout << std::defaultfloat << std::endl;
+    }
+}
+
+void gemm_benchmark(bench::Runner& runner) {
+    std::cout << "\n[gemm_benchmark]" << std::endl;
+    const auto [kc, mc, nc] = gemm::blocking(gemm::best<double>());
+    std::cout << "double blocking: kc " << kc << ", mc " << mc << ", nc " << nc << std::endl;
+    benchmark_gemm<float>(runner, "float");
+    benchmark_gemm<double>(runner, "double");
+}
+
+/*
+    Incremental aggregates
+
+    The demos recompute sums, minima and maxima with a full std::reduce (or min_element)
+    over the vector, which is O(n) per query however few elements changed since the last
+    one. The two trees here keep the aggregates up to date in O(log n) per change:
+
+    - aggregate::Fenwick (binary indexed tree): prefix sums and range sums with point
+      updates. Node i (1-based) holds the sum of (i - lowbit(i), i], so the whole tree is
+      one array of n + 1 values and a query or update walks at most log2(n) + 1 of them.
+    - aggregate::RangeTree: sum, min and max of any range with point assignment and range
+      add (lazy propagation: a pending add stays on the highest node it covers until a
+      later operation goes below it). It is stored bottom-up, the heap layout with node k
+      over children 2k and 2k + 1 and the n leaves in one contiguous run at the end, so
+      queries are two loops climbing from the leaves, without recursion or pointers, and
+      the nodes of the top levels that every operation touches share a few cache lines.
+
+    Both build in O(n) from a span, one level at a time: every node of a level depends
+    only on the levels below, so the nodes of a level are split over the pool. The build
+    adds in the same order for any thread count, so floating-point trees are reproducible.
+    Sums are kept in T; for integers the caller picks a type wide enough for the total.
+*/
+namespace aggregate {
+
+template <class T>
+class Fenwick {
+public:
+    explicit Fenwick(std::size_t n = 0) : tree(n + 1, T{}) {}
+
+    Fenwick(const exec::pool_policy& policy, std::span<const T> values) : tree(values.size() + 1, T{}) {
+        const std::size_t n = values.size();
+        // level L: the nodes i = 2^L * odd, each its value plus its children i - 2^j, j < L
+        for (std::size_t level = 0; (std::size_t{1} << level) <= n; ++level) {
+            const std::size_t step = std::size_t{1} << level, count = (n / step + 1) / 2;
+            exec::for_each_chunk(policy, count, exec::task_count(policy, count), [&](std::size_t, std::size_t b, std::size_t e) {
+                for (std::size_t q = b; q < e; ++q) {
+                    const std::size_t i = step * (2 * q + 1);
+                    T sum = values[i - 1];
+                    for (std::size_t child = 1; child < step; child *= 2) sum += tree[i - child];
+                    tree[i] = sum;
+                }
+            });
+        }
+    }
+
+    std::size_t size() const { return tree.size() - 1; }
+
+    void add(std::size_t i, T delta) {
+        for (++i; i < tree.size(); i += i & (~i + 1)) tree[i] += delta;
+    }
+
+    // sum of [0, end)
+    T prefix(std::size_t end) const {
+        T sum{};
+        for (; end > 0; end &= end - 1) sum += tree[end];
+        return sum;
+    }
+
+    // sum of [b, e)
+    T sum(std::size_t b, std::size_t e) const { return prefix(e) - prefix(b); }
+
+private:
+    std::vector<T> tree;
+};
+
+template <class T>
+struct Aggregate {
+    T sum, min, max;
+};
+
+template <class T>
+class RangeTree {
+public:
+    RangeTree(const exec::pool_policy& policy, std::span<const T> values)
+        : n(values.size()), leaves(std::bit_ceil(std::max<std::size_t>(n, 1))), height(std::countr_zero(leaves)),
+          node(2 * leaves, identity()), pending(leaves, T{}) {
+        exec::for_each_chunk(policy, n, exec::task_count(policy, n), [&](std::size_t, std::size_t b, std::size_t e) {
+            for (std::size_t i = b; i < e; ++i) node[leaves + i] = {values[i], values[i], values[i]};
+        });
+        for (std::size_t first = leaves / 2; first > 0; first /= 2)
+            exec::for_each_chunk(policy, first, exec::task_count(policy, first), [&](std::size_t, std::size_t b, std::size_t e) {
+                for (std::size_t k = first + b; k < first + e; ++k) pull(k);
+            });
+    }
+
+    std::size_t size() const { return n; }
+
+    // sum, min and max of [b, e); the identity (0, max, lowest) when the range is empty
+    Aggregate<T> query(std::size_t b, std::size_t e) {
+        if (b >= e) return identity();
+        b += leaves;
+        e += leaves;
+        push_down(b, e);
+        Aggregate<T> left = identity(), right = identity();
+        for (; b < e; b /= 2, e /= 2) {
+            if (b & 1) left = combine(left, node[b++]);
+            if (e & 1) right = combine(node[--e], right);
+        }
+        return combine(left, right);
+    }
+
+    void assign(std::size_t i, T value) {
+        i += leaves;
+        for (unsigned level = height; level > 0; --level) push(i >> level);
+        node[i] = {value, value, value};
+        for (unsigned level = 1; level <= height; ++level) pull(i >> level);
+    }
+
+    // adds delta to every element of [b, e)
+    void add(std::size_t b, std::size_t e, T delta) {
+        if (b >= e) return;
+        b += leaves;
+        e += leaves;
+        push_down(b, e);
+        for (std::size_t l = b, r = e; l < r; l /= 2, r /= 2) {
+            if (l & 1) apply(l++, delta);
+            if (r & 1) apply(--r, delta);
+        }
+        for (unsigned level = 1; level <= height; ++level) {
+            if (((b >> level) << level) != b) pull(b >> level);
+            if (((e >> level) << level) != e) pull((e - 1) >> level);
+        }
+    }
+
+private:
+    static Aggregate<T> identity() { return {T{}, std::numeric_limits<T>::max(), std::numeric_limits<T>::lowest()}; }
+
+    static Aggregate<T> combine(const Aggregate<T>& a, const Aggregate<T>& b) {
+        return {a.sum + b.sum, std::min(a.min, b.min), std::max(a.max, b.max)};
+    }
+
+    // number of leaves under node k
+    std::size_t width(std::size_t k) const { return leaves >> (std::bit_width(k) - 1); }
+
+    // Only nodes inside [0, n) ever get a pending add, so padding leaves keep the identity.
+    void apply(std::size_t k, T delta) {
+        node[k].sum += delta * static_cast<T>(width(k));
+        node[k].min += delta;
+        node[k].max += delta;
+        if (k < leaves) pending[k] += delta;
+    }
+
+    void push(std::size_t k) {
+        if (pending[k] == T{}) return;
+        apply(2 * k, pending[k]);
+        apply(2 * k + 1, pending[k]);
+        pending[k] = T{};
+    }
+
+    void pull(std::size_t k) { node[k] = combine(node[2 * k], node[2 * k + 1]); }
+
+    // pushes the pending adds above the partly covered ends of leaf range [b, e)
+    void push_down(std::size_t b, std::size_t e) {
+        for (unsigned level = height; level > 0; --level) {
+            if (((b >> level) << level) != b) push(b >> level);
+            if (((e >> level) << level) != e) push((e - 1) >> level);
+        }
+    }
+
+    std::size_t n, leaves;
+    unsigned height;
+    std::vector<Aggregate<T>> node;  // node[1] is the root, leaf i is node[leaves + i]
+    std::vector<T> pending;          // add not yet applied to the children of node k
+};
+
+} // namespace aggregate
+
+// Update-then-query throughput on 4M int64 values: every call runs a batch of 64 updates,
+// each followed by a query, (1) point add + total sum, (2) point add + sum of a random
+// range, (3) range add + min and max of a random range; against a std::reduce (or
+// minmax_element) rescan, sequential and parallel. Every tree is first checked against the
+// rescan on a batch of its own. Then the bulk builds, on one thread and on the pool.
+void incremental_aggregate_benchmark(bench::Runner& runner) {
+    std::cout << "\n[incremental_aggregate_benchmark]" << std::endl;
+
+    constexpr std::size_t N = std::size_t{1} << 22, batch = 64;
+    const exec::pool_policy pool = exec::par_on(exec::default_pool());
+    exec::ThreadPool single{1};
+    const exec::pool_policy one = exec::par_on(single);
+
+    std::vector<std::int64_t> values(N);
+    rng::generate(pool, values.begin(), values.end(), 11, [](rng::Philox& engine) { return std::int64_t{rng::bounded(engine, 1000)}; });
+    struct Op {
+        std::size_t i, b, e;
+        std::int64_t delta;
+    };
+    std::vector<Op> ops(batch);
+    rng::Philox engine{12};
+    for (Op& op : ops) {
+        op.i = rng::bounded(engine, N);
+        op.b = rng::bounded(engine, N);
+        op.e = op.b + 1 + rng::bounded(engine, static_cast<std::uint32_t>(N - op.b));
+        op.delta = std::int64_t{rng::bounded(engine, 101)} - 50;
+    }
+
+    std::vector<std::int64_t> data = values;
+    aggregate::Fenwick<std::int64_t> fenwick{pool, values};
+    for (const Op& op : ops) {
+        data[op.i] += op.delta;
+        fenwick.add(op.i, op.delta);
+        if (fenwick.sum(op.b, op.e) != std::reduce(data.begin() + op.b, data.begin() + op.e) || fenwick.prefix(N) != std::reduce(data.begin(), data.end()))
+            throw std::runtime_error("Fenwick sums differ from std::reduce");
+    }
+    data = values;
+    aggregate::RangeTree<std::int64_t> tree{pool, values};
+    for (const Op& op : ops) {
+        data[op.i] += op.delta;
+        tree.assign(op.i, data[op.i]);
+        std::for_each(data.begin() + op.b, data.begin() + op.e, [&](std::int64_t& x) { x += op.delta; });
+        tree.add(op.b, op.e, op.delta);
+        const auto [lo, hi] = std::minmax_element(data.begin() + op.b, data.begin() + op.e);
+        const auto r = tree.query(op.b, op.e);
+        if (r.sum != std::reduce(data.begin() + op.b, data.begin() + op.e) || r.min != *lo || r.max != *hi || tree.query(0, N).sum != std::reduce(data.begin(), data.end()))
+            throw std::runtime_error("RangeTree aggregates differ from std::reduce / std::minmax_element");
+    }
+
+    auto speedups = [&](const std::string& name, double rescan_ns) {
+        std::cout << "  -> " << name << ": " << std::fixed << std::setprecision(0);
+        for (const auto& r : runner.results())
+            if (r.name == name && r.stats.median > 0) std::cout << r.variant << " " << rescan_ns / r.stats.median << "x  ";
+        std::cout << "(vs std::reduce rescan)" << std::defaultfloat << std::endl;
+    };
+
+    std::int64_t sink = 0;
+    const std::string total = "point add + total sum x64";
+    const double total_rescan = runner.run(total, "std::reduce rescan", N, [&] {
+        for (const Op& op : ops) {
+            data[op.i] += op.delta;
+            sink += std::reduce(data.begin(), data.end());
+        }
+    }).stats.median;
+    runner.run(total, "std::reduce(par) rescan", N, [&] {
+        for (const Op& op : ops) {
+            data[op.i] += op.delta;
+            sink += std::reduce(std::execution::par, data.begin(), data.end());
+        }
+    });
+    runner.run(total, "fenwick", N, [&] {
+        for (const Op& op : ops) {
+            fenwick.add(op.i, op.delta);
+            sink += fenwick.prefix(N);
+        }
+    });
+    runner.run(total, "range tree", N, [&] {
+        for (const Op& op : ops) {
+            tree.add(op.i, op.i + 1, op.delta);
+            sink += tree.query(0, N).sum;
+        }
+    });
+    speedups(total, total_rescan);
+
+    const std::string range = "point add + range sum x64";
+    const double range_rescan = runner.run(range, "std::reduce rescan", N, [&] {
+        for (const Op& op : ops) {
+            data[op.i] += op.delta;
+            sink += std::reduce(data.begin() + op.b, data.begin() + op.e);
+        }
+    }).stats.median;
+    runner.run(range, "std::reduce(par) rescan", N, [&] {
+        for (const Op& op : ops) {
+            data[op.i] += op.delta;
+            sink += std::reduce(std::execution::par, data.begin() + op.b, data.begin() + op.e);
+        }
+    });
+    runner.run(range, "fenwick", N, [&] {
+        for (const Op& op : ops) {
+            fenwick.add(op.i, op.delta);
+            sink += fenwick.sum(op.b, op.e);
+        }
+    });
+    runner.run(range, "range tree", N, [&] {
+        for (const Op& op : ops) {
+            tree.add(op.i, op.i + 1, op.delta);
+            sink += tree.query(op.b, op.e).sum;
+        }
+    });
+    speedups(range, range_rescan);
+
+    // the rescan has to apply the range add element by element as well
+    const std::string minmax = "range add + range min/max x64";
+    const double minmax_rescan = runner.run(minmax, "std::reduce rescan", N, [&] {
+        for (const Op& op : ops) {
+            std::for_each(data.begin() + op.b, data.begin() + op.e, [&](std::int64_t& x) { x += op.delta; });
+            const auto [lo, hi] = std::minmax_element(data.begin() + op.b, data.begin() + op.e);
+            sink += *lo + *hi;
+        }
+    }).stats.median;
+    runner.run(minmax, "std::reduce(par) rescan", N, [&] {
+        for (const Op& op : ops) {
+            std::for_each(std::execution::par, data.begin() + op.b, data.begin() + op.e, [&](std::int64_t& x) { x += op.delta; });
+            const auto [lo, hi] = std::minmax_element(std::execution::par, data.begin() + op.b, data.begin() + op.e);
+            sink += *lo + *hi;
+        }
+    });
+    runner.run(minmax, "range tree", N, [&] {
+        for (const Op& op : ops) {
+            tree.add(op.b, op.e, op.delta);
+            const auto r = tree.query(op.b, op.e);
+            sink += r.min + r.max;
+        }
+    });
+    speedups(minmax, minmax_rescan);
+    bench::do_not_optimize(sink);
+
+    runner.run("fenwick build", "1 thread", N, [&] { bench::do_not_optimize(aggregate::Fenwick<std::int64_t>{one, values}); });
+    runner.run("fenwick build", "pool", N, [&] { bench::do_not_optimize(aggregate::Fenwick<std::int64_t>{pool, values}); });
+    runner.run("range tree build", "1 thread", N, [&] { bench::do_not_optimize(aggregate::RangeTree<std::int64_t>{one, values}); });
+    runner.run("range tree build", "pool", N, [&] { bench::do_not_optimize(aggregate::RangeTree<std::int64_t>{pool, values}); });
+}
+
+/*
+    Set operations on sorted ranges
+
+    std::set, std::map and the sorted-range algorithms (std::merge, std::set_union, ...)
+    are sequential. setops has the same four algorithms on the pool, for random-access
+    input and output ranges sorted by comp, with the multiset semantics of the standard
+    ones (an element that occurs m times in the first range and n times in the second
+    occurs min(m, n) times in the intersection, max(m, n) in the union and max(m - n, 0)
+    in the difference).
+
+    Merge path: the output of merging a (na elements) and b (nb elements) is a path from
+    (0, 0) to (na, nb), one step right for every element taken from a and one down for b,
+    and diagonal d of the grid (i + j = d) crosses it exactly once. A binary search along
+    the diagonal finds that crossing, the (i, j) with a[0, i) and b[0, j) making up the
+    first d outputs, without merging anything. Splitting at evenly spaced diagonals gives
+    every task the same number of elements whatever the data, and the pieces are merged
+    independently. For the set operations a split must not separate equal elements, which
+    the operation pairs up across the two ranges, so each split moves down to the lower
+    bound of its key in both ranges. The output sizes of set operations depend on the
+    data: every piece first counts its output, and a prefix sum of the counts gives the
+    offsets, as in compact::copy_if.
+
+    When one range is much smaller (below 1/128 of the other), set_intersection looks up
+    the elements of the small range in the large one instead of merging: a galloping
+    search from the previous match (1, 2, 4, ... elements ahead, then a binary search)
+    costs O(m log(n / m)) comparisons instead of O(m + n), but most of them miss the
+    cache, which is why the ratio has to be that large before it wins. For std::int32_t with
+    std::less the search gallops over blocks of 8 (AVX2) or 16 (AVX-512) values and ends
+    with a vector compare against the whole block.
+*/
+namespace setops {
+
+// Elements taken from the smaller range per element of the larger one below which
+// set_intersection gallops.
+inline constexpr std::size_t gallop_ratio = 128;
+
+// First position in [p, n) of sorted 'large' that is not less than x, searching 1, 2, 4, ...
+// elements ahead of p before the binary search.
+using Gallop32 = std::size_t (*)(const std::int32_t* large, std::size_t p, std::size_t n, std::int32_t x);
+
+template <class It, class T, class Compare>
+std::size_t gallop(It large, std::size_t p, std::size_t n, const T& x, Compare comp) {
+    std::size_t step = 1, hi = p;
+    while (hi < n && comp(large[static_cast<std::ptrdiff_t>(hi)], x)) {
+        p = hi + 1;
+        hi += step;
+        step *= 2;
+    }
+    hi = std::min(hi, n);
+    return static_cast<std::size_t>(std::lower_bound(large + static_cast<std::ptrdiff_t>(p), large + static_cast<std::ptrdiff_t>(hi), x, comp) - large);
+}
+
+namespace baseline {
+
+inline std::size_t gallop(const std::int32_t* large, std::size_t p, std::size_t n, std::int32_t x) {
+    return setops::gallop(large, p, n, x, std::less<>());
+}
+
+} // namespace baseline
+
+#if HAS_X86_SIMD
+// Gallops over blocks of Lanes values, narrows the block down by binary search and counts
+// the values below x in the last block with one compare.
+#define SETOPS_SIMD_GALLOP(Lanes, count_below)                                             \
+    TARGET inline std::size_t gallop(const std::int32_t* large, std::size_t p, std::size_t n, std::int32_t x) { \
+        std::size_t step = Lanes;                                                          \
+        while (p + step <= n && large[p + step - 1] < x) {                                 \
+            p += step;                                                                     \
+            step *= 2;                                                                     \
+        }                                                                                  \
+        std::size_t hi = std::min(p + step, n);                                            \
+        while (hi - p > Lanes) {                                                           \
+            const std::size_t mid = p + (hi - p) / 2;                                      \
+            if (large[mid] < x) p = mid + 1;                                               \
+            else hi = mid;                                                                 \
+        }                                                                                  \
+        if (p + Lanes > n) return setops::gallop(large, p, hi, x, std::less<>());          \
+        return p + count_below(large + p, x);                                              \
+    }
+
+namespace avx2 {
+
+#define TARGET SIMD_TARGET("avx2")
+
+TARGET inline std::size_t count_below(const std::int32_t* p, std::int32_t x) {
+    const __m256i lt = _mm256_cmpgt_epi32(_mm256_set1_epi32(x), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)));
+    return static_cast<std::size_t>(std::popcount(static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(lt)))));
+}
+
+SETOPS_SIMD_GALLOP(8, count_below)
+
+#undef TARGET
+
+} // namespace avx2
+
+namespace avx512 {
+
+#define TARGET SIMD_TARGET("avx512f")
+
+TARGET inline std::size_t count_below(const std::int32_t* p, std::int32_t x) {
+    return static_cast<std::size_t>(std::popcount(static_cast<unsigned>(_mm512_cmplt_epi32_mask(_mm512_loadu_si512(p), _mm512_set1_epi32(x)))));
+}
+
+SETOPS_SIMD_GALLOP(16, count_below)
+
+#undef TARGET
+
+} // namespace avx512
+#undef SETOPS_SIMD_GALLOP
+#endif // HAS_X86_SIMD
+
+inline Gallop32 best_gallop() {
+#if HAS_X86_SIMD
+    switch (simd::supported_levels().back()) {
+    case simd::Isa::avx512: return avx512::gallop;
+    case simd::Isa::avx2: return avx2::gallop;
+    default: break;
+    }
+#endif
+    return baseline::gallop;
+}
+
+namespace detail {
+
+// Output iterator that only counts what is written to it.
+struct Counter {
+    using difference_type = std::ptrdiff_t;
+    std::size_t* count;
+
+    Counter& operator*() { return *this; }
+    template <class T>
+    Counter& operator=(const T&) {
+        ++*count;
+        return *this;
+    }
+    Counter& operator++() { return *this; }
+    Counter operator++(int) { return *this; }
+};
+
+// Splits of the merge of a and b into 'pieces' of about (na + nb) / pieces outputs: piece p
+// is a[i[p], i[p + 1]) with b[j[p], j[p + 1]). by_key moves each split to the lower bound
+// of its key, so equal elements stay in one piece.
+template <class It1, class It2, class Compare>
+std::vector<std::pair<std::size_t, std::size_t>> merge_path(It1 a, std::size_t na, It2 b, std::size_t nb, std::size_t pieces, Compare comp, bool by_key) {
+    std::vector<std::pair<std::size_t, std::size_t>> splits(pieces + 1, {na, nb});
+    splits[0] = {0, 0};
+    for (std::size_t p = 1; p < pieces; ++p) {
+        const std::size_t d = (na + nb) * p / pieces;
+        std::size_t lo = d > nb ? d - nb : 0, hi = std::min(d, na);
+        while (lo < hi) {  // the first i at which b[d - i - 1] goes before a[i]
+            const std::size_t i = lo + (hi - lo) / 2;
+            if (comp(b[static_cast<std::ptrdiff_t>(d - i - 1)], a[static_cast<std::ptrdiff_t>(i)])) hi = i;
+            else lo = i + 1;
+        }
+        std::size_t i = lo, j = d - lo;
+        if (by_key && (i < na || j < nb)) {
+            // the next element of the merge; std::merge takes a on ties
+            const bool from_a = i < na && (j == nb || !comp(b[static_cast<std::ptrdiff_t>(j)], a[static_cast<std::ptrdiff_t>(i)]));
+            const auto& key = from_a ? a[static_cast<std::ptrdiff_t>(i)] : b[static_cast<std::ptrdiff_t>(j)];
+            i = static_cast<std::size_t>(std::lower_bound(a, a + static_cast<std::ptrdiff_t>(i), key, comp) - a);
+            j = static_cast<std::size_t>(std::lower_bound(b, b + static_cast<std::ptrdiff_t>(j), key, comp) - b);
+        }
+        splits[p] = {i, j};
+    }
+    return splits;
+}
+
+// Runs op(a_first, a_last, b_first, b_last, out) on the pieces of a merge path split by key,
+// first into Counters, then into out at the prefix sums of the counts.
+template <class It1, class It2, class OutIt, class Compare, class Op>
+OutIt by_pieces(const exec::pool_policy& policy, It1 first1, It1 last1, It2 first2, It2 last2, OutIt out, Compare comp, Op op) {
+    const auto na = static_cast<std::size_t>(last1 - first1), nb = static_cast<std::size_t>(last2 - first2);
+    const std::size_t pieces = exec::task_count(policy, na + nb);
+    if (pieces <= 1) return op(first1, last1, first2, last2, out);
+    const auto splits = merge_path(first1, na, first2, nb, pieces, comp, true);
+    auto piece = [&](std::size_t p, auto dst) {
+        return op(first1 + static_cast<std::ptrdiff_t>(splits[p].first), first1 + static_cast<std::ptrdiff_t>(splits[p + 1].first),
+                  first2 + static_cast<std::ptrdiff_t>(splits[p].second), first2 + static_cast<std::ptrdiff_t>(splits[p + 1].second), dst);
+    };
+    std::vector<std::size_t> offset(pieces + 1, 0);
+    policy.pool->parallel_for(pieces, [&](std::size_t p) { piece(p, Counter{&offset[p + 1]}); });
+    std::partial_sum(offset.begin(), offset.end(), offset.begin());
+    policy.pool->parallel_for(pieces, [&](std::size_t p) { piece(p, out + static_cast<std::ptrdiff_t>(offset[p])); });
+    return out + static_cast<std::ptrdiff_t>(offset[pieces]);
+}
+
+} // namespace detail
+
+// Stable, as std::merge: on ties the element of the first range goes first.
+template <class It1, class It2, class OutIt, class Compare = std::less<>>
+OutIt merge(const exec::pool_policy& policy, It1 first1, It1 last1, It2 first2, It2 last2, OutIt out, Compare comp = {}) {
+    const auto na = static_cast<std::size_t>(last1 - first1), nb = static_cast<std::size_t>(last2 - first2);
+    const std::size_t pieces = exec::task_count(policy, na + nb);
+    if (pieces <= 1) return std::merge(first1, last1, first2, last2, out, comp);
+    const auto splits = detail::merge_path(first1, na, first2, nb, pieces, comp, false);
+    policy.pool->parallel_for(pieces, [&](std::size_t p) {
+        const auto [i, j] = splits[p];
+        const auto [i_end, j_end] = splits[p + 1];
+        std::merge(first1 + static_cast<std::ptrdiff_t>(i), first1 + static_cast<std::ptrdiff_t>(i_end), first2 + static_cast<std::ptrdiff_t>(j),
+                   first2 + static_cast<std::ptrdiff_t>(j_end), out + static_cast<std::ptrdiff_t>(i + j), comp);
+    });
+    return out + static_cast<std::ptrdiff_t>(na + nb);
+}
+
+template <class It1, class It2, class OutIt, class Compare = std::less<>>
+OutIt set_union(const exec::pool_policy& policy, It1 first1, It1 last1, It2 first2, It2 last2, OutIt out, Compare comp = {}) {
+    return detail::by_pieces(policy, first1, last1, first2, last2, out, comp,
+                             [&](auto a, auto a_end, auto b, auto b_end, auto dst) { return std::set_union(a, a_end, b, b_end, dst, comp); });
+}
+
+template <class It1, class It2, class OutIt, class Compare = std::less<>>
+OutIt set_difference(const exec::pool_policy& policy, It1 first1, It1 last1, It2 first2, It2 last2, OutIt out, Compare comp = {}) {
+    return detail::by_pieces(policy, first1, last1, first2, last2, out, comp,
+                             [&](auto a, auto a_end, auto b, auto b_end, auto dst) { return std::set_difference(a, a_end, b, b_end, dst, comp); });
+}
+
+// Intersection that looks up every element of the smaller range in the larger one; the
+// output holds elements of the first range, as with std::set_intersection. use_simd =
+// false keeps std::int32_t on the scalar search (for comparisons).
+template <class It1, class It2, class OutIt, class Compare = std::less<>>
+OutIt galloping_intersection(const exec::pool_policy& policy, It1 first1, It1 last1, It2 first2, It2 last2, OutIt out,
+                             Compare comp = {}, bool use_simd = true) {
+    const auto na = static_cast<std::size_t>(last1 - first1), nb = static_cast<std::size_t>(last2 - first2);
+    const bool small_first = na <= nb;
+    const std::size_t n_small = small_first ? na : nb, n_large = small_first ? nb : na;
+
+    // position of x in the large range at or after p
+    auto search = [&](std::size_t p, const auto& x) -> std::size_t {
+        if constexpr (std::contiguous_iterator<It1> && std::contiguous_iterator<It2> && std::is_same_v<std::iter_value_t<It1>, std::int32_t> &&
+                      std::is_same_v<std::iter_value_t<It2>, std::int32_t> && (std::is_same_v<Compare, std::less<>> || std::is_same_v<Compare, std::less<std::int32_t>>)) {
+            static const Gallop32 simd_gallop = best_gallop();
+            if (use_simd) return simd_gallop(std::to_address(small_first ? first2 : first1), p, n_large, x);
+        }
+        if (small_first) return gallop(first2, p, n_large, x, comp);
+        return gallop(first1, p, n_large, x, comp);
+    };
+    auto small_at = [&](std::size_t i) -> decltype(auto) { return small_first ? first1[static_cast<std::ptrdiff_t>(i)] : first2[static_cast<std::ptrdiff_t>(i)]; };
+    auto large_at = [&](std::size_t i) -> decltype(auto) { return small_first ? first2[static_cast<std::ptrdiff_t>(i)] : first1[static_cast<std::ptrdiff_t>(i)]; };
+
+    // runs of equal elements stay in one chunk, so the k-th copy in the small range meets the k-th in the large one
+    const std::size_t chunks = exec::task_count(policy, n_small);
+    std::vector<std::size_t> start(chunks + 1, n_small);
+    for (std::size_t c = 0; c < chunks; ++c) {
+        const std::size_t s = n_small * c / chunks;
+        start[c] = s;
+        while (start[c] > 0 && !comp(small_at(start[c] - 1), small_at(s))) --start[c];
+        if (c > 0) start[c] = std::max(start[c], start[c - 1]);
+    }
+    // the searches miss the cache, so the matches are kept per chunk rather than searched for twice
+    std::vector<std::vector<std::iter_value_t<It1>>> matches(chunks);
+    std::vector<std::size_t> offset(chunks + 1, 0);
+    policy.pool->parallel_for(chunks, [&](std::size_t c) {
+        std::size_t p = 0;
+        for (std::size_t i = start[c]; i < start[c + 1] && p < n_large; ++i) {
+            p = search(p, small_at(i));
+            if (p < n_large && !comp(small_at(i), large_at(p))) {
+                matches[c].push_back(small_first ? small_at(i) : large_at(p));
+                ++p;
+            }
+        }
+        offset[c + 1] = matches[c].size();
+    });
+    std::partial_sum(offset.begin(), offset.end(), offset.begin());
+    policy.pool->parallel_for(chunks, [&](std::size_t c) { std::move(matches[c].begin(), matches[c].end(), out + static_cast<std::ptrdiff_t>(offset[c])); });
+    return out + static_cast<std::ptrdiff_t>(offset[chunks]);
+}
+
+template <class It1, class It2, class OutIt, class Compare = std::less<>>
+OutIt merge_path_intersection(const exec::pool_policy& policy, It1 first1, It1 last1, It2 first2, It2 last2, OutIt out, Compare comp = {}) {
+    return detail::by_pieces(policy, first1, last1, first2, last2, out, comp,
+                             [&](auto a, auto a_end, auto b, auto b_end, auto dst) { return std::set_intersection(a, a_end, b, b_end, dst, comp); });
+}
+
+// Merge path for ranges of similar size, galloping_intersection otherwise.
+template <class It1, class It2, class OutIt, class Compare = std::less<>>
+OutIt set_intersection(const exec::pool_policy& policy, It1 first1, It1 last1, It2 first2, It2 last2, OutIt out, Compare comp = {}) {
+    const auto na = static_cast<std::size_t>(last1 - first1), nb = static_cast<std::size_t>(last2 - first2);
+    if (std::min(na, nb) * gallop_ratio < std::max(na, nb)) return galloping_intersection(policy, first1, last1, first2, last2, out, comp);
+    return merge_path_intersection(policy, first1, last1, first2, last2, out, comp);
+}
+
+} // namespace setops
+
+// merge, set_union, set_intersection and set_difference of two sorted vectors of 8M int32
+// (with duplicates), sequential std, std(par) and setops on the pool; then the intersection
+// of 8M with 8K, 64K and 1M elements: std::set_intersection, the merge path split and the
+// galloping search, scalar and SIMD. Every setops result is checked against std.
+void set_operations_benchmark(bench::Runner& runner) {
+    std::cout << "\n[set_operations_benchmark]" << std::endl;
+
+    constexpr std::size_t N = std::size_t{1} << 23;
+    const exec::pool_policy pool = exec::par_on(exec::default_pool());
+    auto sorted_input = [&](std::size_t n, std::uint64_t seed) {
+        std::vector<std::int32_t> v(n);
+        rng::generate(pool, v.begin(), v.end(), seed, [](rng::Philox& engine) { return static_cast<std::int32_t>(rng::bounded(engine, 1u << 26)); });
+        exec::sort(pool, v.begin(), v.end());
+        return v;
+    };
+    const std::vector<std::int32_t> a = sorted_input(N, 21), b = sorted_input(N, 22);
+    std::vector<std::int32_t> out(2 * N), expected(2 * N);
+
+    auto check = [&](const std::string& name, auto std_end, auto setops_end) {
+        if (!std::equal(out.begin(), setops_end, expected.begin(), std_end))
+            throw std::runtime_error(name + ": setops result differs from the standard algorithm");
+    };
+    auto bench_op = [&](const std::string& name, auto std_op, auto par_op, auto setops_op) {
+        const auto std_end = std_op(expected.begin());
+        check(name, std_end, setops_op(out.begin()));
+        bench::compare(runner, name, 2 * N,
+            [&] { bench::do_not_optimize(std_op(out.begin())); },
+            [&] { bench::do_not_optimize(par_op(out.begin())); },
+            [&] { bench::do_not_optimize(setops_op(out.begin())); });
+    };
+    bench_op("merge int32 8M + 8M",
+        [&](auto dst) { return std::merge(a.begin(), a.end(), b.begin(), b.end(), dst); },
+        [&](auto dst) { return std::merge(std::execution::par, a.begin(), a.end(), b.begin(), b.end(), dst); },
+        [&](auto dst) { return setops::merge(pool, a.begin(), a.end(), b.begin(), b.end(), dst); });
+    bench_op("set_union int32 8M + 8M",
+        [&](auto dst) { return std::set_union(a.begin(), a.end(), b.begin(), b.end(), dst); },
+        [&](auto dst) { return std::set_union(std::execution::par, a.begin(), a.end(), b.begin(), b.end(), dst); },
+        [&](auto dst) { return setops::set_union(pool, a.begin(), a.end(), b.begin(), b.end(), dst); });
+    bench_op("set_intersection int32 8M + 8M",
+        [&](auto dst) { return std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), dst); },
+        [&](auto dst) { return std::set_intersection(std::execution::par, a.begin(), a.end(), b.begin(), b.end(), dst); },
+        [&](auto dst) { return setops::set_intersection(pool, a.begin(), a.end(), b.begin(), b.end(), dst); });
+    bench_op("set_difference int32 8M - 8M",
+        [&](auto dst) { return std::set_difference(a.begin(), a.end(), b.begin(), b.end(), dst); },
+        [&](auto dst) { return std::set_difference(std::execution::par, a.begin(), a.end(), b.begin(), b.end(), dst); },
+        [&](auto dst) { return setops::set_difference(pool, a.begin(), a.end(), b.begin(), b.end(), dst); });
+
+    for (std::size_t small_n : {std::size_t{1} << 13, std::size_t{1} << 16, std::size_t{1} << 20}) {
+        // a sample of a, so about half of the small range matches
+        std::vector<std::int32_t> small = sorted_input(small_n, 23);
+        for (std::size_t i = 0; i < small_n; i += 2) small[i] = a[i * (N / small_n)];
+        std::sort(small.begin(), small.end());
+        const std::string name = "set_intersection int32 8M x " + std::to_string(small_n >> 10) + "K";
+
+        const auto std_end = std::set_intersection(a.begin(), a.end(), small.begin(), small.end(), expected.begin());
+        for (bool simd : {false, true})
+            check(name, std_end, setops::galloping_intersection(pool, a.begin(), a.end(), small.begin(), small.end(), out.begin(), std::less<>(), simd));
+        check(name, std_end, setops::merge_path_intersection(pool, a.begin(), a.end(), small.begin(), small.end(), out.begin()));
+
+        runner.run(name, "std::set_intersection", N + small_n,
+            [&] { bench::do_not_optimize(std::set_intersection(a.begin(), a.end(), small.begin(), small.end(), out.begin())); });
+        runner.run(name, "setops merge path", N + small_n,
+            [&] { bench::do_not_optimize(setops::merge_path_intersection(pool, a.begin(), a.end(), small.begin(), small.end(), out.begin())); });
+        runner.run(name, "setops galloping", N + small_n,
+            [&] { bench::do_not_optimize(setops::galloping_intersection(pool, a.begin(), a.end(), small.begin(), small.end(), out.begin(), std::less<>(), false)); });
+        runner.run(name, std::string{"setops galloping "} + simd::to_string(simd::supported_levels().back()), N + small_n,
+            [&] { bench::do_not_optimize(setops::galloping_intersection(pool, a.begin(), a.end(), small.begin(), small.end(), out.begin())); });
+    }
+}
+
+// Sequential vs parallel comparison of the standard algorithms on 1M shuffled ints.
+void compare_seq_vs_par(bench::Runner& runner) {
+    std::cout << "\n[compare_seq_vs_par]" << std::endl;
+
+    constexpr std::size_t N = 1'000'000;
+    std::vector<int> vec(N);
+    const exec::pool_policy pool = exec::par_on(exec::default_pool());
     std::iota(vec.begin(), vec.end(), 0);
-    std::shuffle(vec.begin(), vec.end(), std::mt19937{std::random_device{}()});
-    std::vector<int> vec_copy = vec;
-
-    // normal sort
-    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
-    std::sort(vec.begin(), vec.end());
-    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
-    auto elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
-    std::cout << "Normal sort took: " << elapsed_ns << " ns" << std::endl;
-
-    // Example: Parallel sort
-    begin = std::chrono::steady_clock::now();
-    std::sort(std::execution::par, vec_copy.begin(), vec_copy.end());
-    end = std::chrono::steady_clock::now();
-    elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
-    std::cout << "Parallel sort took: " << elapsed_ns << " ns" << std::endl;
-
-    // lets do sum
-    // Normal sum
-    begin = std::chrono::steady_clock::now();
-    auto sum = std::reduce(vec.begin(), vec.end(), 0);
-    end = std::chrono::steady_clock::now();
-    elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
-    std::cout << "Normal reduce (sum) took: " << elapsed_ns << " ns" << std::endl;
-
-
-    // Parallel sum
-    begin = std::chrono::steady_clock::now();
-    sum = std::reduce(std::execution::par, vec_copy.begin(), vec_copy.end(), 0);
-    end = std::chrono::steady_clock::now();
-    elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
-    std::cout << "Parallel reduce (sum) took: " << elapsed_ns << " ns" << std::endl;
-
-    // normal for_each
-    begin = std::chrono::steady_clock::now();
-    std::for_each(vec.begin(), vec.end(), [](int& n) { n++; });
-    end = std::chrono::steady_clock::now();
-    elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
-    std::cout << "Normal for_each took: " << elapsed_ns << " ns" << std::endl;
-
-    // Parallel for_each
-    begin = std::chrono::steady_clock::now();
-    std::for_each(std::execution::par, vec_copy.begin(), vec_copy.end(), [](int& n) { n++; });
-    end = std::chrono::steady_clock::now();
-    elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
-    std::cout << "Parallel for_each took: " << elapsed_ns << " ns" << std::endl;
-
-    // Normal transform
-    begin = std::chrono::steady_clock::now();
-    std::transform(vec.begin(), vec.end(), vec.begin(), [](int n) { return n * 2; });
-    end = std::chrono::steady_clock::now();
-    elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
-    std::cout << "Normal transform took: " << elapsed_ns << " ns" << std::endl;
-
-    // Example: Parallel transform
-    begin = std::chrono::steady_clock::now();
-    std::transform(std::execution::par, vec_copy.begin(), vec_copy.end(), vec_copy.begin(), [](int n) { return n * 2; });
-    end = std::chrono::steady_clock::now();
-    elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
-    std::cout << "Parallel transform took: " << elapsed_ns << " ns" << std::endl;
-
-
-    // additional parallel operations can be added here
-    // Normal find
-    begin = std::chrono::steady_clock::now();
-    auto it = std::find(vec.begin(), vec.end(), 500'000);
-    end = std::chrono::steady_clock::now();
-    elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
-    std::cout << "Normal find took: " << elapsed_ns << " ns" << std::endl;
-
-    // Example: Parallel find
-    begin = std::chrono::steady_clock::now();
-    auto it_p  = std::find(std::execution::par, vec_copy.begin(), vec_copy.end(), 500'000);
-    end = std::chrono::steady_clock::now();
-    elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
-    std::cout << "Parallel find took: " << elapsed_ns << " ns" << std::endl;
-
-    // Normal count
-    begin = std::chrono::steady_clock::now();
-    auto count = std::count(vec.begin(), vec.end(), 500'000);
-    end = std::chrono::steady_clock::now();
-    elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
-    std::cout << "Normal count took: " << elapsed_ns << " ns" << std::endl;
-
-    // Example: Parallel count
-    begin = std::chrono::steady_clock::now();
-    auto count_p = std::count(std::execution::par, vec_copy.begin(), vec_copy.end(), 500'000);
-    end = std::chrono::steady_clock::now();
-    elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
-    std::cout << "Parallel count took: " << elapsed_ns << " ns" << std::endl;
-
-    // Additional parallel operations can be added here
-    // normal find
-    begin = std::chrono::steady_clock::now();
-    auto it = std::find(vec.begin(), vec.end(), 500'000);
-    end = std::chrono::steady_clock::now();
-    elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
-    std::cout << "Normal find took: " << elapsed_ns << " ns" << std::endl;
-
-    // Example: Parallel find
-    begin = std::chrono::steady_clock::now();
-    auto it_p  = std::find(std::execution::par, vec_copy.begin(), vec_copy.end(), 500'000);
-    end = std::chrono::steady_clock::now();
-    elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
-    std::cout << "Parallel find took: " << elapsed_ns << " ns" << std::endl;
-
-    // example usage of transform_reduce
-    begin = std::chrono::steady_clock::now();
-    auto result = std::transform_reduce(vec.begin(), vec.end(), 0, std::plus<>(), [](int n) { return n * 2; });
-    end = std::chrono::steady_clock::now();
-    elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
-    std::cout << "Normal transform_reduce took: " << elapsed_ns << " ns" << std::endl;
-
-    // Example: Parallel transform_reduce
-    begin = std::chrono::steady_clock::now();
-    auto result_p = std::transform_reduce(std::execution::par, vec_copy.begin(), vec_copy.end(), 0, std::plus<>(), [](int n) { return n * 2; });
-    end = std::chrono::steady_clock::now();
-    elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
-    std::cout << "Parallel transform_reduce took: " << elapsed_ns << " ns" << std::endl;
+    rng::shuffle(pool, vec.begin(), vec.end(), std::random_device{}());
+    std::vector<int> work(N);
+    auto reset_work = [&] { std::copy(vec.begin(), vec.end(), work.begin()); };
+
+    // sort works in place, so every call starts from a fresh shuffled copy
+    bench::compare(runner, "sort", N, reset_work,
+        [&] { std::sort(work.begin(), work.end()); },
+        [&] { std::sort(std::execution::par, work.begin(), work.end()); },
+        [&] { exec::sort(pool, work.begin(), work.end()); });
+
+    // From here on every call is annotated with the bytes it has to read and write at the
+    // least (sort has no such fixed figure), which gives GB/s and the share of peak bandwidth.
+    constexpr std::size_t int_bytes = N * sizeof(int);
+
+    // sum; accumulated in 64 bits since the sum of 0..N-1 does not fit in an int
+    runner.set_bytes_per_call(int_bytes);
+    bench::compare(runner, "reduce (sum)", N,
+        [&] { bench::do_not_optimize(std::reduce(vec.begin(), vec.end(), std::int64_t{0})); },
+        [&] { bench::do_not_optimize(std::reduce(std::execution::par, vec.begin(), vec.end(), std::int64_t{0})); },
+        [&] { bench::do_not_optimize(exec::reduce(pool, vec.begin(), vec.end(), std::int64_t{0})); });
+
+    reset_work();
+    runner.set_bytes_per_call(2 * int_bytes);
+    bench::compare(runner, "for_each", N,
+        [&] { std::for_each(work.begin(), work.end(), [](int& n) { n++; }); },
+        [&] { std::for_each(std::execution::par, work.begin(), work.end(), [](int& n) { n++; }); },
+        [&] { exec::for_each(pool, work.begin(), work.end(), [](int& n) { n++; }); });
+
+    // transform writes to a separate buffer so repeated calls do not overflow the input
+    std::vector<int> transformed(N);
+    bench::compare(runner, "transform", N,
+        [&] { std::transform(vec.begin(), vec.end(), transformed.begin(), [](int n) { return n * 2; }); },
+        [&] { std::transform(std::execution::par, vec.begin(), vec.end(), transformed.begin(), [](int n) { return n * 2; }); },
+        [&] { exec::transform(pool, vec.begin(), vec.end(), transformed.begin(), [](int n) { return n * 2; }); });
+
+    // find reads up to the match
+    runner.set_bytes_per_call(static_cast<std::size_t>(std::find(vec.begin(), vec.end(), 500'000) - vec.begin() + 1) * sizeof(int));
+    bench::compare(runner, "find", N,
+        [&] { bench::do_not_optimize(std::find(vec.begin(), vec.end(), 500'000)); },
+        [&] { bench::do_not_optimize(std::find(std::execution::par, vec.begin(), vec.end(), 500'000)); },
+        [&] { bench::do_not_optimize(exec::find(pool, vec.begin(), vec.end(), 500'000)); });
+
+    runner.set_bytes_per_call(int_bytes);
+    bench::compare(runner, "count", N,
+        [&] { bench::do_not_optimize(std::count(vec.begin(), vec.end(), 500'000)); },
+        [&] { bench::do_not_optimize(std::count(std::execution::par, vec.begin(), vec.end(), 500'000)); },
+        [&] { bench::do_not_optimize(exec::count(pool, vec.begin(), vec.end(), 500'000)); });
+
+    bench::compare(runner, "transform_reduce", N,
+        [&] { bench::do_not_optimize(std::transform_reduce(vec.begin(), vec.end(), std::int64_t{0}, std::plus<>(), [](int n) { return n * 2; })); },
+        [&] { bench::do_not_optimize(std::transform_reduce(std::execution::par, vec.begin(), vec.end(), std::int64_t{0}, std::plus<>(), [](int n) { return n * 2; })); },
+        [&] { bench::do_not_optimize(exec::transform_reduce(pool, vec.begin(), vec.end(), std::int64_t{0}, std::plus<>(), [](int n) { return n * 2; })); });
 
     // example usage of transform_inclusive_scan
     /*
@@ -180,36 +5140,21 @@ int main() {
     Example:
     if the vector contains {1, 2, 3, 4}, the result of the inclusive scan will be {1, 3, 6, 10}.
     */
-    begin = std::chrono::steady_clock::now();
-    std::vector<int> inclusive_scan_result(vec.size());
-    std::transform_inclusive_scan(vec.begin(), vec.end(), inclusive_scan_result.begin(), 0, std::plus<>(), [](int n) { return n * 2; });
-    end = std::chrono::steady_clock::now();
-    elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
-    std::cout << "Normal transform_inclusive_scan took: " << elapsed_ns << " ns" << std::endl;
-
-    // Example: Parallel transform_inclusive_scan
-    begin = std::chrono::steady_clock::now();
-    std::vector<int> inclusive_scan_result_p(vec_copy.size());
-    std::transform_inclusive_scan(std::execution::par, vec_copy.begin(), vec_copy.end(), inclusive_scan_result_p.begin(), 0, std::plus<>(), [](int n) { return n * 2; });
-    end = std::chrono::steady_clock::now();
-    elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
-    std::cout << "Parallel transform_inclusive_scan took: " << elapsed_ns << " ns" << std::endl;
-
-    // example usage of transform_inclusive_scan with product
-    begin = std::chrono::steady_clock::now();
-    std::vector<int> inclusive_scan_result_prod(vec.size());
-    std::transform_inclusive_scan(vec.begin(), vec.end(), inclusive_scan_result_prod.begin(), 1, std::multiplies<>(), [](int n) { return n * 2; });
-    end = std::chrono::steady_clock::now();
-    elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
-    std::cout << "Normal transform_inclusive_scan with product took: " << elapsed_ns << " ns" << std::endl;
-
-    // Example: Parallel transform_inclusive_scan with product
-    begin = std::chrono::steady_clock::now();
-    std::vector<int> inclusive_scan_result_prod_p(vec_copy.size());
-    std::transform_inclusive_scan(std::execution::par, vec_copy.begin(), vec_copy.end(), inclusive_scan_result_prod_p.begin(), 1, std::multiplies<>(), [](int n) { return n * 2; });
-    end = std::chrono::steady_clock::now();
-    elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
-    std::cout << "Parallel transform_inclusive_scan with product took: " << elapsed_ns << " ns" << std::endl;
+    // the scans accumulate in 64 bits: the running sum of n * 2 passes INT_MAX after ~46K elements
+    std::vector<std::int64_t> scan_result(N);
+    runner.set_bytes_per_call(int_bytes + N * sizeof(std::int64_t));
+    bench::compare(runner, "transform_inclusive_scan", N,
+        [&] { std::transform_inclusive_scan(vec.begin(), vec.end(), scan_result.begin(), std::plus<>(), [](int n) { return n * 2; }, std::int64_t{0}); },
+        [&] { std::transform_inclusive_scan(std::execution::par, vec.begin(), vec.end(), scan_result.begin(), std::plus<>(), [](int n) { return n * 2; }, std::int64_t{0}); },
+        [&] { exec::transform_inclusive_scan(pool, vec.begin(), vec.end(), scan_result.begin(), std::plus<>(), [](int n) { return n * 2; }, std::int64_t{0}); });
+
+    // transform_inclusive_scan with product; overflows any integer type within a few
+    // elements, so it runs on unsigned 64 bits where wrap-around is well defined (timing only)
+    std::vector<std::uint64_t> product_result(N);
+    bench::compare(runner, "transform_inclusive_scan (product)", N,
+        [&] { std::transform_inclusive_scan(vec.begin(), vec.end(), product_result.begin(), std::multiplies<>(), [](int n) { return std::uint64_t(n) * 2; }, std::uint64_t{1}); },
+        [&] { std::transform_inclusive_scan(std::execution::par, vec.begin(), vec.end(), product_result.begin(), std::multiplies<>(), [](int n) { return std::uint64_t(n) * 2; }, std::uint64_t{1}); },
+        [&] { exec::transform_inclusive_scan(pool, vec.begin(), vec.end(), product_result.begin(), std::multiplies<>(), [](int n) { return std::uint64_t(n) * 2; }, std::uint64_t{1}); });
 
     // example usage of transform_exclusive_scan
     /*
@@ -218,20 +5163,15 @@ int main() {
     The difference between transform_exclusive_scan and transform_inclusive_scan is that
     transform_exclusive_scan does not include the last element in the scan.
     */
-    begin = std::chrono::steady_clock::now();
-    std::vector<int> exclusive_scan_result(vec.size());
-    std::transform_exclusive_scan(vec.begin(), vec.end(), exclusive_scan_result.begin(), 0, std::plus<>(), [](int n) { return n * 2; });
-    end = std::chrono::steady_clock::now();
-    elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
-    std::cout << "Normal transform_exclusive_scan took: " << elapsed_ns << " ns" << std::endl;
-
-    // Example: Parallel transform_exclusive_scan
-    begin = std::chrono::steady_clock::now();
-    std::vector<int> exclusive_scan_result_p(vec_copy.size());
-    std::transform_exclusive_scan(std::execution::par, vec_copy.begin(), vec_copy.end(), exclusive_scan_result_p.begin(), 0, std::plus<>(), [](int n) { return n * 2; });
-    end = std::chrono::steady_clock::now();
-    elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
-    std::cout << "Parallel transform_exclusive_scan took: " << elapsed_ns << " ns" << std::endl;
+    bench::compare(runner, "transform_exclusive_scan", N,
+        [&] { std::transform_exclusive_scan(vec.begin(), vec.end(), scan_result.begin(), std::int64_t{0}, std::plus<>(), [](int n) { return n * 2; }); },
+        [&] { std::transform_exclusive_scan(std::execution::par, vec.begin(), vec.end(), scan_result.begin(), std::int64_t{0}, std::plus<>(), [](int n) { return n * 2; }); },
+        [&] { exec::transform_exclusive_scan(pool, vec.begin(), vec.end(), scan_result.begin(), std::int64_t{0}, std::plus<>(), [](int n) { return n * 2; }); });
+    runner.set_bytes_per_call(0);
+}
+
+void dot_product_and_norm() {
+    std::cout << "\n[dot_product_and_norm]" << std::endl;
 
     // transform_reduce to perform dot product of two vectors
     std::vector<double> vec_a(10);
@@ -262,7 +5202,1016 @@ int main() {
 
     std::cout << "Parallel Norm: " << norm_par << std::endl;
 
-   
+    // the same through the BLAS-1 kernels; see blas1_benchmark for vectors worth vectorizing
+    std::cout << "Dot product (blas1 " << simd::to_string(blas1::best().isa) << "): "
+              << blas1::dot(vec_a.data(), vec_b.data(), vec_a.size()) << std::endl;
+    std::cout << "Norm (blas1 " << simd::to_string(blas1::best().isa) << "): " << blas1::nrm2(vec_a.data(), vec_a.size()) << std::endl;
+
+    // and as the 1 x 10 times 10 x 1 matrix product; see gemm_benchmark for matrices
+    double product = 0;
+    gemm::gemm(exec::par_on(exec::default_pool()), 1, 1, vec_a.size(), 1.0, vec_a.data(), vec_a.size(), vec_b.data(), 1, 0.0, &product, 1);
+    std::cout << "Dot product (gemm " << simd::to_string(gemm::best<double>().isa) << "): " << product << std::endl;
+
+    // bit-identical for any thread count; see reproducible_reduction_benchmark
+    const exec::pool_policy pool = exec::par_on(exec::default_pool());
+    std::cout << "Reproducible dot product: " << repro::dot(pool, vec_a.data(), vec_b.data(), vec_a.size())
+              << " (exact: " << repro::exact_dot(pool, vec_a.data(), vec_b.data(), vec_a.size()) << ")" << std::endl;
+    std::cout << "Reproducible norm: " << repro::nrm2(pool, vec_a.data(), vec_a.size()) << std::endl;
+}
+
+/*
+    Scaling sweep
+
+    The seq-vs-par comparison above runs at a single size, which says nothing about where
+    std::execution::par starts to pay off. The sweep runs every algorithm for input sizes
+    from --min-size to --max-size (powers of 4, 1K to 1G by default) and for every thread
+    count in --threads (default 1, 2, 4, ... up to hardware_concurrency), and reports:
+
+    - speedup:    seq median / par median
+    - efficiency: speedup / threads
+    - crossover:  the smallest size from which par is faster than seq at every larger size
+                  of the sweep, per thread count. "Faster" means the 95% confidence intervals
+                  of the two medians do not overlap, so noise alone cannot move the cutoff.
+                  This is the value to use as the sequential/parallel cutoff.
+
+    Every row also runs the exec:: algorithms on an exec::ThreadPool of exactly that many
+    threads, with the same speedup, efficiency and crossover columns.
+
+    The thread count of std::execution::par is only controllable where the standard library
+    exposes its backend: with libstdc++ the parallel algorithms run on TBB and are capped with
+    tbb::global_control. Elsewhere par is measured at the default thread count only and shows
+    "-" in the other rows; the pool rows are measured everywhere.
+
+    Sizes that do not fit in half of the physical memory are skipped.
+*/
+struct BenchConfig {
+    std::size_t min_size = std::size_t{1} << 10;
+    std::size_t max_size = std::size_t{1} << 30;
+    std::vector<unsigned> threads;  // empty: 1, 2, 4, ... hardware_concurrency
+    std::size_t sort_budget = std::size_t{64} << 20;  // external sort memory budget in bytes
+    std::string temp_dir;                             // external sort files; empty: system temp directory
+};
+
+std::size_t physical_memory_bytes() {
+#if defined(_WIN32)
+    MEMORYSTATUSEX status{};
+    status.dwLength = sizeof(status);
+    return GlobalMemoryStatusEx(&status) ? static_cast<std::size_t>(status.ullTotalPhys) : 0;
+#else
+    long pages = sysconf(_SC_PHYS_PAGES);
+    long page_size = sysconf(_SC_PAGE_SIZE);
+    return pages > 0 && page_size > 0 ? static_cast<std::size_t>(pages) * static_cast<std::size_t>(page_size) : 0;
+#endif
+}
+
+// Caps the number of threads used by std::execution::par for its lifetime.
+class ParallelismLimit {
+public:
+    explicit ParallelismLimit([[maybe_unused]] unsigned threads) {
+#if HAS_TBB_GLOBAL_CONTROL
+        control.emplace(tbb::global_control::max_allowed_parallelism, threads);
+#endif
+    }
+    static bool supported() {
+#if HAS_TBB_GLOBAL_CONTROL
+        return true;
+#else
+        return false;
+#endif
+    }
+
+private:
+#if HAS_TBB_GLOBAL_CONTROL
+    std::optional<tbb::global_control> control;
+#endif
+};
+
+std::vector<unsigned> sweep_thread_counts(const BenchConfig& config) {
+    const unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+    if (!config.threads.empty()) return config.threads;
+    std::vector<unsigned> counts;
+    for (unsigned t = 1; t < hw; t *= 2) counts.push_back(t);
+    counts.push_back(hw);
+    return counts;
+}
+
+struct SweepBuffers {
+    std::vector<int> input;       // shuffled 0..n-1, never modified
+    std::vector<int> work;        // scratch copy for the algorithms that modify their input
+    std::vector<unsigned> out;    // transform / scan output (unsigned so the scans wrap instead of overflowing)
+};
+
+struct SweepAlgorithm {
+    const char* name;
+    bool modifies_input;
+    std::size_t (*bytes)(const SweepBuffers&);  // memory traffic of one call, 0 when it has no fixed figure
+    std::function<void(SweepBuffers&)> seq;
+    std::function<void(SweepBuffers&)> par;
+    std::function<void(SweepBuffers&, const exec::pool_policy&)> pool;
+};
+
+std::vector<SweepAlgorithm> sweep_algorithms() {
+    auto to_unsigned = [](int n) { return static_cast<unsigned>(n); };
+    auto no_figure = [](const SweepBuffers&) { return std::size_t{0}; };
+    auto read_input = [](const SweepBuffers& b) { return b.input.size() * sizeof(int); };
+    auto read_write = [](const SweepBuffers& b) { return b.input.size() * (sizeof(int) + sizeof(unsigned)); };
+    // find stops at the match
+    auto read_to_middle_value = [](const SweepBuffers& b) {
+        const auto it = std::find(b.input.begin(), b.input.end(), static_cast<int>(b.input.size() / 2));
+        return static_cast<std::size_t>(it - b.input.begin() + (it != b.input.end())) * sizeof(int);
+    };
+    return {
+        {"sort", true, no_figure,
+            [](SweepBuffers& b) { std::sort(b.work.begin(), b.work.end()); },
+            [](SweepBuffers& b) { std::sort(std::execution::par, b.work.begin(), b.work.end()); },
+            [](SweepBuffers& b, const exec::pool_policy& p) { exec::sort(p, b.work.begin(), b.work.end()); }},
+        {"reduce", false, read_input,
+            [](SweepBuffers& b) { bench::do_not_optimize(std::reduce(b.input.begin(), b.input.end(), std::int64_t{0})); },
+            [](SweepBuffers& b) { bench::do_not_optimize(std::reduce(std::execution::par, b.input.begin(), b.input.end(), std::int64_t{0})); },
+            [](SweepBuffers& b, const exec::pool_policy& p) { bench::do_not_optimize(exec::reduce(p, b.input.begin(), b.input.end(), std::int64_t{0})); }},
+        {"for_each", false, read_write,
+            [](SweepBuffers& b) { std::for_each(b.work.begin(), b.work.end(), [](int& n) { n++; }); },
+            [](SweepBuffers& b) { std::for_each(std::execution::par, b.work.begin(), b.work.end(), [](int& n) { n++; }); },
+            [](SweepBuffers& b, const exec::pool_policy& p) { exec::for_each(p, b.work.begin(), b.work.end(), [](int& n) { n++; }); }},
+        {"transform", false, read_write,
+            [](SweepBuffers& b) { std::transform(b.input.begin(), b.input.end(), b.out.begin(), [](int n) { return static_cast<unsigned>(n) * 2u; }); },
+            [](SweepBuffers& b) { std::transform(std::execution::par, b.input.begin(), b.input.end(), b.out.begin(), [](int n) { return static_cast<unsigned>(n) * 2u; }); },
+            [](SweepBuffers& b, const exec::pool_policy& p) { exec::transform(p, b.input.begin(), b.input.end(), b.out.begin(), [](int n) { return static_cast<unsigned>(n) * 2u; }); }},
+        {"find", false, read_to_middle_value,
+            [](SweepBuffers& b) { bench::do_not_optimize(std::find(b.input.begin(), b.input.end(), static_cast<int>(b.input.size() / 2))); },
+            [](SweepBuffers& b) { bench::do_not_optimize(std::find(std::execution::par, b.input.begin(), b.input.end(), static_cast<int>(b.input.size() / 2))); },
+            [](SweepBuffers& b, const exec::pool_policy& p) { bench::do_not_optimize(exec::find(p, b.input.begin(), b.input.end(), static_cast<int>(b.input.size() / 2))); }},
+        {"count", false, read_input,
+            [](SweepBuffers& b) { bench::do_not_optimize(std::count(b.input.begin(), b.input.end(), static_cast<int>(b.input.size() / 2))); },
+            [](SweepBuffers& b) { bench::do_not_optimize(std::count(std::execution::par, b.input.begin(), b.input.end(), static_cast<int>(b.input.size() / 2))); },
+            [](SweepBuffers& b, const exec::pool_policy& p) { bench::do_not_optimize(exec::count(p, b.input.begin(), b.input.end(), static_cast<int>(b.input.size() / 2))); }},
+        {"inclusive_scan", false, read_write,
+            [=](SweepBuffers& b) { std::transform_inclusive_scan(b.input.begin(), b.input.end(), b.out.begin(), std::plus<>(), to_unsigned); },
+            [=](SweepBuffers& b) { std::transform_inclusive_scan(std::execution::par, b.input.begin(), b.input.end(), b.out.begin(), std::plus<>(), to_unsigned); },
+            [=](SweepBuffers& b, const exec::pool_policy& p) { exec::transform_inclusive_scan(p, b.input.begin(), b.input.end(), b.out.begin(), std::plus<>(), to_unsigned, 0u); }},
+        {"exclusive_scan", false, read_write,
+            [=](SweepBuffers& b) { std::transform_exclusive_scan(b.input.begin(), b.input.end(), b.out.begin(), 0u, std::plus<>(), to_unsigned); },
+            [=](SweepBuffers& b) { std::transform_exclusive_scan(std::execution::par, b.input.begin(), b.input.end(), b.out.begin(), 0u, std::plus<>(), to_unsigned); },
+            [=](SweepBuffers& b, const exec::pool_policy& p) { exec::transform_exclusive_scan(p, b.input.begin(), b.input.end(), b.out.begin(), 0u, std::plus<>(), to_unsigned); }},
+    };
+}
+
+void scaling_sweep(bench::Runner& runner, const BenchConfig& config) {
+    std::cout << "\n[scaling_sweep]" << std::endl;
+
+    const std::vector<unsigned> thread_counts = sweep_thread_counts(config);
+    const unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+    if (!ParallelismLimit::supported())
+        std::cout << "note: the thread count of std::execution::par cannot be set with this standard library; "
+                     "measuring par at the default (" << hw << " threads) only" << std::endl;
+
+    std::vector<std::size_t> sizes;
+    for (std::size_t n = config.min_size; n <= config.max_size; n *= 4) sizes.push_back(n);
+
+    const std::size_t memory_limit = physical_memory_bytes() / 2;
+    const bench::Options base_options = runner.options();
+    const auto algorithms = sweep_algorithms();
+
+    // seq[a][s], par[a][t][s], pool[a][t][s]; zero samples when the size was skipped
+    using PerThread = std::vector<std::vector<std::vector<bench::Stats>>>;
+    std::vector<std::vector<bench::Stats>> seq(algorithms.size(), std::vector<bench::Stats>(sizes.size()));
+    PerThread par(algorithms.size(), std::vector<std::vector<bench::Stats>>(thread_counts.size(), std::vector<bench::Stats>(sizes.size())));
+    PerThread pool = par;
+
+    std::vector<std::unique_ptr<exec::ThreadPool>> pools;
+    for (unsigned t : thread_counts) pools.push_back(std::make_unique<exec::ThreadPool>(t));
+
+    std::cout << std::left << std::setw(16) << "algorithm" << std::right << std::setw(12) << "size"
+              << std::setw(9) << "threads" << std::setw(13) << "seq" << std::setw(13) << "par"
+              << std::setw(13) << "pool" << std::setw(10) << "par x" << std::setw(10) << "par eff"
+              << std::setw(10) << "pool x" << std::setw(10) << "pool eff" << std::setw(28) << "pool bandwidth" << std::endl;
+
+    for (std::size_t si = 0; si < sizes.size(); ++si) {
+        const std::size_t n = sizes[si];
+        const std::size_t bytes_needed = n * (2 * sizeof(int) + sizeof(unsigned));
+        if (memory_limit != 0 && bytes_needed > memory_limit) {
+            std::cout << "skipping size " << n << ": needs " << (bytes_needed >> 20) << " MiB, limit is "
+                      << (memory_limit >> 20) << " MiB" << std::endl;
+            continue;
+        }
+
+        SweepBuffers buffers;
+        buffers.input.resize(n);
+        std::iota(buffers.input.begin(), buffers.input.end(), 0);
+        rng::shuffle(exec::par_on(exec::default_pool()), buffers.input.begin(), buffers.input.end(), 42);  // fits in bytes_needed
+        buffers.work = buffers.input;
+        buffers.out.resize(n);
+
+        // Large inputs take seconds per call; a few samples are enough there.
+        bench::Options options = base_options;
+        options.verbose = false;
+        if (n >= (std::size_t{1} << 24)) {
+            options.min_samples = 3;
+            options.warmup = std::chrono::nanoseconds{0};
+        }
+        runner.set_options(options);
+
+        for (std::size_t ai = 0; ai < algorithms.size(); ++ai) {
+            const SweepAlgorithm& algo = algorithms[ai];
+            runner.set_bytes_per_call(algo.bytes(buffers));
+            std::function<void()> reset = [] {};
+            if (algo.modifies_input)
+                reset = [&buffers] { std::copy(buffers.input.begin(), buffers.input.end(), buffers.work.begin()); };
+
+            seq[ai][si] = runner.run(algo.name, "seq", n, reset, [&] { algo.seq(buffers); }).stats;
+            for (std::size_t ti = 0; ti < thread_counts.size(); ++ti) {
+                const unsigned t = thread_counts[ti];
+                if (ParallelismLimit::supported() || t == hw) {
+                    ParallelismLimit limit{t};
+                    bench::Result& r = runner.run(algo.name, "par", n, reset, [&] { algo.par(buffers); });
+                    r.threads = t;
+                    par[ai][ti][si] = r.stats;
+                }
+                const exec::pool_policy policy = exec::par_on(*pools[ti]);
+                bench::Result& r = runner.run(algo.name, "pool", n, reset, [&] { algo.pool(buffers, policy); });
+                r.threads = t;
+                pool[ai][ti][si] = r.stats;
+
+                // time, speedup and efficiency columns, or dashes when the variant was not measured
+                auto columns = [&](const bench::Stats& stats) {
+                    std::ostringstream cols;
+                    if (stats.samples == 0) return std::string{"-"};
+                    const double speedup = seq[ai][si].median / stats.median;
+                    cols << std::fixed << std::setprecision(2) << speedup << "x" << std::setw(9)
+                         << speedup / t * 100.0 << "%";
+                    return cols.str();
+                };
+                const bench::Stats& p = par[ai][ti][si];
+                std::cout << std::left << std::setw(16) << algo.name << std::right << std::setw(12) << n
+                          << std::setw(9) << t << std::setw(13) << bench::format_ns(seq[ai][si].median)
+                          << std::setw(13) << (p.samples ? bench::format_ns(p.median) : std::string{"-"})
+                          << std::setw(13) << bench::format_ns(r.stats.median)
+                          << std::setw(20) << columns(p) << std::setw(20) << columns(r.stats) << std::setw(28)
+                          << (r.bytes ? bench::format_bandwidth(r.gb_per_s(), runner.peak_bandwidth()) : std::string{"-"}) << std::endl;
+            }
+        }
+    }
+    runner.set_options(base_options);
+    runner.set_bytes_per_call(0);
+
+    auto print_crossovers = [&](const char* variant, const PerThread& stats) {
+        std::cout << "\ncrossover size (" << variant << " faster than seq from this size on):" << std::endl;
+        std::cout << std::left << std::setw(16) << "algorithm" << std::right;
+        for (unsigned t : thread_counts) std::cout << std::setw(12) << (std::to_string(t) + " thr");
+        std::cout << std::endl;
+        for (std::size_t ai = 0; ai < algorithms.size(); ++ai) {
+            std::cout << std::left << std::setw(16) << algorithms[ai].name << std::right;
+            for (std::size_t ti = 0; ti < thread_counts.size(); ++ti) {
+                // walk down from the largest measured size while the parallel variant keeps winning
+                std::optional<std::size_t> crossover;
+                bool measured = false;
+                for (std::size_t si = sizes.size(); si-- > 0;) {
+                    if (seq[ai][si].samples == 0 || stats[ai][ti][si].samples == 0) continue;
+                    measured = true;
+                    if (stats[ai][ti][si].median_ci_high >= seq[ai][si].median_ci_low) break;
+                    crossover = sizes[si];
+                }
+                std::cout << std::setw(12) << (!measured ? std::string{"-"} : crossover ? std::to_string(*crossover) : std::string{"never"});
+            }
+            std::cout << std::endl;
+        }
+    };
+    print_crossovers("par", par);
+    print_crossovers("pool", pool);
+}
+
+/*
+    Memory bandwidth (STREAM) and roofline annotations
+
+    Whether more threads help a transform or a for_each depends on whether it is limited by
+    the cores or by memory bandwidth, and the bandwidth of a machine is best measured rather
+    than taken from a data sheet. The stream suite runs the four STREAM kernels (McCalpin) on
+    arrays of doubles several times the size of the last level cache, on pools of every thread
+    count of the sweep (--threads):
+
+        copy:  c[i] = a[i]               16 bytes per element
+        scale: b[i] = s * c[i]           16 bytes
+        add:   c[i] = a[i] + b[i]        24 bytes
+        triad: a[i] = b[i] + s * c[i]    24 bytes
+
+    Bytes are counted the STREAM way: what the kernel reads and writes, not the extra read
+    of the write-allocate a store to an uncached line costs. The arrays are allocated
+    uninitialized and first touched on the pool with the split the kernels use, chunk c on
+    thread c every time (parallel_for_each_thread), so with first-touch placement the pages
+    of a chunk are on the NUMA node of the thread that runs it. The best result of all
+    kernels and thread counts is the peak that the benchmarks compare against
+    (Runner::set_peak_bandwidth); the suite also prints the thread count from which triad
+    stays within 10% of the peak, beyond which a memory bound operation does not get faster.
+
+    --roofline measures the peak up front with a short triad run on all threads, so that
+    every annotated benchmark shows its share of the peak even without the stream suite.
+    Shares above 100% mean the input fits in a cache and the operation is not bound by DRAM.
+*/
+namespace stream {
+
+// Uninitialized until make_arrays touches them on the pool.
+struct Arrays {
+    std::size_t n = 0;
+    std::unique_ptr<double[]> a, b, c;
+};
+
+struct Kernel {
+    const char* name;
+    std::size_t bytes_per_element;
+    void (*run)(Arrays&, std::size_t, std::size_t, double);
+};
+
+inline const std::array<Kernel, 4>& kernels() {
+    static const std::array<Kernel, 4> all{{
+        {"copy", 2 * sizeof(double), [](Arrays& v, std::size_t b, std::size_t e, double) {
+            for (std::size_t i = b; i < e; ++i) v.c[i] = v.a[i];
+        }},
+        {"scale", 2 * sizeof(double), [](Arrays& v, std::size_t b, std::size_t e, double s) {
+            for (std::size_t i = b; i < e; ++i) v.b[i] = s * v.c[i];
+        }},
+        {"add", 3 * sizeof(double), [](Arrays& v, std::size_t b, std::size_t e, double) {
+            for (std::size_t i = b; i < e; ++i) v.c[i] = v.a[i] + v.b[i];
+        }},
+        {"triad", 3 * sizeof(double), [](Arrays& v, std::size_t b, std::size_t e, double s) {
+            for (std::size_t i = b; i < e; ++i) v.a[i] = v.b[i] + s * v.c[i];
+        }},
+    }};
+    return all;
+}
+
+// One chunk per thread, chunk c always on thread c, so that every thread keeps working on
+// the pages it touched first.
+inline void run(const exec::pool_policy& policy, const Kernel& kernel, Arrays& v, double scalar) {
+    exec::for_each_thread_chunk(policy, v.n, [&](std::size_t, std::size_t b, std::size_t e) { kernel.run(v, b, e, scalar); });
+}
+
+// Allocates the arrays without touching them and initializes them on the pool, with the
+// same split as run.
+inline Arrays make_arrays(const exec::pool_policy& policy, std::size_t n) {
+    Arrays v{n, std::make_unique_for_overwrite<double[]>(n), std::make_unique_for_overwrite<double[]>(n),
+             std::make_unique_for_overwrite<double[]>(n)};
+    exec::for_each_thread_chunk(policy, n, [&](std::size_t, std::size_t b, std::size_t e) {
+        std::fill(v.a.get() + b, v.a.get() + e, 1.0);
+        std::fill(v.b.get() + b, v.b.get() + e, 2.0);
+        std::fill(v.c.get() + b, v.c.get() + e, 0.0);
+    });
+    return v;
+}
+
+// Elements per array: 4x the last level cache per array as STREAM asks, within a quarter of the RAM.
+inline std::size_t array_elements() {
+    std::size_t bytes = std::max<std::size_t>(cache_sizes()[2] * 4, std::size_t{64} << 20);
+    if (const std::size_t ram = physical_memory_bytes(); ram != 0) bytes = std::min(bytes, ram / 4 / 3);
+    return bytes / sizeof(double);
+}
+
+// Best triad bandwidth in GB/s on all hardware threads over a few repetitions.
+inline double measure_peak() {
+    exec::ThreadPool pool;
+    const exec::pool_policy policy = exec::par_on(pool);
+    Arrays v = make_arrays(policy, array_elements());
+    const Kernel& triad = kernels()[3];
+    double best_ns = std::numeric_limits<double>::max();
+    for (int rep = 0; rep < 10; ++rep) {
+        const auto t0 = bench::clock::now();
+        run(policy, triad, v, 3.0);
+        best_ns = std::min(best_ns, static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(bench::clock::now() - t0).count()));
+    }
+    return static_cast<double>(triad.bytes_per_element * v.n) / best_ns;
+}
+
+} // namespace stream
+
+void stream_benchmark(bench::Runner& runner, const BenchConfig& config) {
+    std::cout << "\n[stream_benchmark]" << std::endl;
+    const std::size_t n = stream::array_elements();
+    std::cout << "3 arrays of " << n << " doubles (" << (3 * n * sizeof(double) >> 20) << " MiB)" << std::endl;
+
+    const std::vector<unsigned> thread_counts = sweep_thread_counts(config);
+    const auto& kernels = stream::kernels();
+    std::vector<std::array<double, 4>> gbs(thread_counts.size());  // [thread count][kernel]
+    for (std::size_t ti = 0; ti < thread_counts.size(); ++ti) {
+        exec::ThreadPool pool{thread_counts[ti]};
+        const exec::pool_policy policy = exec::par_on(pool);
+        stream::Arrays v = stream::make_arrays(policy, n);
+        for (std::size_t k = 0; k < kernels.size(); ++k) {
+            runner.set_bytes_per_call(kernels[k].bytes_per_element * n);
+            bench::Result& r = runner.run(std::string{"stream "} + kernels[k].name, "pool", n, [&] { stream::run(policy, kernels[k], v, 3.0); });
+            r.threads = thread_counts[ti];
+            gbs[ti][k] = r.gb_per_s();
+        }
+    }
+    runner.set_bytes_per_call(0);
+
+    double peak = 0;
+    for (const auto& row : gbs) peak = std::max(peak, *std::max_element(row.begin(), row.end()));
+    runner.set_peak_bandwidth(peak);
+
+    std::cout << "\nbandwidth in GB/s:" << std::endl << std::setw(9) << "threads";
+    for (const auto& kernel : kernels) std::cout << std::setw(10) << kernel.name;
+    std::cout << std::endl;
+    for (std::size_t ti = 0; ti < thread_counts.size(); ++ti) {
+        std::ostringstream row;
+        row << std::fixed << std::setprecision(2) << std::setw(9) << thread_counts[ti];
+        for (double g : gbs[ti]) row << std::setw(10) << g;
+        std::cout << row.str() << std::endl;
+    }
+    std::ostringstream summary;
+    summary << std::fixed << std::setprecision(2) << "peak " << peak << " GB/s";
+    std::cout << summary.str() << std::endl;
+    for (std::size_t ti = 0; ti < thread_counts.size(); ++ti) {
+        const bool saturated = std::all_of(gbs.begin() + static_cast<std::ptrdiff_t>(ti), gbs.end(),
+                                           [&](const auto& row) { return row[3] >= 0.9 * peak; });
+        if (saturated) {
+            std::cout << "triad is within 10% of the peak from " << thread_counts[ti]
+                      << " threads on: more threads do not help memory bound operations" << std::endl;
+            break;
+        }
+    }
+}
+
+// Setup cost of the benchmarks: filling N ints with random values and shuffling them, with
+// one std::mt19937 against rng::generate and rng::shuffle on the pool, N up to 64M
+// (--max-size). Then checks that the pool versions give the same output on pools of every
+// thread count of the sweep (--threads) and of 3 and 5 threads.
+void random_setup_benchmark(bench::Runner& runner, const BenchConfig& config) {
+    std::cout << "\n[random_setup_benchmark]" << std::endl;
+
+    std::size_t N = std::min(config.max_size, std::size_t{1} << 26);
+    if (const std::size_t ram = physical_memory_bytes(); ram != 0) N = std::min(N, ram / 16);  // data, shuffle buffer and bucket ids
+    const exec::pool_policy pool = exec::par_on(exec::default_pool());
+    const std::uint64_t seed = std::random_device{}();
+    std::vector<int> data(N);
+
+    auto speedup = [](const bench::Result& serial, const bench::Result& parallel) {
+        std::ostringstream os;
+        os << std::fixed << std::setprecision(2) << serial.stats.median / parallel.stats.median << "x";
+        return os.str();
+    };
+    std::mt19937 mt{static_cast<std::mt19937::result_type>(seed)};
+    std::uniform_int_distribution<int> value(0, 1 << 30);
+    const bench::Result fill_mt = runner.run("fill random ints", "std::mt19937", N, [&] {
+        for (int& x : data) x = value(mt);
+    });
+    bench::Result& fill_pool = runner.run("fill random ints", "rng::generate (pool)", N, [&] {
+        rng::generate(pool, data.begin(), data.end(), seed, [](rng::Philox& engine) { return static_cast<int>(rng::bounded(engine, (1u << 30) + 1)); });
+    });
+    fill_pool.threads = exec::default_pool().size();
+    std::cout << "  -> setup time saved: " << speedup(fill_mt, fill_pool) << std::endl;
+
+    std::iota(data.begin(), data.end(), 0);
+    const bench::Result shuffle_mt = runner.run("shuffle", "std::shuffle std::mt19937", N, [&] { std::shuffle(data.begin(), data.end(), mt); });
+    bench::Result& shuffle_pool = runner.run("shuffle", "rng::shuffle (pool)", N, [&] { rng::shuffle(pool, data.begin(), data.end(), seed); });
+    shuffle_pool.threads = exec::default_pool().size();
+    std::cout << "  -> setup time saved: " << speedup(shuffle_mt, shuffle_pool) << std::endl;
+
+    // same seed, different pools: the outputs must not differ in a single element
+    constexpr std::size_t n = std::size_t{1} << 20;
+    std::vector<unsigned> thread_counts = sweep_thread_counts(config);
+    thread_counts.insert(thread_counts.end(), {3u, 5u});
+    std::vector<int> first_generated, first_shuffled;
+    std::ostringstream tried;
+    bool identical = true;
+    for (unsigned t : thread_counts) {
+        exec::ThreadPool threads{t};
+        std::vector<int> generated(n), shuffled(n);
+        rng::generate(exec::par_on(threads), generated.begin(), generated.end(), seed, [](rng::Philox& engine) { return static_cast<int>(engine()); });
+        std::iota(shuffled.begin(), shuffled.end(), 0);
+        rng::shuffle(exec::par_on(threads), shuffled.begin(), shuffled.end(), seed);
+        if (first_generated.empty()) {
+            first_generated = std::move(generated);
+            first_shuffled = std::move(shuffled);
+        } else {
+            identical = identical && generated == first_generated && shuffled == first_shuffled;
+        }
+        tried << ' ' << t;
+    }
+    if (!identical)
+        throw std::runtime_error("rng::generate / rng::shuffle: output changed with the thread count (pools of" + tried.str() + " threads)");
+    std::cout << "output for " << n << " elements on pools of" << tried.str() << " threads: identical" << std::endl;
+}
+
+/*
+    External merge sort
+
+    For inputs that do not fit in memory, extsort::sort_file sorts a binary file of trivially
+    copyable records within a fixed memory budget:
+
+        extsort::Options options;
+        options.memory_budget = std::size_t{256} << 20;
+        extsort::sort_file<std::uint64_t>("keys.bin", "sorted.bin", options);
+
+    1. Run formation: the input is read one run at a time, each run is sorted on the thread
+       pool (exec::sort) and spilled to a temporary file. The write of run i overlaps the
+       read and sort of run i + 1 (write-behind). A run holds a third of the budget: the run
+       being sorted, the scratch buffer of the sample sort and the run being written.
+    2. Merge: the runs are merged k at a time with a loser tree, which finds the next
+       smallest element with one comparison per tree level (log2 k) instead of the two a
+       binary heap needs. Every input run and the output have two blocks, so the next block
+       is read (read-ahead) or the previous one written (write-behind) on another thread
+       while the current one is consumed. The budget is divided evenly over these 2k + 2
+       blocks; when k is so large that blocks would drop below Options::min_block, the runs
+       are merged in several passes through intermediate files.
+
+    Like std::sort, the result is not stable: runs are sorted with exec::sort. Temporary files
+    go to a fresh directory under Options::temp_dir and are removed when the sort returns or
+    throws.
+    I/O errors are reported as std::runtime_error.
+*/
+namespace extsort {
+
+struct Options {
+    std::size_t memory_budget = std::size_t{64} << 20;  // bytes of record buffers
+    std::size_t min_block = std::size_t{256} << 10;     // smallest merge I/O block in bytes
+    std::filesystem::path temp_dir;                     // empty: std::filesystem::temp_directory_path()
+    exec::ThreadPool* pool = nullptr;                   // null: exec::default_pool()
+};
+
+struct Report {
+    std::size_t elements = 0;
+    std::size_t runs = 0;
+    std::size_t merge_passes = 0;
+    std::chrono::duration<double> run_time{};    // run formation
+    std::chrono::duration<double> merge_time{};  // all merge passes
+};
+
+// Scratch directory that is removed with everything in it on destruction.
+class TempDir {
+public:
+    explicit TempDir(const std::filesystem::path& parent) {
+        std::random_device rd;
+        for (int attempt = 0; attempt < 16; ++attempt) {
+            std::ostringstream name;
+            name << "extsort-" << std::hex << rd() << rd();
+            std::filesystem::path candidate = parent / name.str();
+            if (std::filesystem::create_directory(candidate)) {
+                dir = candidate;
+                return;
+            }
+        }
+        throw std::runtime_error("cannot create a temporary directory in " + parent.string());
+    }
+    TempDir(const TempDir&) = delete;
+    TempDir& operator=(const TempDir&) = delete;
+    ~TempDir() {
+        std::error_code ec;
+        std::filesystem::remove_all(dir, ec);
+    }
+
+    std::filesystem::path file(std::size_t id) const { return dir / ("run" + std::to_string(id) + ".bin"); }
+
+private:
+    std::filesystem::path dir;
+};
+
+namespace detail {
+
+// Blocks are large, so the streams skip their own buffer; setbuf only takes effect before
+// the file is opened.
+inline std::ifstream open_in(const std::filesystem::path& path) {
+    std::ifstream in;
+    in.rdbuf()->pubsetbuf(nullptr, 0);
+    in.open(path, std::ios::binary);
+    if (!in) throw std::runtime_error("cannot open " + path.string() + " for reading");
+    return in;
+}
+
+inline std::ofstream open_out(const std::filesystem::path& path) {
+    std::ofstream out;
+    out.rdbuf()->pubsetbuf(nullptr, 0);
+    out.open(path, std::ios::binary | std::ios::trunc);
+    if (!out) throw std::runtime_error("cannot open " + path.string() + " for writing");
+    return out;
+}
+
+// Reads up to buffer.size() records; returns how many were read.
+template <class T>
+std::size_t read_block(std::ifstream& in, std::vector<T>& buffer) {
+    in.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(buffer.size() * sizeof(T)));
+    if (in.bad()) throw std::runtime_error("read error");
+    const auto bytes = static_cast<std::size_t>(in.gcount());
+    if (bytes % sizeof(T) != 0) throw std::runtime_error("file size is not a multiple of the record size");
+    return bytes / sizeof(T);
+}
+
+template <class T>
+void write_block(std::ofstream& out, const T* data, std::size_t n) {
+    out.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(n * sizeof(T)));
+    if (!out) throw std::runtime_error("write error");
+}
+
+// Sequential reader of one sorted run with one block of read-ahead.
+template <class T>
+class RunReader {
+public:
+    RunReader(const std::filesystem::path& path, std::size_t block) : in(open_in(path)), current(block), ahead(block) {
+        pending = std::async(std::launch::async, [this] { return read_block(in, ahead); });
+        advance_block();
+    }
+    RunReader(const RunReader&) = delete;
+    RunReader& operator=(const RunReader&) = delete;
+    ~RunReader() {
+        if (pending.valid()) pending.wait();
+    }
+
+    // Current record, or nullptr once the run is exhausted.
+    const T* head() const { return pos < size ? &current[pos] : nullptr; }
+
+    void pop() {
+        if (++pos == size) advance_block();
+    }
+
+private:
+    void advance_block() {
+        if (!pending.valid()) {  // the last read returned a partial block: end of run
+            size = pos = 0;
+            return;
+        }
+        size = pending.get();
+        pos = 0;
+        std::swap(current, ahead);
+        if (size == current.size()) pending = std::async(std::launch::async, [this] { return read_block(in, ahead); });
+    }
+
+    std::ifstream in;
+    std::vector<T> current, ahead;
+    std::future<std::size_t> pending;
+    std::size_t size = 0, pos = 0;
+};
+
+// Sequential writer with one block of write-behind. finish() must be called to flush and
+// to see write errors; destroying an unfinished writer drops the tail.
+template <class T>
+class RunWriter {
+public:
+    RunWriter(const std::filesystem::path& path, std::size_t block) : out(open_out(path)), current(block), behind(block) {}
+    RunWriter(const RunWriter&) = delete;
+    RunWriter& operator=(const RunWriter&) = delete;
+    ~RunWriter() {
+        if (pending.valid()) pending.wait();
+    }
+
+    void push(const T& value) {
+        current[size++] = value;
+        if (size == current.size()) flush();
+    }
+
+    void finish() {
+        flush();
+        if (pending.valid()) pending.get();
+        out.flush();
+        if (!out) throw std::runtime_error("write error");
+    }
+
+private:
+    void flush() {
+        if (size == 0) return;
+        if (pending.valid()) pending.get();
+        std::swap(current, behind);
+        pending = std::async(std::launch::async, [this, n = size] { write_block(out, behind.data(), n); });
+        size = 0;
+    }
+
+    std::ofstream out;
+    std::vector<T> current, behind;
+    std::future<void> pending;
+    std::size_t size = 0;
+};
+
+// Tournament tree over k sources. tree[0] holds the index of the source with the smallest
+// head, tree[1..k-1] the loser of the match played at that node; the leaves are implicit
+// at positions k..2k-1. An exhausted source (head() == nullptr) loses every match, and ties
+// go to the lower index, so equal elements leave in run order.
+template <class T, class Source, class Compare>
+class LoserTree {
+public:
+    LoserTree(const std::vector<Source*>& sources, Compare comp) : src(sources), comp(comp), k(sources.size()), tree(std::max<std::size_t>(k, 1)) {
+        if (k == 0) return;
+        std::vector<std::size_t> winner(2 * k);
+        for (std::size_t i = 0; i < k; ++i) winner[k + i] = i;
+        for (std::size_t node = k - 1; node >= 1; --node) {
+            std::size_t a = winner[2 * node], b = winner[2 * node + 1];
+            bool a_wins = beats(a, b);
+            winner[node] = a_wins ? a : b;
+            tree[node] = a_wins ? b : a;
+        }
+        tree[0] = k == 1 ? 0 : winner[1];
+    }
+
+    // Source holding the smallest head, or nullptr when all are exhausted.
+    Source* top() const { return k != 0 && src[tree[0]]->head() ? src[tree[0]] : nullptr; }
+
+    // Call after popping from top() to bring the next smallest head to the top.
+    void replay() {
+        std::size_t winner = tree[0];
+        for (std::size_t node = (winner + k) / 2; node >= 1; node /= 2) {
+            if (beats(tree[node], winner)) std::swap(tree[node], winner);
+        }
+        tree[0] = winner;
+    }
+
+private:
+    bool beats(std::size_t a, std::size_t b) const {
+        const T* x = src[a]->head();
+        const T* y = src[b]->head();
+        if (!x) return false;
+        if (!y) return true;
+        if (comp(*x, *y)) return true;
+        if (comp(*y, *x)) return false;
+        return a < b;
+    }
+
+    const std::vector<Source*>& src;
+    Compare comp;
+    std::size_t k;
+    std::vector<std::size_t> tree;
+};
+
+template <class T, class Compare>
+void merge_runs(const std::vector<std::filesystem::path>& runs, const std::filesystem::path& output,
+                std::size_t budget, Compare comp) {
+    const std::size_t block = std::max<std::size_t>(1, budget / ((2 * runs.size() + 2) * sizeof(T)));
+    std::vector<std::unique_ptr<RunReader<T>>> readers;
+    std::vector<RunReader<T>*> sources;
+    for (const auto& run : runs) {
+        readers.push_back(std::make_unique<RunReader<T>>(run, block));
+        sources.push_back(readers.back().get());
+    }
+    RunWriter<T> writer{output, block};
+    LoserTree<T, RunReader<T>, Compare> tree{sources, comp};
+    while (RunReader<T>* source = tree.top()) {
+        writer.push(*source->head());
+        source->pop();
+        tree.replay();
+    }
+    writer.finish();
+}
+
+} // namespace detail
+
+inline constexpr std::size_t max_fan_in = 512;
+
+template <class T, class Compare = std::less<>>
+Report sort_file(const std::filesystem::path& input, const std::filesystem::path& output,
+                 const Options& options = {}, Compare comp = {}) {
+    static_assert(std::is_trivially_copyable_v<T>, "records are read and written as raw bytes");
+    const std::size_t run_elements = options.memory_budget / (3 * sizeof(T));
+    // at least 2 runs and the output need two blocks of at least one record each
+    if (run_elements == 0 || options.memory_budget < 6 * sizeof(T))
+        throw std::invalid_argument("memory budget too small for one record per buffer");
+
+    exec::ThreadPool& pool = options.pool ? *options.pool : exec::default_pool();
+    TempDir temp{options.temp_dir.empty() ? std::filesystem::temp_directory_path() : options.temp_dir};
+    std::size_t next_file = 0;
+    Report report;
+
+    // 1. sorted runs: sort one buffer while the previous run is written in the background
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<std::filesystem::path> runs;
+    {
+        std::ifstream in = detail::open_in(input);
+        std::vector<T> buffer(run_elements), writing;
+        std::ofstream run_out;
+        std::future<void> pending;  // declared last: an exception waits for the write first
+        while (true) {
+            buffer.resize(run_elements);
+            const std::size_t n = detail::read_block(in, buffer);
+            if (n == 0) break;
+            buffer.resize(n);
+            exec::sort(exec::par_on(pool), buffer.begin(), buffer.end(), comp);
+            if (pending.valid()) pending.get();
+            std::swap(buffer, writing);
+            runs.push_back(temp.file(next_file++));
+            run_out = detail::open_out(runs.back());
+            pending = std::async(std::launch::async, [&] {
+                detail::write_block(run_out, writing.data(), writing.size());
+                run_out.close();
+                if (!run_out) throw std::runtime_error("write error");
+            });
+            report.elements += n;
+        }
+        if (pending.valid()) pending.get();
+    }
+    report.runs = runs.size();
+    auto t1 = std::chrono::steady_clock::now();
+    report.run_time = t1 - t0;
+
+    // 2. merge passes: as many runs at once as the budget allows at min_block per block, and
+    //    no more than max_fan_in so the number of open files stays well below the OS limits
+    const std::size_t blocks = options.memory_budget / std::max<std::size_t>(options.min_block, sizeof(T));
+    const std::size_t fan_in = std::clamp<std::size_t>(blocks / 2, 3, max_fan_in + 1) - 1;
+    while (runs.size() > fan_in) {
+        std::vector<std::filesystem::path> merged;
+        for (std::size_t i = 0; i < runs.size(); i += fan_in) {
+            std::vector<std::filesystem::path> group(runs.begin() + static_cast<std::ptrdiff_t>(i),
+                                                     runs.begin() + static_cast<std::ptrdiff_t>(std::min(runs.size(), i + fan_in)));
+            if (group.size() == 1) {
+                merged.push_back(group.front());
+                continue;
+            }
+            merged.push_back(temp.file(next_file++));
+            detail::merge_runs<T>(group, merged.back(), options.memory_budget, comp);
+            for (const auto& run : group) std::filesystem::remove(run);
+        }
+        runs = std::move(merged);
+        ++report.merge_passes;
+    }
+    detail::merge_runs<T>(runs, output, options.memory_budget, comp);
+    ++report.merge_passes;
+    report.merge_time = std::chrono::steady_clock::now() - t1;
+    return report;
+}
+
+} // namespace extsort
+
+// Sorts a file of random 64-bit keys that is 10 times the memory budget and reports the
+// throughput (input bytes / total time) and the time of each phase. The input is written
+// right before the sort, so part of it may still be in the page cache; sizes well above the
+// free RAM give numbers closer to the disk itself.
+void external_sort_benchmark(bench::Runner& runner, const BenchConfig& config) {
+    std::cout << "\n[external_sort]" << std::endl;
+    using Key = std::uint64_t;
+
+    const std::filesystem::path dir = config.temp_dir.empty() ? std::filesystem::temp_directory_path() : std::filesystem::path{config.temp_dir};
+    const std::size_t budget = config.sort_budget;
+    const std::size_t n = 10 * (budget / sizeof(Key));
+    const std::size_t bytes = n * sizeof(Key);
+    // input + runs + output are on disk at the same time
+    const auto available = std::filesystem::space(dir).available;
+    if (available < 3 * static_cast<std::uintmax_t>(bytes)) {
+        std::cout << "skipping: needs " << (3 * bytes >> 20) << " MiB free in " << dir.string() << ", have "
+                  << (available >> 20) << " MiB" << std::endl;
+        return;
+    }
+
+    extsort::TempDir files{dir};
+    const auto input = files.file(0), output = files.file(1);
+    Key checksum = 0;
+    {
+        std::ofstream out = extsort::detail::open_out(input);
+        std::mt19937_64 rng{42};
+        std::vector<Key> block(std::size_t{1} << 20);
+        for (std::size_t done = 0; done < n; done += block.size()) {
+            const std::size_t m = std::min(block.size(), n - done);
+            for (std::size_t i = 0; i < m; ++i) checksum += block[i] = rng();
+            extsort::detail::write_block(out, block.data(), m);
+        }
+    }
+
+    extsort::Options options;
+    options.memory_budget = budget;
+    options.temp_dir = dir;
+    const auto t0 = std::chrono::steady_clock::now();
+    const extsort::Report report = extsort::sort_file<Key>(input, output, options);
+    const std::chrono::duration<double> total = std::chrono::steady_clock::now() - t0;
+    runner.record("external_sort (10x budget)", "pool", n, {std::chrono::duration<double, std::nano>(total).count()})
+        .threads = exec::default_pool().size();
+
+    // the output must be sorted and hold the same keys
+    std::size_t count = 0;
+    Key sum = 0, previous = 0;
+    bool sorted = true;
+    {
+        std::ifstream in = extsort::detail::open_in(output);
+        std::vector<Key> block(std::size_t{1} << 20);
+        while (std::size_t m = extsort::detail::read_block(in, block)) {
+            for (std::size_t i = 0; i < m; ++i) {
+                sorted = sorted && (count == 0 || previous <= block[i]);
+                previous = block[i];
+                sum += block[i];
+                ++count;
+            }
+        }
+    }
+
+    const double gb = static_cast<double>(bytes) / 1e9;
+    std::ostringstream line;
+    line << std::fixed << std::setprecision(2) << "budget " << (budget >> 20) << " MiB, input " << gb << " GB, "
+         << report.runs << " runs, " << report.merge_passes << " merge pass(es)\n"
+         << "  run formation " << report.run_time.count() << " s (" << gb / report.run_time.count() << " GB/s), "
+         << "merge " << report.merge_time.count() << " s (" << gb * static_cast<double>(report.merge_passes) / report.merge_time.count() << " GB/s per pass), "
+         << "total " << total.count() << " s -> " << gb / total.count() << " GB/s";
+    std::cout << line.str() << std::endl;
+    if (!sorted || count != n || sum != checksum)
+        throw std::runtime_error("external sort: output is not a sorted permutation of the input");
+    std::cout << "  output verified" << std::endl;
+}
+
+struct Suite {
+    std::string_view name;
+    bool by_default;  // run when no suite is named on the command line
+    std::function<void(bench::Runner&, const BenchConfig&)> run;
+};
+
+std::vector<Suite> suites() {
+    return {
+        {"stream", false, stream_benchmark},
+        {"compare", true, [](bench::Runner& r, const BenchConfig&) { compare_seq_vs_par(r); }},
+        {"dot", true, [](bench::Runner&, const BenchConfig&) { dot_product_and_norm(); }},
+        {"sweep", false, scaling_sweep},
+        {"radix", true, [](bench::Runner& r, const BenchConfig&) { radix_sort_benchmark(r); }},
+        {"scan", true, [](bench::Runner& r, const BenchConfig&) { prefix_scan_benchmark(r); }},
+        {"simd", false, [](bench::Runner& r, const BenchConfig&) { simd_kernel_benchmark(r); }},
+        {"search", false, [](bench::Runner& r, const BenchConfig&) { early_exit_search_benchmark(r); }},
+        {"select", false, [](bench::Runner& r, const BenchConfig&) { selection_benchmark(r); }},
+        {"inputs", false, [](bench::Runner& r, const BenchConfig&) { input_distribution_benchmark(r); }},
+        {"histogram", false, [](bench::Runner& r, const BenchConfig&) { histogram_benchmark(r); }},
+        {"compact", false, [](bench::Runner& r, const BenchConfig&) { compaction_benchmark(r); }},
+        {"gemm", false, [](bench::Runner& r, const BenchConfig&) { gemm_benchmark(r); }},
+        {"aggregate", false, [](bench::Runner& r, const BenchConfig&) { incremental_aggregate_benchmark(r); }},
+        {"setops", false, [](bench::Runner& r, const BenchConfig&) { set_operations_benchmark(r); }},
+        {"blas1", false, [](bench::Runner& r, const BenchConfig&) { blas1_benchmark(r); }},
+        {"repro", false, [](bench::Runner& r, const BenchConfig&) { reproducible_reduction_benchmark(r); }},
+        {"extsort", false, external_sort_benchmark},
+        {"random", false, random_setup_benchmark},
+    };
+}
+
+void usage(const char* program) {
+    std::cerr << "usage: " << program << " [suite...] [--quick] [--csv=file] [--json=file]\n"
+                 "       [--min-size=n] [--max-size=n] [--threads=t1,t2,...]\n"
+                 "       [--sort-budget=bytes] [--temp-dir=path] [--roofline]\n"
+                 "suites:";
+    for (const Suite& suite : suites()) std::cerr << ' ' << suite.name << (suite.by_default ? "*" : "");
+    std::cerr << "  (* = run by default)" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    std::cout << "Hello, Parallel Algorithms!" << std::endl;
+
+    bench::Options options;
+    BenchConfig config;
+    std::string csv_path, json_path;
+    std::vector<std::string_view> selected;
+    bool roofline = false;
+    const auto all_suites = suites();
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string_view arg = argv[i];
+            auto value_of = [&](std::string_view flag) { return std::string{arg.substr(flag.size())}; };
+            if (arg == "--help") {
+                usage(argv[0]);
+                return 0;
+            } else if (arg == "--quick") {
+                options.warmup = std::chrono::milliseconds(20);
+                options.max_time = std::chrono::milliseconds(100);
+                options.min_samples = 5;
+            } else if (arg == "--roofline") {
+                roofline = true;
+            } else if (arg.substr(0, 6) == "--csv=") {
+                csv_path = value_of("--csv=");
+            } else if (arg.substr(0, 7) == "--json=") {
+                json_path = value_of("--json=");
+            } else if (arg.substr(0, 11) == "--min-size=") {
+                config.min_size = std::max<std::size_t>(1, std::stoull(value_of("--min-size=")));
+            } else if (arg.substr(0, 11) == "--max-size=") {
+                config.max_size = std::stoull(value_of("--max-size="));
+            } else if (arg.substr(0, 10) == "--threads=") {
+                std::istringstream list{value_of("--threads=")};
+                for (std::string item; std::getline(list, item, ',');)
+                    config.threads.push_back(static_cast<unsigned>(std::max(1ul, std::stoul(item))));
+            } else if (arg.substr(0, 14) == "--sort-budget=") {
+                config.sort_budget = std::stoull(value_of("--sort-budget="));
+            } else if (arg.substr(0, 11) == "--temp-dir=") {
+                config.temp_dir = value_of("--temp-dir=");
+            } else if (std::any_of(all_suites.begin(), all_suites.end(), [&](const Suite& s) { return s.name == arg; })) {
+                selected.push_back(arg);
+            } else {
+                std::cerr << "unknown argument: " << arg << std::endl;
+                usage(argv[0]);
+                return 1;
+            }
+        }
+    } catch (const std::exception&) {
+        std::cerr << "invalid numeric argument" << std::endl;
+        usage(argv[0]);
+        return 1;
+    }
+
+    bench::Runner runner{options};
+    if (roofline) {
+        runner.set_peak_bandwidth(stream::measure_peak());
+        std::ostringstream peak;
+        peak << std::fixed << std::setprecision(2) << runner.peak_bandwidth();
+        std::cout << "measured peak memory bandwidth (triad): " << peak.str() << " GB/s" << std::endl;
+    }
+
+    for (const Suite& suite : all_suites) {
+        bool run = selected.empty() ? suite.by_default
+                                    : std::find(selected.begin(), selected.end(), suite.name) != selected.end();
+        if (!run) continue;
+        try { suite.run(runner, config); }
+        catch (const std::exception& e) { std::cerr << suite.name << " error: " << e.what() << std::endl; }
+    }
+
+    if (!csv_path.empty()) {
+        std::ofstream out{csv_path};
+        runner.write_csv(out);
+    }
+    if (!json_path.empty()) {
+        std::ofstream out{json_path};
+        runner.write_json(out);
+    }
 
     return 0;
-}
\ No newline at end of file
+}
@@ -3,8 +3,40 @@
 #include <vector>
 #include <string>
 #include <unordered_map>
+#include <map>
+#include <random>
 #include <chrono>
 #include <thread>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <array>
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <utility>
+#include <cstddef>
+#include <new>
+#include <cstdio>
+#include <functional>
+#include <barrier>
+#include <iomanip>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <malloc.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+#endif
 
 /*
 The usage of std::pmr::monotonic_buffer_resource is ideal for scenarios where you need a temporary, 
@@ -81,42 +113,787 @@ void example_pool_multi_thread() {
     std::cout << "workers done" << std::endl;
 }
 
-// 4) Custom tracking resource: wraps another resource and logs usage
+// 4) Custom tracking resource: wraps another resource and records its usage: calls and
+// bytes, live bytes and their peak, a histogram of allocation sizes and a count per
+// alignment. It can be shared between threads (in front of, or as the upstream of, a
+// synchronized_pool_resource). Every thread counts into a shard of its own, with plain
+// loads and stores, so calls do not contend on the counters; snapshot() adds the shards up
+// without stopping the threads. The peak needs the live bytes of all threads at once: a
+// shard publishes its changes to a shared total once they add up to liveBatch bytes, so
+// with several threads the peak is off by up to liveBatch bytes per other thread, either
+// way (it is exact with one). A thread that frees what others allocated has a negative
+// balance; while the others have not published theirs the estimate may be below zero,
+// which counts as zero.
 struct TrackingResource : std::pmr::memory_resource {
+    static constexpr std::size_t sizeClasses = 65;   // class k: sizes in [2^(k-1), 2^k), 0 bytes in class 0
+    static constexpr std::size_t alignClasses = 64;  // class k: alignment 2^k
+    static constexpr std::size_t liveBatch = 64 * 1024;
+
+    struct Snapshot {
+        std::size_t allocations = 0, deallocations = 0;
+        std::size_t allocatedBytes = 0, deallocatedBytes = 0;
+        std::size_t liveBytes = 0, peakBytes = 0;
+        std::array<std::size_t, sizeClasses> sizeHistogram{};
+        std::array<std::size_t, alignClasses> alignmentCounts{};
+    };
+
     std::pmr::memory_resource* upstream;
-    std::size_t allocatedBytes = 0;
-    std::size_t deallocatedBytes = 0;
 
     explicit TrackingResource(std::pmr::memory_resource* up = std::pmr::get_default_resource())
         : upstream(up) {}
 
+    TrackingResource(const TrackingResource&) = delete;
+    TrackingResource& operator=(const TrackingResource&) = delete;
+
+    // Consistent per counter; counters may be a few calls apart while other threads run.
+    Snapshot snapshot() const {
+        Snapshot s;
+        auto get = [](const std::atomic<std::size_t>& c) { return c.load(std::memory_order_relaxed); };
+        std::lock_guard lock{shardsMutex};
+        for (const auto& [thread, shard] : shards) {
+            s.allocations += get(shard->allocations);
+            s.deallocations += get(shard->deallocations);
+            s.allocatedBytes += get(shard->allocatedBytes);
+            s.deallocatedBytes += get(shard->deallocatedBytes);
+            for (std::size_t k = 0; k < sizeClasses; ++k) s.sizeHistogram[k] += get(shard->sizeHistogram[k]);
+            for (std::size_t k = 0; k < alignClasses; ++k) s.alignmentCounts[k] += get(shard->alignmentCounts[k]);
+        }
+        s.liveBytes = s.allocatedBytes - s.deallocatedBytes;
+        for (const auto& [thread, shard] : shards) s.peakBytes = std::max(s.peakBytes, get(shard->peak));
+        s.peakBytes = std::max(s.peakBytes, s.liveBytes);
+        return s;
+    }
+
 private:
+    // written by one thread only
+    struct alignas(64) Shard {
+        std::atomic<std::size_t> allocations{0}, deallocations{0};
+        std::atomic<std::size_t> allocatedBytes{0}, deallocatedBytes{0};
+        std::array<std::atomic<std::size_t>, sizeClasses> sizeHistogram{};
+        std::array<std::atomic<std::size_t>, alignClasses> alignmentCounts{};
+        std::atomic<std::size_t> peak{0};
+        std::ptrdiff_t unpublished = 0;  // change of live bytes not yet in 'live'
+    };
+
+    static void bump(std::atomic<std::size_t>& c, std::size_t by) {
+        c.store(c.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+    }
+
+    // This thread's shard. A thread remembers the shards of the last few resources it used;
+    // otherwise it looks its shard up, or adds it, under the mutex. The shards stay with the
+    // resource when the thread exits (and go to a later thread with the same id).
+    Shard& localShard() {
+        struct Recent { std::uint64_t id = 0; Shard* shard = nullptr; };
+        thread_local std::array<Recent, 4> recent;
+        Recent& slot = recent[id % recent.size()];
+        if (slot.id == id) return *slot.shard;
+        std::lock_guard lock{shardsMutex};
+        auto& shard = shards[std::this_thread::get_id()];
+        if (!shard) shard = std::make_unique<Shard>();
+        slot = {id, shard.get()};
+        return *shard;
+    }
+
+    // Adds delta to the live bytes of this thread and publishes them to 'live' in batches.
+    // The peak is tracked per shard as the published total plus this thread's unpublished
+    // part, which is exact with one thread. Both can be negative for a while when threads
+    // free each other's blocks ('live' wraps around), so the sum is taken signed.
+    void countLive(Shard& s, std::ptrdiff_t delta) {
+        s.unpublished += delta;
+        if (s.unpublished >= static_cast<std::ptrdiff_t>(liveBatch) || s.unpublished <= -static_cast<std::ptrdiff_t>(liveBatch))
+            live.fetch_add(static_cast<std::size_t>(std::exchange(s.unpublished, 0)), std::memory_order_relaxed);
+        const std::ptrdiff_t estimate = static_cast<std::ptrdiff_t>(live.load(std::memory_order_relaxed)) + s.unpublished;
+        if (delta > 0 && estimate > 0 && static_cast<std::size_t>(estimate) > s.peak.load(std::memory_order_relaxed))
+            s.peak.store(static_cast<std::size_t>(estimate), std::memory_order_relaxed);
+    }
+
     void* do_allocate(std::size_t bytes, std::size_t alignment) override {
-        allocatedBytes += bytes;
-        return upstream->allocate(bytes, alignment);
+        void* p = upstream->allocate(bytes, alignment);
+        Shard& s = localShard();
+        bump(s.allocations, 1);
+        bump(s.allocatedBytes, bytes);
+        bump(s.sizeHistogram[static_cast<std::size_t>(std::bit_width(bytes))], 1);
+        bump(s.alignmentCounts[static_cast<std::size_t>(std::countr_zero(alignment))], 1);
+        countLive(s, static_cast<std::ptrdiff_t>(bytes));
+        return p;
     }
     void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
-        deallocatedBytes += bytes;
         upstream->deallocate(p, bytes, alignment);
+        Shard& s = localShard();
+        bump(s.deallocations, 1);
+        bump(s.deallocatedBytes, bytes);
+        countLive(s, -static_cast<std::ptrdiff_t>(bytes));
     }
     bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
         return this == &other;
     }
+
+    mutable std::mutex shardsMutex;
+    std::unordered_map<std::thread::id, std::unique_ptr<Shard>> shards;
+    alignas(64) std::atomic<std::size_t> live{0};  // published live bytes; written once per liveBatch
+    std::uint64_t id = nextId++;
+    static inline std::atomic<std::uint64_t> nextId{1};
 };
 
 void example_tracking_resource() {
     std::cout << "\n[example_tracking_resource]" << std::endl;
 
+    auto print = [](const TrackingResource::Snapshot& s) {
+        std::cout << "allocated: " << s.allocatedBytes << " bytes in " << s.allocations << " calls, deallocated: "
+                  << s.deallocatedBytes << " bytes in " << s.deallocations << " calls, live: " << s.liveBytes
+                  << " bytes, peak: " << s.peakBytes << " bytes" << std::endl;
+        std::cout << "sizes:";
+        for (std::size_t k = 0; k < s.sizeHistogram.size(); ++k)
+            if (s.sizeHistogram[k]) std::cout << " [" << (k ? std::size_t{1} << (k - 1) : 0) << ", " << (std::size_t{1} << k) << "): " << s.sizeHistogram[k];
+        std::cout << "\nalignments:";
+        for (std::size_t k = 0; k < s.alignmentCounts.size(); ++k)
+            if (s.alignmentCounts[k]) std::cout << " " << (std::size_t{1} << k) << ": " << s.alignmentCounts[k];
+        std::cout << std::endl;
+    };
+
     std::pmr::monotonic_buffer_resource arena{1024};
     TrackingResource tracker{&arena};
 
     std::pmr::vector<std::pmr::string> v{&tracker};
     for (int i = 0; i < 50; ++i) v.emplace_back("str_" + std::to_string(i));
+    print(tracker.snapshot());
+    // the peak is what an arena for this workload has to hold at once
+    std::cout << "an arena of " << tracker.snapshot().peakBytes << " bytes would have been enough" << std::endl;
+
+    // shared by threads in front of a synchronized pool: no lost updates, everything returned
+    std::pmr::synchronized_pool_resource sharedPool;
+    TrackingResource sharedTracker{&sharedPool};
+    std::vector<std::thread> workers;
+    for (int id = 0; id < 4; ++id)
+        workers.emplace_back([&sharedTracker, id] {
+            for (int round = 0; round < 100; ++round) {
+                std::pmr::vector<std::pmr::string> strings{&sharedTracker};
+                for (int i = 0; i < 100; ++i) strings.emplace_back("thread_" + std::to_string(id) + "_string_" + std::to_string(i));
+            }
+        });
+    for (auto& w : workers) w.join();
+    print(sharedTracker.snapshot());
+
+    // producer/consumer: one thread allocates, another frees, and allocates a little itself
+    TrackingResource handoffTracker{&sharedPool};
+    std::vector<void*> blocks;
+    std::thread producer{[&] {
+        for (int i = 0; i < 1000; ++i) blocks.push_back(handoffTracker.allocate(1000));
+    }};
+    producer.join();
+    std::thread consumer{[&] {
+        for (void* p : blocks) handoffTracker.deallocate(p, 1000);
+        handoffTracker.deallocate(handoffTracker.allocate(16), 16);
+    }};
+    consumer.join();
+    std::cout << "handed over between threads: ";
+    print(handoffTracker.snapshot());
+
+    // cost per call: allocate/deallocate pairs on a pool, directly and through the tracker
+    constexpr int pairs = 1'000'000;
+    std::pmr::unsynchronized_pool_resource pool;
+    TrackingResource poolTracker{&pool};
+    auto churn = [&](std::pmr::memory_resource& r) {
+        Timer t; t.start();
+        for (int i = 0; i < pairs; ++i) {
+            void* p = r.allocate(64, 8);
+            r.deallocate(p, 64, 8);
+        }
+        return t.ms() * 1e6 / (2.0 * pairs);
+    };
+    churn(pool);
+    const double direct = churn(pool), tracked = churn(poolTracker);
+    std::cout << "pool: " << direct << " ns per call, through the tracker: " << tracked << " ns per call (+"
+              << tracked - direct << " ns)" << std::endl;
+}
+
+// Fixed-size slab resource: every block of at most objectSize bytes (and alignment at most
+// objectAlign) is one slot of the same size, so there is no size class to look up; other
+// requests, such as the bucket array of an unordered_map, go to upstream. Slots are carved
+// from pages of pageBytes bytes aligned to their size, with a header at the start:
+// - a page hands out never-used slots from a bump pointer, then freed ones from its own
+//   intrusive free list (the link is stored in the free slot itself),
+// - pages with free slots are on a list the next allocation takes from,
+// - deallocation finds the page of a slot by rounding its address down to the page size.
+// All of it is O(1). With releaseEmptyPages a page that becomes empty goes back to
+// upstream, except the last one, so a container that grows and shrinks returns its memory;
+// otherwise pages are kept until the resource is destroyed. Not thread-safe, like
+// unsynchronized_pool_resource.
+class SlabResource : public std::pmr::memory_resource {
+public:
+    explicit SlabResource(std::size_t objectSize, std::size_t objectAlign = alignof(std::max_align_t),
+                          bool releaseEmptyPages = false, std::size_t pageBytes = 64 * 1024,
+                          std::pmr::memory_resource* up = std::pmr::get_default_resource())
+        : upstream(up), align(std::bit_ceil(std::max(objectAlign, alignof(Slot)))),
+          slotSize((std::max(objectSize, sizeof(Slot)) + align - 1) / align * align), objectSize(objectSize),
+          pageSize(std::bit_ceil(std::max(pageBytes, sizeof(Page) + 2 * (slotSize + align)))),
+          firstSlot((sizeof(Page) + align - 1) / align * align), releaseEmpty(releaseEmptyPages) {}
+
+    SlabResource(const SlabResource&) = delete;
+    SlabResource& operator=(const SlabResource&) = delete;
+    ~SlabResource() override {
+        while (pages) releasePage(pages);
+    }
+
+    std::size_t pageCount() const { return pageTotal; }
+    std::size_t slotsPerPage() const { return (pageSize - firstSlot) / slotSize; }
+
+private:
+    struct Slot { Slot* next; };
+
+    struct Page {
+        Page* prev = nullptr;  // all pages
+        Page* next = nullptr;
+        Page* prevFree = nullptr;  // pages with a free slot
+        Page* nextFree = nullptr;
+        Slot* freeSlots = nullptr;
+        std::byte* bump;  // slots from here to the end of the page were never used
+        std::size_t used = 0;
+        bool onFreeList = false;
+    };
+
+    bool fits(std::size_t bytes, std::size_t alignment) const { return bytes <= objectSize && alignment <= align; }
+    Page* pageOf(void* p) const { return reinterpret_cast<Page*>(reinterpret_cast<std::uintptr_t>(p) & ~(pageSize - 1)); }
+    std::byte* pageEnd(Page* page) const { return reinterpret_cast<std::byte*>(page) + pageSize; }
+
+    void pushFree(Page* page) {
+        page->onFreeList = true;
+        page->prevFree = nullptr;
+        page->nextFree = freePages;
+        if (freePages) freePages->prevFree = page;
+        freePages = page;
+    }
+    void unlinkFree(Page* page) {
+        page->onFreeList = false;
+        (page->prevFree ? page->prevFree->nextFree : freePages) = page->nextFree;
+        if (page->nextFree) page->nextFree->prevFree = page->prevFree;
+    }
+
+    Page* newPage() {
+        auto* page = new (upstream->allocate(pageSize, pageSize)) Page{};
+        page->bump = reinterpret_cast<std::byte*>(page) + firstSlot;
+        page->next = pages;
+        if (pages) pages->prev = page;
+        pages = page;
+        ++pageTotal;
+        pushFree(page);
+        return page;
+    }
+    void releasePage(Page* page) {
+        if (page->onFreeList) unlinkFree(page);
+        (page->prev ? page->prev->next : pages) = page->next;
+        if (page->next) page->next->prev = page->prev;
+        --pageTotal;
+        page->~Page();
+        upstream->deallocate(page, pageSize, pageSize);
+    }
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        if (!fits(bytes, alignment)) return upstream->allocate(bytes, alignment);
+        Page* page = freePages ? freePages : newPage();
+        void* slot;
+        if (page->freeSlots) {
+            slot = std::exchange(page->freeSlots, page->freeSlots->next);
+        } else {
+            slot = page->bump;
+            page->bump += slotSize;
+        }
+        ++page->used;
+        if (!page->freeSlots && page->bump + slotSize > pageEnd(page)) unlinkFree(page);  // now full
+        return slot;
+    }
+
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+        if (!fits(bytes, alignment)) return upstream->deallocate(p, bytes, alignment);
+        Page* page = pageOf(p);
+        auto* slot = static_cast<Slot*>(p);
+        slot->next = page->freeSlots;
+        page->freeSlots = slot;
+        --page->used;
+        if (!page->onFreeList) pushFree(page);
+        if (releaseEmpty && page->used == 0 && pageTotal > 1) releasePage(page);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    std::pmr::memory_resource* upstream;
+    std::size_t align, slotSize, objectSize, pageSize, firstSlot;
+    bool releaseEmpty;
+    Page* pages = nullptr;
+    Page* freePages = nullptr;
+    std::size_t pageTotal = 0;
+};
+
+// 7) Node-based container on a slab: std::pmr::map insert/erase churn
+void example_slab_resource() {
+    std::cout << "\n[example_slab_resource]" << std::endl;
+
+    // the node size and alignment are what one insert into an empty map allocates
+    std::size_t nodeSize = 0, nodeAlign = 1;
+    {
+        TrackingResource probe;
+        std::pmr::map<int, int> m{&probe};
+        m.emplace(0, 0);
+        const auto s = probe.snapshot();
+        nodeSize = s.allocatedBytes;
+        while (!s.alignmentCounts[static_cast<std::size_t>(std::countr_zero(nodeAlign))]) nodeAlign *= 2;
+    }
+
+    constexpr int N = 100000, rounds = 5;
+    std::vector<int> keys(N);
+    for (int i = 0; i < N; ++i) keys[i] = i;
+    std::mt19937 rng{42};
+    std::shuffle(keys.begin(), keys.end(), rng);
+    std::vector<int> eraseOrder = keys;
+    std::shuffle(eraseOrder.begin(), eraseOrder.end(), rng);
+
+    auto churn = [&](std::pmr::memory_resource* resource) {
+        Timer tm; tm.start();
+        for (int r = 0; r < rounds; ++r) {
+            std::pmr::map<int, int> m{resource};
+            for (int k : keys) m.emplace(k, k);
+            for (int k : eraseOrder) m.erase(k);
+        }
+        return tm.ms();
+    };
+
+    std::cout << "map node: " << nodeSize << " bytes, " << rounds << " rounds of " << N << " inserts + erases" << std::endl;
+    std::cout << "new/delete: " << churn(std::pmr::new_delete_resource()) << " ms" << std::endl;
+    std::pmr::unsynchronized_pool_resource unsyncPool;
+    std::cout << "unsynchronized_pool_resource: " << churn(&unsyncPool) << " ms" << std::endl;
+    std::pmr::synchronized_pool_resource syncPool;
+    std::cout << "synchronized_pool_resource: " << churn(&syncPool) << " ms" << std::endl;
+    SlabResource slab{nodeSize, nodeAlign};
+    std::cout << "slab: " << churn(&slab) << " ms (" << slab.slotsPerPage() << " nodes per page, "
+              << slab.pageCount() << " pages kept)" << std::endl;
+    SlabResource releasing{nodeSize, nodeAlign, true};
+    std::cout << "slab, releasing empty pages: " << churn(&releasing) << " ms (" << releasing.pageCount()
+              << " page kept)" << std::endl;
+}
 
-    std::cout << "allocated: " << tracker.allocatedBytes << " bytes, deallocated: "
-              << tracker.deallocatedBytes << " bytes" << std::endl;
+// Stack arena: a linear arena, like monotonic_buffer_resource, that can also give memory
+// back in LIFO order. mark() records the top of the arena and rewind(marker) frees
+// everything allocated since, so the next allocations reuse those bytes; StackArena::Scope
+// does both in its constructor and destructor. Whatever was allocated after a marker must
+// no longer be used when the arena is rewound to it, and markers are rewound in the
+// reverse order they were taken. The first InlineBytes come from a buffer inside the arena
+// object; after that blocks are chained from upstream, each at least twice the size of the
+// previous one. A rewind keeps the blocks for reuse; they go back to upstream when the
+// arena is destroyed. deallocate() gives memory back only for the most recent allocation
+// (a string that grew last, say) and does nothing otherwise. Not thread-safe.
+template <std::size_t InlineBytes = 4096>
+class StackArena : public std::pmr::memory_resource {
+    struct Block {
+        Block* next;
+        std::byte* begin;
+        std::byte* end;
+        std::size_t before;  // bytes of the blocks in front of this one, for highWater()
+    };
+
+public:
+    struct Marker {
+        Block* block;
+        std::byte* top;
+    };
+
+    class Scope {
+    public:
+        explicit Scope(StackArena& arena) : arena(arena), marker(arena.mark()) {}
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+        ~Scope() { arena.rewind(marker); }
+
+    private:
+        StackArena& arena;
+        Marker marker;
+    };
+
+    explicit StackArena(std::pmr::memory_resource* up = std::pmr::get_default_resource()) : upstream(up) {}
+    StackArena(const StackArena&) = delete;
+    StackArena& operator=(const StackArena&) = delete;
+    ~StackArena() override {
+        for (Block* b = first.next; b;) {
+            Block* next = b->next;
+            upstream->deallocate(b, sizeof(Block) + static_cast<std::size_t>(b->end - b->begin), alignof(std::max_align_t));
+            b = next;
+        }
+    }
+
+    Marker mark() const { return {current, top}; }
+    void rewind(Marker m) {
+        current = m.block;
+        top = m.top;
+    }
+
+    // most bytes in use at once, counting alignment padding and the unused ends of blocks
+    std::size_t highWater() const { return highWaterBytes; }
+    std::size_t blockCount() const {
+        std::size_t n = 0;
+        for (const Block* b = first.next; b; b = b->next) ++n;
+        return n;
+    }
+
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        for (;;) {
+            const auto at = (reinterpret_cast<std::uintptr_t>(top) + alignment - 1) & ~(alignment - 1);
+            if (at + bytes <= reinterpret_cast<std::uintptr_t>(current->end)) {
+                auto* p = reinterpret_cast<std::byte*>(at);
+                top = p + bytes;
+                highWaterBytes = std::max(highWaterBytes, current->before + static_cast<std::size_t>(top - current->begin));
+                return p;
+            }
+            nextBlock(bytes + alignment);
+        }
+    }
+
+    // moves on to the next kept block if it has room for 'needed' bytes, otherwise chains a new one in front of it
+    void nextBlock(std::size_t needed) {
+        const auto size = [](const Block* b) { return static_cast<std::size_t>(b->end - b->begin); };
+        Block* next = current->next;
+        if (!next || size(next) < needed) {
+            const std::size_t bytes = std::max(2 * size(current), needed);
+            auto* raw = static_cast<std::byte*>(upstream->allocate(sizeof(Block) + bytes, alignof(std::max_align_t)));
+            next = new (raw) Block{current->next, raw + sizeof(Block), raw + sizeof(Block) + bytes, 0};
+            current->next = next;
+        }
+        next->before = current->before + size(current);
+        current = next;
+        top = current->begin;
+    }
+
+    void do_deallocate(void* p, std::size_t bytes, std::size_t) override {
+        if (static_cast<std::byte*>(p) + bytes == top) top = static_cast<std::byte*>(p);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    std::pmr::memory_resource* upstream;
+    alignas(std::max_align_t) std::byte inlineBuffer[InlineBytes];
+    Block first{nullptr, inlineBuffer, inlineBuffer + InlineBytes, 0};
+    Block* current = &first;
+    std::byte* top = inlineBuffer;
+    std::size_t highWaterBytes = 0;
+};
+
+// 8) Nested scratch memory: a parse/transform pipeline per request, on new/delete, on a
+// monotonic arena per request (as in example_monotonic_arena) and on one StackArena that
+// every stage rewinds when it is done
+void example_stack_arena() {
+    std::cout << "\n[example_stack_arena]" << std::endl;
+
+    // requests are lines of 64 words of 16 to 31 characters, long enough not to fit in SSO
+    constexpr int requests = 20000, wordsPerLine = 64;
+    std::mt19937 rng{7};
+    std::uniform_int_distribution<int> letter('a', 'z'), length(16, 31);
+    std::vector<std::string> lines(requests);
+    for (auto& line : lines)
+        for (int w = 0; w < wordsPerLine; ++w) {
+            if (w) line += ' ';
+            for (int n = length(rng); n > 0; --n) line += static_cast<char>(letter(rng));
+        }
+
+    // parse the line into tokens; then three transforms, each in a scope of its own that
+    // makes a new token list from the previous one and whose result is only a hash
+    auto handle = [](const std::string& line, std::pmr::memory_resource* mr, auto&& scope) {
+        std::pmr::vector<std::pmr::string> tokens{mr};
+        tokens.reserve(wordsPerLine);
+        for (std::size_t pos = 0; pos < line.size();) {
+            const std::size_t end = std::min(line.find(' ', pos), line.size());
+            tokens.emplace_back(line.data() + pos, end - pos);
+            pos = end + 1;
+        }
+        std::uint64_t hash = 1469598103934665603ull;
+        auto mix = [&](const std::pmr::string& s) {
+            for (char c : s) hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+        };
+        scope([&] {  // upper-case copies
+            std::pmr::vector<std::pmr::string> upper{mr};
+            upper.reserve(tokens.size());
+            for (const auto& t : tokens) {
+                auto& u = upper.emplace_back(t);
+                for (char& c : u) c = static_cast<char>(c - 'a' + 'A');
+            }
+            for (const auto& u : upper) mix(u);
+        });
+        scope([&] {  // reversed words, joined into one string
+            std::pmr::string joined{mr};
+            joined.reserve(line.size() + 1);
+            for (const auto& t : tokens) {
+                std::pmr::string r{t.rbegin(), t.rend(), mr};
+                joined += r;
+                joined += ',';
+            }
+            mix(joined);
+        });
+        scope([&] {  // the longer words, each prefixed by its index
+            std::pmr::vector<std::pmr::string> kept{mr};
+            for (std::size_t i = 0; i < tokens.size(); ++i)
+                if (tokens[i].size() > 24) kept.emplace_back().append(std::to_string(i)).append(tokens[i]);
+            for (const auto& k : kept) mix(k);
+        });
+        return hash;
+    };
+    auto inPlace = [](auto&& stage) { stage(); };
+
+    std::vector<std::uint64_t> results(requests);
+    std::uint64_t check = 0;
+    auto report = [&](const char* name, double ms, const TrackingResource& upstream) {
+        std::uint64_t sum = 0;
+        for (auto h : results) sum += h;
+        if (check == 0) check = sum;
+        const auto s = upstream.snapshot();
+        std::cout << name << ": " << ms << " ms, upstream: " << s.allocations << " allocations, peak "
+                  << s.peakBytes << " bytes" << (sum == check ? "" : " (results differ!)") << std::endl;
+    };
+
+    {
+        TrackingResource heap{std::pmr::new_delete_resource()};
+        Timer tm; tm.start();
+        for (int i = 0; i < requests; ++i) results[i] = handle(lines[i], &heap, inPlace);
+        report("new/delete", tm.ms(), heap);
+    }
+    {
+        TrackingResource heap{std::pmr::new_delete_resource()};
+        Timer tm; tm.start();
+        for (int i = 0; i < requests; ++i) {
+            std::byte buf[8 * 1024];
+            std::pmr::monotonic_buffer_resource arena{buf, sizeof(buf), &heap};
+            results[i] = handle(lines[i], &arena, inPlace);
+        }
+        report("monotonic_buffer_resource, 8KB buffer per request", tm.ms(), heap);
+    }
+    {
+        TrackingResource heap{std::pmr::new_delete_resource()};
+        StackArena<8 * 1024> arena{&heap};
+        auto scoped = [&](auto&& stage) {
+            StackArena<8 * 1024>::Scope scope{arena};
+            stage();
+        };
+        Timer tm; tm.start();
+        for (int i = 0; i < requests; ++i) {
+            StackArena<8 * 1024>::Scope request{arena};
+            results[i] = handle(lines[i], &arena, scoped);
+        }
+        report("StackArena<8KB>, a scope per request and stage", tm.ms(), heap);
+        std::cout << "stack arena high water: " << arena.highWater() << " bytes, " << arena.blockCount()
+                  << " upstream blocks" << std::endl;
+    }
 }
 
+// Thread-caching pool resource: a drop-in for synchronized_pool_resource that does not
+// lock on every call. Blocks of up to largest_block bytes (at most 16 KB) are served from
+// power-of-two size classes (8, 16, ..., largest_block; a block is aligned to its class size):
+// - every thread has a cache per class, a free list only that thread touches, so
+//   allocate and deallocate take no lock while the cache has blocks or room;
+// - a cache refills from, and returns to, a central free list per class (one mutex per
+//   class) a batch of blocks at a time, so a thread locks once per batch, not per block;
+// - a cache holds at most 2 batches per class and per_thread_cap bytes in all, beyond
+//   which it hands blocks back to the central lists, so a thread that frees what other
+//   threads allocated does not hoard them; a thread also returns its cache when it exits.
+// The central lists get their blocks from chunks allocated upstream, which go back to
+// upstream when the resource is destroyed (not earlier). Larger or over-aligned requests
+// go straight to upstream, which therefore has to be thread-safe as well. Destroy the
+// resource only after the threads that use it are done with it.
+class ThreadCachingResource : public std::pmr::memory_resource {
+public:
+    explicit ThreadCachingResource(std::size_t per_thread_cap = 256 * 1024, std::size_t largest_block = 4096,
+                                   std::pmr::memory_resource* up = std::pmr::get_default_resource())
+        : central(std::make_shared<Central>(up, std::bit_ceil(std::clamp(largest_block, min_block, chunk_bytes / 4)))),
+          cap(per_thread_cap), id(next_id++) {}
+
+    ThreadCachingResource(const ThreadCachingResource&) = delete;
+    ThreadCachingResource& operator=(const ThreadCachingResource&) = delete;
+
+    std::pmr::memory_resource* upstream_resource() const { return central->upstream; }
+    // batches moved between the thread caches and the central lists so far
+    std::size_t central_transfers() const { return central->transfers.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr std::size_t min_block = 8;
+    static constexpr std::size_t max_classes = 16;
+    static constexpr std::size_t chunk_bytes = 64 * 1024;
+
+    struct Node { Node* next; };
+
+    struct FreeList {
+        Node* head = nullptr;
+        std::size_t count = 0;
+    };
+
+    // the part the thread caches can outlive: they return their blocks here on thread exit
+    struct Central {
+        std::pmr::memory_resource* upstream;
+        std::size_t classes;
+        struct alignas(64) Class {  // own cache line, so classes do not contend on one
+            std::mutex m;
+            FreeList list;
+        };
+        std::array<Class, max_classes> lists;
+        std::mutex chunks_mutex;
+        std::vector<std::pair<void*, std::size_t>> chunks;  // address, class size
+        std::atomic<std::size_t> transfers{0};
+
+        Central(std::pmr::memory_resource* up, std::size_t largest)
+            : upstream(up), classes(static_cast<std::size_t>(std::countr_zero(largest / min_block)) + 1) {}
+        ~Central() {
+            for (auto [p, size] : chunks) upstream->deallocate(p, chunk_bytes, std::min(size, chunk_bytes));
+        }
+    };
+
+    struct Cache {
+        std::array<FreeList, max_classes> lists;
+        std::size_t bytes = 0;  // held in all classes
+    };
+
+    // This thread's caches, one per live resource it used. Resources are told apart by an
+    // id that is never reused, so a cache of a destroyed resource is never picked again.
+    struct ThreadCaches {
+        struct Entry {
+            std::uint64_t id;
+            std::weak_ptr<Central> central;
+            std::unique_ptr<Cache> cache;
+        };
+        std::vector<Entry> entries;
+        std::uint64_t last_id = 0;
+        Cache* last = nullptr;
+
+        ~ThreadCaches() {
+            for (Entry& e : entries)
+                if (auto c = e.central.lock())
+                    for (std::size_t k = 0; k < c->classes; ++k) give_back(*c, k, e.cache->lists[k], e.cache->lists[k].count);
+        }
+    };
+
+    static std::size_t class_size(std::size_t k) { return min_block << k; }
+    // number of blocks moved per refill or return: about 16 KB, between 4 and 64 blocks
+    static std::size_t batch(std::size_t k) { return std::clamp<std::size_t>(16 * 1024 / class_size(k), 4, 64); }
+
+    std::size_t class_of(std::size_t bytes, std::size_t alignment) const {
+        const std::size_t size = std::bit_ceil(std::max({bytes, alignment, min_block}));
+        return static_cast<std::size_t>(std::countr_zero(size / min_block));
+    }
+
+    Cache& local_cache() {
+        thread_local ThreadCaches caches;
+        if (caches.last_id == id) return *caches.last;
+        auto it = std::find_if(caches.entries.begin(), caches.entries.end(), [&](const auto& e) { return e.id == id; });
+        if (it == caches.entries.end()) {
+            std::erase_if(caches.entries, [](const auto& e) { return e.central.expired(); });
+            caches.entries.push_back({id, central, std::make_unique<Cache>()});
+            it = caches.entries.end() - 1;
+        }
+        caches.last_id = id;
+        caches.last = it->cache.get();
+        return *caches.last;
+    }
+
+    // moves n blocks from the front of 'from' to central list k
+    static void give_back(Central& c, std::size_t k, FreeList& from, std::size_t n) {
+        if (n == 0) return;
+        Node* first = from.head;
+        Node* last = first;
+        for (std::size_t i = 1; i < n; ++i) last = last->next;
+        from.head = last->next;
+        from.count -= n;
+        std::lock_guard lock{c.lists[k].m};
+        last->next = c.lists[k].list.head;
+        c.lists[k].list.head = first;
+        c.lists[k].list.count += n;
+        c.transfers.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // moves up to a batch of blocks of class k to 'to', cutting a new chunk when the central list is empty
+    void refill(std::size_t k, FreeList& to) {
+        Central& c = *central;
+        const std::size_t size = class_size(k), n = batch(k);
+        {
+            std::lock_guard lock{c.lists[k].m};
+            FreeList& from = c.lists[k].list;
+            if (from.count > 0) {
+                const std::size_t take = std::min(n, from.count);
+                Node* last = from.head;
+                for (std::size_t i = 1; i < take; ++i) last = last->next;
+                to.head = std::exchange(from.head, last->next);
+                last->next = nullptr;
+                from.count -= take;
+                to.count = take;
+                c.transfers.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+        auto* chunk = static_cast<std::byte*>(c.upstream->allocate(chunk_bytes, std::min(size, chunk_bytes)));
+        const std::size_t blocks = chunk_bytes / size;
+        for (std::size_t i = 0; i < blocks; ++i)
+            reinterpret_cast<Node*>(chunk + i * size)->next = i + 1 < blocks ? reinterpret_cast<Node*>(chunk + (i + 1) * size) : nullptr;
+        // a batch for this thread, the rest of the chunk for the central list
+        to.head = reinterpret_cast<Node*>(chunk);
+        to.count = n;
+        {
+            std::lock_guard lock{c.chunks_mutex};
+            c.chunks.emplace_back(chunk, size);
+        }
+        if (blocks > n) {
+            reinterpret_cast<Node*>(chunk + (n - 1) * size)->next = nullptr;
+            std::lock_guard lock{c.lists[k].m};
+            reinterpret_cast<Node*>(chunk + (blocks - 1) * size)->next = c.lists[k].list.head;
+            c.lists[k].list.head = reinterpret_cast<Node*>(chunk + n * size);
+            c.lists[k].list.count += blocks - n;
+        }
+    }
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        const std::size_t k = class_of(bytes, alignment);
+        if (k >= central->classes) return central->upstream->allocate(bytes, alignment);
+        Cache& cache = local_cache();
+        FreeList& list = cache.lists[k];
+        if (list.count == 0) {
+            refill(k, list);
+            cache.bytes += list.count * class_size(k);
+        }
+        Node* node = list.head;
+        list.head = node->next;
+        --list.count;
+        cache.bytes -= class_size(k);
+        return node;
+    }
+
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+        const std::size_t k = class_of(bytes, alignment);
+        if (k >= central->classes) return central->upstream->deallocate(p, bytes, alignment);
+        Cache& cache = local_cache();
+        FreeList& list = cache.lists[k];
+        auto* node = static_cast<Node*>(p);
+        node->next = list.head;
+        list.head = node;
+        ++list.count;
+        cache.bytes += class_size(k);
+        if (list.count > 2 * batch(k)) {
+            give_back(*central, k, list, batch(k));
+            cache.bytes -= batch(k) * class_size(k);
+        }
+        if (cache.bytes > cap) trim(cache);
+    }
+
+    // over the cap: every class keeps at most half a batch
+    void trim(Cache& cache) {
+        for (std::size_t k = 0; k < central->classes; ++k) {
+            const std::size_t keep = batch(k) / 2;
+            if (cache.lists[k].count <= keep) continue;
+            const std::size_t n = cache.lists[k].count - keep;
+            give_back(*central, k, cache.lists[k], n);
+            cache.bytes -= n * class_size(k);
+        }
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    std::shared_ptr<Central> central;
+    std::size_t cap;
+    std::uint64_t id;
+    static inline std::atomic<std::uint64_t> next_id{1};
+};
+
 // 6) Small-object churn benchmark: unordered_map insert/erase
 void example_small_object_churn() {
     std::cout << "\n[example_small_object_churn]" << std::endl;
@@ -149,6 +926,46 @@ void example_small_object_churn() {
         for (int i = 0; i < N; ++i) m.erase(std::pmr::string{make_key(i), &pool});
     }
     std::cout << "pmr::unordered_map<pmr::string> (unsync pool) insert+erase: " << tm.ms() << " ms" << std::endl;
+
+    // The same churn on several threads at once, each with its own map, all maps on one
+    // resource: malloc, a synchronized_pool_resource (a lock per call) and a
+    // ThreadCachingResource (a lock per batch). The keys are made up front so that the
+    // threads only allocate through the resource under test.
+    const unsigned threads = std::max(2u, std::thread::hardware_concurrency());
+    std::vector<std::string> keys;
+    for (int i = 0; i < static_cast<int>(threads) * N; ++i) keys.push_back(make_key(i));
+    auto run_threads = [&](auto body) {
+        Timer t; t.start();
+        std::vector<std::thread> workers;
+        for (unsigned id = 0; id < threads; ++id) workers.emplace_back(body, std::size_t{id} * N);
+        for (auto& w : workers) w.join();
+        return t.ms();
+    };
+    auto pmr_churn = [&](std::pmr::memory_resource* resource) {
+        return [&, resource](std::size_t first) {
+            std::pmr::unordered_map<std::pmr::string, int> m{resource};
+            m.reserve(N);
+            for (int i = 0; i < N; ++i) m.emplace(std::pmr::string{keys[first + i], resource}, i);
+            for (int i = 0; i < N; ++i) m.erase(std::pmr::string{keys[first + i], resource});
+        };
+    };
+
+    double ms = run_threads([&](std::size_t first) {
+        std::unordered_map<std::string, int> m;
+        m.reserve(N);
+        for (int i = 0; i < N; ++i) m.emplace(keys[first + i], i);
+        for (int i = 0; i < N; ++i) m.erase(keys[first + i]);
+    });
+    std::cout << threads << " threads, unordered_map<std::string> (malloc) insert+erase: " << ms << " ms" << std::endl;
+
+    std::pmr::synchronized_pool_resource sync_pool;
+    ms = run_threads(pmr_churn(&sync_pool));
+    std::cout << threads << " threads, pmr::unordered_map<pmr::string> (sync pool) insert+erase: " << ms << " ms" << std::endl;
+
+    ThreadCachingResource caching;
+    ms = run_threads(pmr_churn(&caching));
+    std::cout << threads << " threads, pmr::unordered_map<pmr::string> (thread-caching pool) insert+erase: " << ms << " ms ("
+              << caching.central_transfers() << " batch transfers)" << std::endl;
 }
 
 // 5) Quick comparison: default new/delete vs monotonic arena
@@ -195,9 +1012,595 @@ void example_perf_compare() {
     std::cout << "std::pmr::vector<std::pmr::string> (unsync pool) time: " << tm.ms() << " ms" << std::endl;
 }
 
+// Upstream resource that gets every block straight from the OS as a mapping of its own
+// (mmap, or VirtualAlloc on Windows), meant for the buffer of a large arena:
+// - Pages::normal maps base pages (4 KB);
+// - Pages::transparentHuge aligns the mapping to 2 MB and asks for transparent huge pages
+//   with madvise(MADV_HUGEPAGE), which the kernel grants when it can (Linux only; the
+//   setting in /sys/kernel/mm/transparent_hugepage decides);
+// - Pages::explicitHuge maps pages from the hugetlbfs pool (MAP_HUGETLB; on Windows
+//   MEM_LARGE_PAGES, which needs the "Lock pages in memory" right; the resource enables
+//   it in the process token). When the pool is empty or the right missing it falls back
+//   to transparentHuge (or normal pages on Windows) and counts a fallback.
+// With prefault the pages are faulted in by allocate() (MAP_POPULATE, or a write to every
+// page) instead of on first touch. Sizes are rounded up to whole pages, 2 MB for the huge
+// modes. deallocate() unmaps the block; purge() keeps it mapped but hands the pages in a
+// range back to the OS (MADV_DONTNEED: they read as zeros next time; MEM_RESET on Windows:
+// their contents are undefined). Thread-safe, as it keeps no state but counters.
+class MappedResource : public std::pmr::memory_resource {
+public:
+    enum class Pages { normal, transparentHuge, explicitHuge };
+    static constexpr std::size_t hugePageBytes = 2 * 1024 * 1024;
+
+    explicit MappedResource(Pages pages = Pages::normal, bool prefault = false) : pages(pages), prefault(prefault) {}
+
+    MappedResource(const MappedResource&) = delete;
+    MappedResource& operator=(const MappedResource&) = delete;
+
+    static std::size_t pageBytes() {
+#ifdef _WIN32
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        return info.dwPageSize;
+#else
+        return static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+#endif
+    }
+
+    // gives the whole pages inside [p, p + bytes) back to the OS, keeping the range mapped
+    void purge(void* p, std::size_t bytes) {
+        const std::size_t page = pageBytes();
+        const auto first = (reinterpret_cast<std::uintptr_t>(p) + page - 1) & ~(page - 1);
+        const auto last = (reinterpret_cast<std::uintptr_t>(p) + bytes) & ~(page - 1);
+        if (last <= first) return;
+#ifdef _WIN32
+        VirtualAlloc(reinterpret_cast<void*>(first), last - first, MEM_RESET, PAGE_READWRITE);
+#else
+        madvise(reinterpret_cast<void*>(first), last - first, MADV_DONTNEED);
+#endif
+    }
+
+    std::size_t mappings() const { return mapCount.load(std::memory_order_relaxed); }
+    std::size_t hugeFallbacks() const { return fallbackCount.load(std::memory_order_relaxed); }
+
+private:
+    std::size_t granule() const { return pages == Pages::normal ? pageBytes() : hugePageBytes; }
+    std::size_t roundUp(std::size_t bytes) const { return (std::max<std::size_t>(bytes, 1) + granule() - 1) & ~(granule() - 1); }
+
+    void touch(void* p, std::size_t bytes) const {
+        const std::size_t step = pageBytes();
+        auto* bytesPtr = static_cast<volatile char*>(p);
+        for (std::size_t i = 0; i < bytes; i += step) bytesPtr[i] = 0;
+    }
+
+#ifdef _WIN32
+    // MEM_LARGE_PAGES needs SeLockMemoryPrivilege ("Lock pages in memory") enabled in the
+    // process token; a process that has the right gets it disabled, so enable it once
+    static bool lockMemoryPrivilege() {
+        static const bool enabled = [] {
+            HANDLE token;
+            if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token)) return false;
+            TOKEN_PRIVILEGES privileges{};
+            privileges.PrivilegeCount = 1;
+            privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+            // AdjustTokenPrivileges succeeds without the right too, and says so in GetLastError
+            const bool ok = LookupPrivilegeValue(nullptr, SE_LOCK_MEMORY_NAME, &privileges.Privileges[0].Luid) &&
+                            AdjustTokenPrivileges(token, FALSE, &privileges, 0, nullptr, nullptr) &&
+                            GetLastError() == ERROR_SUCCESS;
+            CloseHandle(token);
+            return ok;
+        }();
+        return enabled;
+    }
+
+    // VirtualAlloc places blocks at multiples of the allocation granularity (64 KB). For more,
+    // reserves a larger range to find an aligned address in, releases it and allocates there,
+    // again if another thread took the address in between.
+    static void* allocAligned(std::size_t size, std::size_t alignment) {
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        if (alignment <= info.dwAllocationGranularity) return VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+        for (int attempt = 0; attempt < 16; ++attempt) {
+            void* raw = VirtualAlloc(nullptr, size + alignment, MEM_RESERVE, PAGE_NOACCESS);
+            if (!raw) return nullptr;
+            const auto aligned = (reinterpret_cast<std::uintptr_t>(raw) + alignment - 1) & ~(alignment - 1);
+            VirtualFree(raw, 0, MEM_RELEASE);
+            if (void* p = VirtualAlloc(reinterpret_cast<void*>(aligned), size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE)) return p;
+        }
+        return nullptr;
+    }
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        const std::size_t size = roundUp(bytes);
+        void* p = nullptr;
+        // large pages come aligned to the large page size
+        const std::size_t largePage = GetLargePageMinimum();
+        if (pages == Pages::explicitHuge && largePage != 0 && size % largePage == 0 && alignment <= largePage && lockMemoryPrivilege())
+            p = VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+        if (!p) {
+            if (pages == Pages::explicitHuge) fallbackCount.fetch_add(1, std::memory_order_relaxed);
+            p = allocAligned(size, alignment);
+            if (!p) throw std::bad_alloc{};
+            if (prefault) touch(p, size);
+        }
+        mapCount.fetch_add(1, std::memory_order_relaxed);
+        return p;
+    }
+
+    void do_deallocate(void* p, std::size_t, std::size_t) override {
+        VirtualFree(p, 0, MEM_RELEASE);
+        mapCount.fetch_sub(1, std::memory_order_relaxed);
+    }
+#else
+    // maps 'size' bytes aligned to 'alignment' (a power of two); when that is more than the
+    // mappings come aligned to ('natural'), maps more and unmaps the excess
+    static void* mapAligned(std::size_t size, std::size_t alignment, std::size_t natural, int flags) {
+        if (alignment <= natural) {
+            void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+            return p == MAP_FAILED ? nullptr : p;
+        }
+        void* raw = mmap(nullptr, size + alignment, PROT_READ | PROT_WRITE, flags, -1, 0);
+        if (raw == MAP_FAILED) return nullptr;
+        const auto begin = reinterpret_cast<std::uintptr_t>(raw);
+        const auto aligned = (begin + alignment - 1) & ~(alignment - 1);
+        if (aligned > begin) munmap(raw, aligned - begin);
+        if (const std::size_t tail = begin + size + alignment - (aligned + size)) munmap(reinterpret_cast<void*>(aligned + size), tail);
+        return reinterpret_cast<void*>(aligned);
+    }
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        const std::size_t size = roundUp(bytes);
+        const std::size_t align = std::max(alignment, granule());
+        const int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+        void* p = nullptr;
+#ifdef MAP_HUGETLB
+        if (pages == Pages::explicitHuge) {
+            p = mapAligned(size, align, hugePageBytes, flags | MAP_HUGETLB | (prefault ? MAP_POPULATE : 0));
+            if (!p) fallbackCount.fetch_add(1, std::memory_order_relaxed);
+        }
+#endif
+        if (!p && pages != Pages::normal) {
+            p = mapAligned(size, align, pageBytes(), flags);
+            if (!p) throw std::bad_alloc{};
+#ifdef MADV_HUGEPAGE
+            madvise(p, size, MADV_HUGEPAGE);
+#endif
+            // after the madvise, so that the pages are faulted in as huge pages
+            if (prefault) touch(p, size);
+        }
+        if (!p) {
+            p = mapAligned(size, align, pageBytes(), flags | (prefault ? MAP_POPULATE : 0));
+            if (!p) throw std::bad_alloc{};
+        }
+        mapCount.fetch_add(1, std::memory_order_relaxed);
+        return p;
+    }
+
+    void do_deallocate(void* p, std::size_t bytes, std::size_t) override {
+        munmap(p, roundUp(bytes));
+        mapCount.fetch_sub(1, std::memory_order_relaxed);
+    }
+#endif
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    Pages pages;
+    bool prefault;
+    std::atomic<std::size_t> mapCount{0}, fallbackCount{0};
+};
+
+// Resident memory of the process, in bytes
+std::size_t resident_bytes() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters{};
+    GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+    return counters.WorkingSetSize;
+#elif defined(__linux__)
+    std::size_t pagesTotal = 0, pagesResident = 0;
+    if (FILE* f = std::fopen("/proc/self/statm", "r")) {
+        if (std::fscanf(f, "%zu %zu", &pagesTotal, &pagesResident) != 2) pagesResident = 0;
+        std::fclose(f);
+    }
+    return pagesResident * static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+#else
+    return 0;
+#endif
+}
+
+// Page faults and data TLB misses of the calling thread between start() and stop(), as far
+// as the OS lets a process count them (-1 when it does not): page faults everywhere, TLB
+// misses only on Linux with hardware counters (perf_event_open; not in most VMs).
+struct MemoryCounters {
+    struct Reading { long long pageFaults = -1, tlbMisses = -1; };
+
+    MemoryCounters() {
+#ifdef __linux__
+        perf_event_attr attr{};
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        tlbFd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+    }
+    MemoryCounters(const MemoryCounters&) = delete;
+    MemoryCounters& operator=(const MemoryCounters&) = delete;
+    ~MemoryCounters() {
+#ifdef __linux__
+        if (tlbFd >= 0) close(tlbFd);
+#endif
+    }
+
+    void start() {
+        faultsAtStart = faults();
+#ifdef __linux__
+        if (tlbFd >= 0) {
+            ioctl(tlbFd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(tlbFd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+    Reading stop() {
+        Reading r;
+#ifdef __linux__
+        long long misses = 0;
+        if (tlbFd >= 0) {
+            ioctl(tlbFd, PERF_EVENT_IOC_DISABLE, 0);
+            if (read(tlbFd, &misses, sizeof(misses)) == static_cast<ssize_t>(sizeof(misses))) r.tlbMisses = misses;
+        }
+#endif
+        const long long now = faults();
+        if (now >= 0 && faultsAtStart >= 0) r.pageFaults = now - faultsAtStart;
+        return r;
+    }
+
+private:
+    static long long faults() {
+#ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS counters{};
+        if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return -1;
+        return counters.PageFaultCount;
+#else
+        rusage usage{};
+#ifdef RUSAGE_THREAD
+        if (getrusage(RUSAGE_THREAD, &usage) != 0) return -1;
+#else
+        if (getrusage(RUSAGE_SELF, &usage) != 0) return -1;
+#endif
+        return usage.ru_minflt + usage.ru_majflt;
+#endif
+    }
+
+    long long faultsAtStart = -1;
+    int tlbFd = -1;
+};
+
+// 9) Large arena on mapped memory: the arena of example_perf_compare, scaled up to 256 MB,
+// in a std::vector<std::byte> and in MappedResource blocks with and without huge pages and
+// prefaulting. The workload fills the arena with strings, then reads them in random order,
+// which misses the TLB on nearly every string with 4 KB pages.
+void example_mapped_arena() {
+    std::cout << "\n[example_mapped_arena]" << std::endl;
+
+    constexpr std::size_t arenaBytes = 256 * 1024 * 1024;
+    constexpr int N = 1000000, reads = 4000000;
+    auto make_payload = [](int i) {
+        std::string base = "data_" + std::to_string(i) + "_";
+        while (base.size() < 128) base += 'x';
+        return base;
+    };
+    std::vector<int> order(reads);
+    std::mt19937 rng{3};
+    for (auto& i : order) i = static_cast<int>(rng() % N);
+
+    auto print = [](const char* what, double ms, MemoryCounters::Reading r) {
+        auto count = [](long long c) { return c < 0 ? std::string{"n/a"} : std::to_string(c); };
+        std::cout << "  " << what << ": " << ms << " ms, " << count(r.pageFaults) << " page faults, " << count(r.tlbMisses)
+                  << " dTLB misses" << std::endl;
+    };
+    MemoryCounters counters;
+    // runs the workload on an arena over the buffer that setup() returns
+    auto run = [&](const char* name, auto setup) {
+        std::cout << name << std::endl;
+        Timer tm;
+        counters.start(); tm.start();
+        std::byte* buf = setup();
+        print("setup", tm.ms(), counters.stop());
+
+        std::pmr::monotonic_buffer_resource arena{buf, arenaBytes, std::pmr::null_memory_resource()};
+        std::pmr::vector<std::pmr::string> v{&arena};
+        v.reserve(N);
+        counters.start(); tm.start();
+        for (int i = 0; i < N; ++i) v.emplace_back(make_payload(i));
+        print("fill", tm.ms(), counters.stop());
+
+        std::size_t sum = 0;
+        counters.start(); tm.start();
+        for (int i : order) sum += v[i][5] + v[i].size();
+        print("random reads", tm.ms(), counters.stop());
+        std::cout << "  resident: " << resident_bytes() / (1024 * 1024) << " MB (checksum " << sum << ")" << std::endl;
+    };
+
+    {
+        std::vector<std::byte> buf;
+        run("std::vector<std::byte>", [&] {
+            buf.resize(arenaBytes);  // zero-fills, so this faults every page in
+            return buf.data();
+        });
+    }
+    struct Case { const char* name; MappedResource::Pages pages; bool prefault; };
+    for (const Case c : {Case{"mmap, 4KB pages", MappedResource::Pages::normal, false},
+                         Case{"mmap, 4KB pages, prefaulted", MappedResource::Pages::normal, true},
+                         Case{"mmap, transparent huge pages", MappedResource::Pages::transparentHuge, false},
+                         Case{"mmap, transparent huge pages, prefaulted", MappedResource::Pages::transparentHuge, true},
+                         Case{"mmap, explicit huge pages, prefaulted", MappedResource::Pages::explicitHuge, true}}) {
+        MappedResource mapped{c.pages, c.prefault};
+        std::byte* buf = nullptr;
+        run(c.name, [&] { return buf = static_cast<std::byte*>(mapped.allocate(arenaBytes)); });
+        if (mapped.hugeFallbacks()) std::cout << "  (no explicit huge pages available: fell back)" << std::endl;
+        const std::size_t before = resident_bytes();
+        mapped.purge(buf, arenaBytes);
+        std::cout << "  purge: resident " << before / (1024 * 1024) << " -> " << resident_bytes() / (1024 * 1024) << " MB"
+                  << std::endl;
+        mapped.deallocate(buf, arenaBytes);
+    }
+}
+
+// Allocator benchmark suite: one run allocates and frees blocks of one size through one
+// resource, on a number of threads, in one lifetime pattern:
+// - lifo, fifo: every thread allocates 'objects' blocks, then frees them newest first or
+//   oldest first, for as many rounds as opsPerThread allows;
+// - random: every thread keeps 'objects' blocks and replaces one at a random index per
+//   step, then frees them all;
+// - producerConsumer: 'threads' pairs of threads; the producer allocates batches of
+//   'objects' blocks and hands them over, the consumer frees them (the resource must be
+//   thread-safe).
+// Resources that are not thread-safe get an instance per thread.
+enum class Lifetime { lifo, fifo, random, producerConsumer };
+
+struct AllocatorRun {
+    std::size_t size = 64, objects = 1024, threads = 1;
+    Lifetime lifetime = Lifetime::lifo;
+    std::size_t opsPerThread = 128 * 1024;  // allocations per thread (per pair for producerConsumer)
+};
+
+struct AllocatorStats {
+    double mops = 0;               // allocations plus deallocations per second, in millions
+    double p50 = 0, p99 = 0, p999 = 0;  // latency of a call in ns, from every 8th call
+    std::size_t liveBytes = 0;     // requested bytes live when all threads hold their blocks
+    std::size_t peakRss = 0;       // RSS growth at that point
+    std::size_t retainedRss = 0;   // RSS growth once everything is freed, before the resources are destroyed
+};
+
+// 'make' creates a resource for blocks of the given size
+AllocatorStats run_allocator_benchmark(const AllocatorRun& run, bool threadSafe,
+                                       const std::function<std::shared_ptr<std::pmr::memory_resource>(std::size_t)>& make) {
+    constexpr unsigned sampleEvery = 8;
+    constexpr std::size_t align = alignof(std::max_align_t);
+    const bool pairs = run.lifetime == Lifetime::producerConsumer;
+    const std::size_t workers = pairs ? 2 * run.threads : run.threads;
+
+    // allocate() and deallocate() on one resource, timing every sampleEvery-th call
+    struct Calls {
+        std::pmr::memory_resource* mr;
+        std::size_t size;
+        std::vector<std::uint32_t> ns;
+        unsigned tick = 0;
+
+        void* allocate() {
+            void* p;
+            if (++tick % sampleEvery) {
+                p = mr->allocate(size, align);
+            } else {
+                const auto t0 = std::chrono::steady_clock::now();
+                p = mr->allocate(size, align);
+                record(t0);
+            }
+            // write to every page of the block, as its user would, so that RSS counts it
+            for (std::size_t i = 0; i < size; i += 4096) static_cast<volatile char*>(p)[i] = 1;
+            return p;
+        }
+        void deallocate(void* p) {
+            if (++tick % sampleEvery) return mr->deallocate(p, size, align);
+            const auto t0 = std::chrono::steady_clock::now();
+            mr->deallocate(p, size, align);
+            record(t0);
+        }
+        void record(std::chrono::steady_clock::time_point t0) {
+            const auto d = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0);
+            ns.push_back(static_cast<std::uint32_t>(d.count()));
+        }
+    };
+
+#ifdef __GLIBC__
+    malloc_trim(0);  // so that memory freed by earlier runs does not hide the growth of this one
+#endif
+    AllocatorStats stats;
+    const std::size_t baseline = resident_bytes();
+    auto growth = [&] { return resident_bytes() - std::min(baseline, resident_bytes()); };
+    {
+        std::vector<std::shared_ptr<std::pmr::memory_resource>> resources;
+        for (std::size_t t = 0; t < (threadSafe ? 1 : workers); ++t) resources.push_back(make(run.size));
+        std::vector<Calls> calls;
+        for (std::size_t t = 0; t < workers; ++t) calls.push_back({resources[threadSafe ? 0 : t].get(), run.size, {}});
+        for (auto& c : calls) c.ns.reserve(2 * run.opsPerThread / sampleEvery + 1);
+
+        auto atPeak = [&]() noexcept { stats.peakRss = growth(); };
+        std::barrier peak{static_cast<std::ptrdiff_t>(workers), atPeak};
+        const std::size_t rounds = std::max<std::size_t>(1, run.opsPerThread / run.objects);
+
+        auto single = [&](std::size_t t) {
+            Calls& c = calls[t];
+            std::vector<void*> live(run.objects);
+            if (run.lifetime == Lifetime::random) {
+                for (auto& p : live) p = c.allocate();
+                std::uint64_t x = 0x9e3779b97f4a7c15ull * (t + 1);
+                for (std::size_t i = run.objects; i < run.opsPerThread; ++i) {
+                    x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+                    void*& p = live[x % run.objects];
+                    c.deallocate(p);
+                    p = c.allocate();
+                }
+                peak.arrive_and_wait();
+                for (void* p : live) c.deallocate(p);
+                return;
+            }
+            for (std::size_t r = 0; r < rounds; ++r) {
+                for (auto& p : live) p = c.allocate();
+                if (r + 1 == rounds) peak.arrive_and_wait();
+                if (run.lifetime == Lifetime::lifo)
+                    for (auto it = live.rbegin(); it != live.rend(); ++it) c.deallocate(*it);
+                else
+                    for (void* p : live) c.deallocate(p);
+            }
+        };
+
+        // two batches a pair passes back and forth; full[b] is set by the producer, cleared by the consumer
+        struct Pair {
+            std::array<std::vector<void*>, 2> batch;
+            std::array<std::atomic<bool>, 2> full{};
+        };
+        std::vector<Pair> handoff(workers / 2);
+        auto waitFor = [](const std::atomic<bool>& flag, bool value) {
+            while (flag.load(std::memory_order_acquire) != value) std::this_thread::yield();
+        };
+        auto producer = [&](std::size_t t) {
+            Pair& pair = handoff[t / 2];
+            for (std::size_t r = 0; r < rounds; ++r) {
+                auto& batch = pair.batch[r % 2];
+                waitFor(pair.full[r % 2], false);
+                batch.resize(run.objects);
+                for (auto& p : batch) p = calls[t].allocate();
+                if (r + 1 == rounds) peak.arrive_and_wait();
+                pair.full[r % 2].store(true, std::memory_order_release);
+            }
+        };
+        auto consumer = [&](std::size_t t) {
+            Pair& pair = handoff[t / 2];
+            for (std::size_t r = 0; r < rounds; ++r) {
+                if (r + 1 == rounds) peak.arrive_and_wait();
+                waitFor(pair.full[r % 2], true);
+                for (void* p : pair.batch[r % 2]) calls[t].deallocate(p);
+                pair.full[r % 2].store(false, std::memory_order_release);
+            }
+        };
+
+        Timer tm; tm.start();
+        std::vector<std::thread> threads;
+        for (std::size_t t = 0; t < workers; ++t) {
+            if (!pairs) threads.emplace_back(single, t);
+            else if (t % 2 == 0) threads.emplace_back(producer, t);
+            else threads.emplace_back(consumer, t);
+        }
+        for (auto& th : threads) th.join();
+        const double ms = tm.ms();
+        stats.retainedRss = growth();
+
+        const std::size_t holders = pairs ? workers / 2 : workers;
+        const std::size_t allocations = holders * (run.lifetime == Lifetime::random ? run.opsPerThread : rounds * run.objects);
+        stats.mops = 2.0 * static_cast<double>(allocations) / (ms * 1000.0);
+        stats.liveBytes = holders * run.objects * run.size;
+
+        std::vector<std::uint32_t> ns;
+        for (auto& c : calls) ns.insert(ns.end(), c.ns.begin(), c.ns.end());
+        auto percentile = [&](double q) {
+            if (ns.empty()) return 0.0;
+            auto it = ns.begin() + static_cast<std::ptrdiff_t>(q * static_cast<double>(ns.size() - 1));
+            std::nth_element(ns.begin(), it, ns.end());
+            return static_cast<double>(*it);
+        };
+        // less the cost of reading the clock, the median of back-to-back reads
+        static const double clockNs = [] {
+            std::vector<std::uint32_t> d(1001);
+            for (auto& x : d) {
+                const auto t0 = std::chrono::steady_clock::now();
+                x = static_cast<std::uint32_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count());
+            }
+            std::nth_element(d.begin(), d.begin() + 500, d.end());
+            return static_cast<double>(d[500]);
+        }();
+        stats.p50 = std::max(0.0, percentile(0.5) - clockNs);
+        stats.p99 = std::max(0.0, percentile(0.99) - clockNs);
+        stats.p999 = std::max(0.0, percentile(0.999) - clockNs);
+    }
+    return stats;
+}
+
+// 10) Allocator benchmark suite: every resource in this file and the standard ones over a
+// sweep of block size, lifetime pattern, thread count and number of live blocks, reporting
+// throughput, call latency percentiles and RSS against live bytes. RSS is for the whole
+// process and moves in pages, and memory freed by earlier runs may be reused without
+// growing it, so it means little for runs with less than a few MB live.
+// monotonic_buffer_resource never reclaims memory before it is destroyed, and StackArena only
+// reclaims blocks freed in LIFO order, so every allocation they cannot free stays allocated
+// until the run ends. They skip the random pattern, where that growth is opsPerThread blocks
+// per thread, and in the other patterns their opsPerThread is cut to what fits in
+// growthBudget bytes per thread (at least one round).
+void example_allocator_suite() {
+    std::cout << "\n[example_allocator_suite]" << std::endl;
+
+    using Make = std::function<std::shared_ptr<std::pmr::memory_resource>(std::size_t)>;
+    enum class Frees { always, lifoOnly, never };
+    struct Candidate {
+        const char* name;
+        bool threadSafe;
+        Make make;
+        Frees frees = Frees::always;
+    };
+    const std::vector<Candidate> candidates = {
+        {"new/delete", true, [](std::size_t) {
+             return std::shared_ptr<std::pmr::memory_resource>(std::pmr::new_delete_resource(), [](auto*) {});
+         }},
+        {"monotonic", false, [](std::size_t) { return std::make_shared<std::pmr::monotonic_buffer_resource>(); }, Frees::never},
+        {"unsync pool", false, [](std::size_t) { return std::make_shared<std::pmr::unsynchronized_pool_resource>(); }},
+        {"sync pool", true, [](std::size_t) { return std::make_shared<std::pmr::synchronized_pool_resource>(); }},
+        {"thread-caching", true, [](std::size_t) { return std::make_shared<ThreadCachingResource>(); }},
+        {"slab", false, [](std::size_t size) { return std::make_shared<SlabResource>(size); }},
+        {"stack arena", false, [](std::size_t) { return std::make_shared<StackArena<>>(); }, Frees::lifoOnly},
+    };
+    const char* lifetimeNames[] = {"LIFO", "FIFO", "random", "producer-consumer"};
+
+    const auto flags = std::cout.flags();
+    const auto precision = std::cout.precision();
+    const std::size_t growthBudget = 16 * 1024 * 1024;
+    const std::size_t manyThreads = std::max(2u, std::thread::hardware_concurrency());
+    for (std::size_t size : {16, 128, 1024})
+        for (Lifetime lifetime : {Lifetime::lifo, Lifetime::fifo, Lifetime::random, Lifetime::producerConsumer})
+            for (std::size_t threads : {std::size_t{1}, manyThreads})
+                for (std::size_t objects : {1024, 64 * 1024}) {
+                    AllocatorRun run{size, objects, threads, lifetime};
+                    const bool pairs = lifetime == Lifetime::producerConsumer;
+                    std::cout << size << " B, " << lifetimeNames[static_cast<int>(lifetime)] << ", "
+                              << threads << (pairs ? " pair(s)" : " thread(s)")
+                              << ", " << objects << " live" << std::endl;
+                    for (const auto& c : candidates) {
+                        if (pairs && !c.threadSafe) continue;
+                        const bool grows = c.frees == Frees::never || (c.frees == Frees::lifoOnly && lifetime != Lifetime::lifo);
+                        if (grows && lifetime == Lifetime::random) continue;
+                        AllocatorRun capped = run;
+                        if (grows) capped.opsPerThread = std::clamp(growthBudget / size, objects, run.opsPerThread);
+                        const AllocatorStats s = run_allocator_benchmark(capped, c.threadSafe, c.make);
+                        std::cout << "  " << std::left << std::setw(15) << c.name << std::right << std::fixed << std::setprecision(1)
+                                  << std::setw(8) << s.mops << " Mops/s   p50/p99/p99.9 " << std::setprecision(0) << s.p50 << "/"
+                                  << s.p99 << "/" << s.p999 << " ns   RSS " << s.peakRss / 1024 << " KB for " << s.liveBytes / 1024
+                                  << " KB live, " << s.retainedRss / 1024 << " KB retained" << std::endl;
+                        std::cout.flags(flags);
+                        std::cout.precision(precision);
+                    }
+                }
+}
+
 int main() {
     // Disable auto line flush to reduce I/O noise in timing
     // std::cout.setf(std::ios::unitbuf);
+#ifdef __GLIBC__
+    // glibc raises its mmap threshold whenever a large block is freed, after which large
+    // blocks come from the heap and stay resident when freed; later examples would reuse
+    // them and example_allocator_suite would see less RSS than it uses. Keep the default.
+    mallopt(M_MMAP_THRESHOLD, 128 * 1024);
+#endif
 
     try { example_monotonic_arena(); }
     catch (const std::exception& e) { std::cerr << "example_monotonic_arena error: " << e.what() << std::endl; }
@@ -211,12 +1614,24 @@ int main() {
     try { example_tracking_resource(); }
     catch (const std::exception& e) { std::cerr << "example_tracking_resource error: " << e.what() << std::endl; }
 
+    try { example_slab_resource(); }
+    catch (const std::exception& e) { std::cerr << "example_slab_resource error: " << e.what() << std::endl; }
+
+    try { example_stack_arena(); }
+    catch (const std::exception& e) { std::cerr << "example_stack_arena error: " << e.what() << std::endl; }
+
     try { example_perf_compare(); }
     catch (const std::exception& e) { std::cerr << "example_perf_compare error: " << e.what() << std::endl; }
 
     try { example_small_object_churn(); }
     catch (const std::exception& e) { std::cerr << "example_small_object_churn error: " << e.what() << std::endl; }
 
+    try { example_mapped_arena(); }
+    catch (const std::exception& e) { std::cerr << "example_mapped_arena error: " << e.what() << std::endl; }
+
+    try { example_allocator_suite(); }
+    catch (const std::exception& e) { std::cerr << "example_allocator_suite error: " << e.what() << std::endl; }
+
     std::cout << "\nAll PMR examples done." << std::endl;
     
     return 0;
@@ -10,6 +10,8 @@ int main() {
     // Using ranges
     std::cout << "Using Ranges views:\n";
     std::cout << "filter views:\n";
+    // views are lazy and evaluated on one thread; compact::copy_if in
+    // ParallelAlgorithms_cpp20.cpp is a parallel, order-preserving filter into a vector
     for (const auto& element : vec | std::views::filter([](int n) { return n % 2 == 0; })) {
         std::cout << element << " ";
     }
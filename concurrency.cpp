@@ -105,6 +105,9 @@ int main() {
     std::promise<int> prom;
     std::future<int> fut = prom.get_future();
 
+    // views::filter is lazy and sequential: the thread walks all of largeData itself. To
+    // materialize the matches of a large input in parallel, see compact::copy_if in
+    // ParallelAlgorithms_cpp20.cpp
     std::thread t1([&largeData, &prom]() {
         auto even_members = largeData | std::views::filter([](int n) { return n % 2 == 0; });
         int sum = std::accumulate(even_members.begin(), even_members.end(), 0);
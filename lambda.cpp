@@ -124,6 +124,8 @@ int main() {
     std::cout << std::endl;
 
     // lambda example for filtering
+    // (sequential; for large inputs see compact::copy_if in ParallelAlgorithms_cpp20.cpp,
+    // which filters on all cores and keeps the order)
     std::vector<int> vec3 = {1, 2, 3, 4, 5};
     std::vector<int> filtered;
     std::copy_if(vec3.begin(), vec3.end(), std::back_inserter(filtered), [](int n) { return n % 2 == 0; });